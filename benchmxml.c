@@ -0,0 +1,233 @@
+/*
+ * Parallel loading benchmark for Mini-XML, a small XML file parsing library.
+ *
+ * Usage:
+ *
+ *   ./benchmxml [max-threads [elements [repeats]]]
+ *
+ * Generates a document with the given number of child elements under the
+ * root element and loads it from memory with mxmlLoadBuffer() and with
+ * mxmlLoadBufferParallel() using 1 to max-threads threads, reporting the
+ * best time of each and the speedup over a single thread.
+ *
+ * https://www.msweet.org/mxml
+ *
+ * Copyright © 2003-2019 by Michael R Sweet.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more
+ * information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "config.h"
+#include "mxml-private.h"
+#include <sys/time.h>
+#include <unistd.h>
+
+
+/*
+ * Local functions...
+ */
+
+static double	bench_load(const char *data, size_t len, int threads, int repeats);
+static char	*bench_make(int elements, size_t *len);
+static double	bench_time(void);
+
+
+/*
+ * 'main()' - Main entry for benchmark program.
+ */
+
+int					/* O - Exit status */
+main(int  argc,				/* I - Number of command-line args */
+     char *argv[])			/* I - Command-line args */
+{
+  int		threads,		/* Current number of threads */
+		max_threads,		/* Maximum number of threads */
+		elements,		/* Number of child elements */
+		repeats;		/* Number of loads per measurement */
+  char		*data;			/* Generated document */
+  size_t	len;			/* Length of document */
+  double	secs,			/* Best time for current load */
+		base;			/* Best time with one thread */
+
+
+ /*
+  * Get the options...
+  */
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if ((max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+#endif /* _SC_NPROCESSORS_ONLN */
+    max_threads = 4;
+
+  elements = 200000;
+  repeats  = 5;
+
+  if (argc > 1)
+    max_threads = atoi(argv[1]);
+  if (argc > 2)
+    elements = atoi(argv[2]);
+  if (argc > 3)
+    repeats = atoi(argv[3]);
+
+  if (argc > 4 || max_threads < 1 || elements < 1 || repeats < 1)
+  {
+    fputs("Usage: benchmxml [max-threads [elements [repeats]]]\n", stderr);
+    return (1);
+  }
+
+ /*
+  * Generate the document...
+  */
+
+  if ((data = bench_make(elements, &len)) == NULL)
+  {
+    fputs("benchmxml: Unable to allocate memory for document.\n", stderr);
+    return (1);
+  }
+
+  printf("Loading %d elements (%.1f MB), best of %d:\n", elements,
+         len / 1048576.0, repeats);
+
+ /*
+  * Time the sequential loader, then the parallel loader with 1 to
+  * max-threads threads...
+  */
+
+  if ((secs = bench_load(data, len, 0, repeats)) < 0.0)
+    goto error;
+
+  printf("  mxmlLoadBuffer:    %8.3f seconds %8.1f MB/s\n", secs,
+         len / 1048576.0 / secs);
+
+  for (threads = 1, base = 0.0; threads <= max_threads; threads ++)
+  {
+    if ((secs = bench_load(data, len, threads, repeats)) < 0.0)
+      goto error;
+
+    if (threads == 1)
+      base = secs;
+
+    printf("  %2d thread%s:        %8.3f seconds %8.1f MB/s %5.2fx\n",
+           threads, threads == 1 ? " " : "s", secs, len / 1048576.0 / secs,
+           base / secs);
+  }
+
+  free(data);
+
+  return (0);
+
+ /*
+  * Common error return point...
+  */
+
+  error:
+
+  fputs("benchmxml: Unable to load document.\n", stderr);
+  free(data);
+
+  return (1);
+}
+
+
+/*
+ * 'bench_load()' - Load a document several times and return the best time.
+ *
+ * A thread count of 0 uses mxmlLoadBuffer().
+ */
+
+static double				/* O - Best time in seconds or -1.0 on error */
+bench_load(const char *data,		/* I - Document */
+           size_t     len,		/* I - Length of document */
+           int        threads,		/* I - Number of threads or 0 */
+           int        repeats)		/* I - Number of loads */
+{
+  int		i;			/* Looping var */
+  mxml_node_t	*tree;			/* Loaded document */
+  double	start,			/* Start time */
+		secs,			/* Time for this load */
+		best;			/* Best time */
+
+
+  for (i = 0, best = -1.0; i < repeats; i ++)
+  {
+    start = bench_time();
+
+    if (threads)
+      tree = mxmlLoadBufferParallel(NULL, data, len, MXML_OPAQUE_CALLBACK, threads);
+    else
+      tree = mxmlLoadBuffer(NULL, data, len, MXML_OPAQUE_CALLBACK);
+
+    secs = bench_time() - start;
+
+    if (!tree)
+      return (-1.0);
+
+    mxmlDelete(tree);
+
+    if (best < 0.0 || secs < best)
+      best = secs;
+  }
+
+  return (best);
+}
+
+
+/*
+ * 'bench_make()' - Generate a document with the given number of elements.
+ */
+
+static char *				/* O - Document or NULL on error */
+bench_make(int    elements,		/* I - Number of child elements */
+           size_t *len)			/* O - Length of document */
+{
+  int		i;			/* Looping var */
+  char		*data,			/* Document */
+		*ptr;			/* Pointer into document */
+  size_t	size;			/* Size of document buffer */
+
+
+ /*
+  * Each record is less than 160 bytes...
+  */
+
+  size = 160 * (size_t)elements + 128;
+
+  if ((data = malloc(size)) == NULL)
+    return (NULL);
+
+  ptr = data;
+  ptr += snprintf(ptr, size, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<records>\n");
+
+  for (i = 0; i < elements; i ++)
+    ptr += snprintf(ptr, size - (size_t)(ptr - data),
+                    "<record id=\"%d\" type=\"%s\"><name>Record &amp; "
+                    "number %d</name><value>%d.%03d</value><!-- %d --></record>\n",
+                    i, (i & 1) ? "odd" : "even", i, i * 7, i % 1000, i);
+
+  ptr += snprintf(ptr, size - (size_t)(ptr - data), "</records>\n");
+
+  *len = (size_t)(ptr - data);
+
+  return (data);
+}
+
+
+/*
+ * 'bench_time()' - Return the current time in seconds.
+ */
+
+static double				/* O - Current time */
+bench_time(void)
+{
+  struct timeval	tv;		/* Current time */
+
+
+  gettimeofday(&tv, NULL);
+
+  return (tv.tv_sec + 0.000001 * tv.tv_usec);
+}
@@ -0,0 +1,145 @@
+/* config.h.  Generated from config.h.in by configure.  */
+/*
+ * Configuration file for Mini-XML, a small XML file parsing library.
+ *
+ * https://www.msweet.org/mxml
+ *
+ * Copyright © 2003-2019 by Michael R Sweet.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more
+ * information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+
+/*
+ * Version number...
+ */
+
+#define MXML_VERSION "Mini-XML v3.0"
+
+
+/*
+ * Inline function support...
+ */
+
+#define inline
+
+
+/*
+ * Long long support...
+ */
+
+#define HAVE_LONG_LONG 1
+
+
+/*
+ * Do we have the *printf() functions?
+ */
+
+#define HAVE_SNPRINTF 1
+#define HAVE_VASPRINTF 1
+#define HAVE_VSNPRINTF 1
+
+
+/*
+ * Do we have the strXXX() functions?
+ */
+
+#define HAVE_STRDUP 1
+/* #undef HAVE_STRLCAT */
+/* #undef HAVE_STRLCPY */
+
+
+/*
+ * Do we have memory-mapped file support?
+ */
+
+#define HAVE_MMAP 1
+
+
+/*
+ * Do we have C11 atomics?
+ */
+
+#define HAVE_STDATOMIC_H 1
+
+
+/*
+ * Do we have SSE2/AVX2 intrinsics and run-time CPU detection?
+ */
+
+#define HAVE_X86_SIMD 1
+
+
+/*
+ * Keep reference counts and user data in a side table to make nodes smaller?
+ */
+
+/* #undef MXML_COMPACT_NODES */
+
+
+/*
+ * Do we have zlib and/or Zstandard for compressed files?
+ */
+
+#define HAVE_LIBZ 1
+/* #undef HAVE_LIBZSTD */
+
+
+/*
+ * Do we have io_uring, POSIX AIO, and/or posix_fadvise for reading batches
+ * of files?
+ */
+
+/* #undef HAVE_LIBURING */
+#define HAVE_AIO_H 1
+#define HAVE_POSIX_FADVISE 1
+
+
+/*
+ * Do we have threading support?
+ */
+
+#define HAVE_PTHREAD_H 1
+
+
+/*
+ * Define prototypes for string functions as needed...
+ */
+
+#  ifndef HAVE_STRLCAT
+extern size_t	_mxml_strlcat(char *, const char *, size_t);
+#    define strlcat _mxml_strlcat
+#  endif /* !HAVE_STRLCAT */
+
+#  ifndef HAVE_STRLCPY
+extern size_t	_mxml_strlcpy(char *, const char *, size_t);
+#    define strlcpy _mxml_strlcpy
+#  endif /* !HAVE_STRLCPY */
+
+extern char	*_mxml_dtoa(double, char *, size_t);
+extern char	*_mxml_strdupf(const char *, ...);
+extern unsigned	_mxml_strhash(const char *);
+extern double	_mxml_strtod(const char *, char **);
+extern long long _mxml_strtoll(const char *, char **);
+extern char	*_mxml_vstrdupf(const char *, va_list);
+
+#  ifndef HAVE_SNPRINTF
+extern int	_mxml_snprintf(char *, size_t, const char *, ...);
+#    define snprintf _mxml_snprintf
+#  endif /* !HAVE_SNPRINTF */
+
+#  ifndef HAVE_VSNPRINTF
+extern int	_mxml_vsnprintf(char *, size_t, const char *, va_list);
+#    define vsnprintf _mxml_vsnprintf
+#  endif /* !HAVE_VSNPRINTF */
@@ -21,7 +21,11 @@
  * Local functions...
  */
 
-static int	mxml_set_attr(mxml_node_t *node, const char *name, char *value);
+static int	mxml_attr_capacity(int num_attrs);
+static int	mxml_grow_attrs(mxml_node_t *node, int alloc_attrs);
+static void	mxml_set_arena_attr(mxml_node_t *node, const char *name, const char *value);
+static int	mxml_set_attr(mxml_node_t *node, const char *name, char *value, int take);
+static int	mxml_set_strings(_mxml_attr_t *attr, const char *name, char *value, int take);
 
 
 /*
@@ -54,7 +58,7 @@ mxmlElementDeleteAttr(mxml_node_t *node,/* I - Element */
   * Look for the attribute...
   */
 
-  for (i = node->value.element.num_attrs, attr = node->value.element.attrs;
+  for (i = node->num_attrs, attr = node->value.element.attrs;
        i > 0;
        i --, attr ++)
   {
@@ -68,17 +72,21 @@ mxmlElementDeleteAttr(mxml_node_t *node,/* I - Element */
       * Delete this attribute...
       */
 
-      free(attr->name);
-      free(attr->value);
+      if (!(node->flags & _MXML_NODE_REF_ATTRS))
+	_mxml_free_attr(attr);
 
       i --;
       if (i > 0)
-        memmove(attr, attr + 1, i * sizeof(_mxml_attr_t));
+        memmove(attr, attr + 1, (size_t)i * sizeof(_mxml_attr_t));
 
-      node->value.element.num_attrs --;
+      node->num_attrs --;
 
-      if (node->value.element.num_attrs == 0)
-        free(node->value.element.attrs);
+      if (node->num_attrs == 0)
+      {
+        if (!node->arena || !(node->flags & _MXML_NODE_REF_ATTRS))
+          _mxml_free(node->value.element.attrs);
+        node->flags &= ~(_MXML_NODE_REF_ATTRS | _MXML_NODE_ATTRS_INTERNED);
+      }
       return;
     }
   }
@@ -116,7 +124,7 @@ mxmlElementGetAttr(mxml_node_t *node,	/* I - Element node */
   * Look for the attribute...
   */
 
-  for (i = node->value.element.num_attrs, attr = node->value.element.attrs;
+  for (i = node->num_attrs, attr = node->value.element.attrs;
        i > 0;
        i --, attr ++)
   {
@@ -124,7 +132,7 @@ mxmlElementGetAttr(mxml_node_t *node,	/* I - Element node */
     printf("    %s=\"%s\"\n", attr->name, attr->value);
 #endif /* DEBUG */
 
-    if (!strcmp(attr->name, name))
+    if (attr->name == name || !strcmp(attr->name, name))
     {
 #ifdef DEBUG
       printf("    Returning \"%s\"!\n", attr->value);
@@ -160,7 +168,7 @@ mxmlElementGetAttrByIndex(
     int         idx,                    /* I - Attribute index, starting at 0 */
     const char  **name)                 /* O - Attribute name */
 {
-  if (!node || node->type != MXML_ELEMENT || idx < 0 || idx >= node->value.element.num_attrs)
+  if (!node || node->type != MXML_ELEMENT || idx < 0 || idx >= node->num_attrs)
     return (NULL);
 
   if (name)
@@ -181,7 +189,7 @@ mxmlElementGetAttrCount(
     mxml_node_t *node)                  /* I - Node */
 {
   if (node && node->type == MXML_ELEMENT)
-    return (node->value.element.num_attrs);
+    return (node->num_attrs);
   else
     return (0);
 }
@@ -201,9 +209,6 @@ mxmlElementSetAttr(mxml_node_t *node,	/* I - Element node */
                    const char  *name,	/* I - Name of attribute */
                    const char  *value)	/* I - Attribute value */
 {
-  char	*valuec;			/* Copy of value */
-
-
 #ifdef DEBUG
   fprintf(stderr, "mxmlElementSetAttr(node=%p, name=\"%s\", value=\"%s\")\n",
           node, name ? name : "(null)", value ? value : "(null)");
@@ -216,13 +221,17 @@ mxmlElementSetAttr(mxml_node_t *node,	/* I - Element node */
   if (!node || node->type != MXML_ELEMENT || !name)
     return;
 
-  if (value)
-    valuec = strdup(value);
-  else
-    valuec = NULL;
+  if (node->arena && (!node->num_attrs || (node->flags & _MXML_NODE_REF_ATTRS)))
+  {
+   /*
+    * Elements in an arena borrow their attribute strings from the arena...
+    */
+
+    mxml_set_arena_attr(node, name, value);
+    return;
+  }
 
-  if (mxml_set_attr(node, name, valuec))
-    free(valuec);
+  mxml_set_attr(node, name, (char *)value, 0);
 }
 
 
@@ -269,77 +278,489 @@ mxmlElementSetAttrf(mxml_node_t *node,	/* I - Element node */
   va_end(ap);
 
   if (!value)
+  {
+    mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
+               name, node->value.element.name);
+  }
+  else if (node->arena && (!node->num_attrs || (node->flags & _MXML_NODE_REF_ATTRS)))
+  {
+    mxml_set_arena_attr(node, name, value);
+    _mxml_free(value);
+  }
+  else
+    mxml_set_attr(node, name, value, 1);
+}
+
+
+/*
+ * 'mxmlElementSetAttrs()' - Set several attributes at once.
+ *
+ * Each named attribute is set as with @link mxmlElementSetAttr@: existing
+ * attributes get the new value and other attributes are added in order.  The
+ * attribute array is grown with a single allocation for all of the new
+ * attributes.  When "values" is @code NULL@, the attributes have no value.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on failure */
+mxmlElementSetAttrs(
+    mxml_node_t       *node,		/* I - Element node */
+    const char * const *names,		/* I - Names of attributes */
+    const char * const *values,		/* I - Attribute values or @code NULL@ */
+    int               num_attrs)	/* I - Number of attributes */
+{
+  int		i, j;			/* Looping vars */
+  int		arena,			/* Borrow the strings from the arena? */
+		count;			/* Number of attributes */
+  _mxml_attr_t	*attr;			/* Current attribute */
+  const char	*value;			/* Attribute value */
+  _mxml_attr_t	temp;			/* New attribute strings */
+  char		*valuec;		/* Copy of value */
+
+
+ /*
+  * Range check input...
+  */
+
+  if (!node || node->type != MXML_ELEMENT || !names || num_attrs < 0)
+    return (-1);
+
+  for (i = 0; i < num_attrs; i ++)
+    if (!names[i])
+      return (-1);
+
+  if (!num_attrs)
+    return (0);
+
+ /*
+  * Make room for all of the attributes...
+  */
+
+  arena = node->arena && (!node->num_attrs || (node->flags & _MXML_NODE_REF_ATTRS));
+
+  if (!arena && _mxml_own_attrs(node))
+    return (-1);
+
+  count = node->num_attrs;
+
+  if (count + num_attrs > mxml_attr_capacity(count) &&
+      mxml_grow_attrs(node, mxml_attr_capacity(count + num_attrs)))
+  {
+    mxml_error("Unable to allocate memory for attributes in element %s!",
+               node->value.element.name);
+    return (-1);
+  }
+
+  if (arena)
+  {
+    if (!count)
+      node->flags |= _MXML_NODE_ATTRS_INTERNED;
+
+    node->flags |= _MXML_NODE_REF_ATTRS;
+  }
+
+ /*
+  * Then set or add each attribute...
+  */
+
+  for (i = 0; i < num_attrs; i ++)
+  {
+    value = values ? values[i] : NULL;
+
+    for (j = count, attr = node->value.element.attrs; j > 0; j --, attr ++)
+      if (!strcmp(attr->name, names[i]))
+        break;
+
+    if (arena)
+    {
+      if (value)
+      {
+        if ((valuec = _mxml_arena_strdup(node->arena, value)) == NULL)
+          goto error;
+      }
+      else
+        valuec = NULL;
+
+      if (!j && (attr->name = _mxml_arena_intern(node->arena, names[i])) == NULL)
+        goto error;
+
+      attr->value = valuec;
+    }
+    else
+    {
+      if (mxml_set_strings(&temp, names[i], (char *)value, 0))
+        goto error;
+
+      if (j)
+        _mxml_free_attr(attr);
+
+      *attr = temp;
+    }
+
+    if (!j)
+      node->num_attrs = ++ count;
+  }
+
+  return (0);
+
+ /*
+  * Common error return point...
+  */
+
+  error:
+
+  mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
+             names[i], node->value.element.name);
+
+  return (-1);
+}
+
+
+/*
+ * '_mxml_add_attr()' - Add an attribute name/value pair without copying.
+ *
+ * The name and value strings are stored as-is; the caller is responsible
+ * for setting the _MXML_NODE_REF_ATTRS flag if they are not allocated.
+ *
+ * The attribute array doubles in size when it is full.  Borrowed attributes
+ * of elements in an arena are stored in the arena, and their old array is not
+ * freed.
+ */
+
+int					/* O - 0 on success, -1 on failure */
+_mxml_add_attr(mxml_node_t *node,	/* I - Element node */
+               char        *name,	/* I - Attribute name */
+               char        *value)	/* I - Attribute value */
+{
+  _mxml_attr_t	*attr;			/* New attribute */
+
+
+  if (!(node->num_attrs & (node->num_attrs - 1)) &&
+      mxml_grow_attrs(node, node->num_attrs ? 2 * node->num_attrs : 1))
+  {
+    mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
+               name, node->value.element.name);
+    return (-1);
+  }
+
+  attr = node->value.element.attrs + node->num_attrs;
+
+  attr->name  = name;
+  attr->value = value;
+
+  node->num_attrs ++;
+
+  return (0);
+}
+
+
+/*
+ * '_mxml_free_attr()' - Free the strings of an attribute.
+ *
+ * Short values share the allocation of the name, see mxml_set_strings().
+ */
+
+void
+_mxml_free_attr(_mxml_attr_t *attr)	/* I - Attribute */
+{
+  if (attr->value && (!attr->name || attr->value != attr->name + strlen(attr->name) + 1))
+    _mxml_free(attr->value);
+
+  _mxml_free(attr->name);
+}
+
+
+/*
+ * '_mxml_own_attrs()' - Make allocated copies of borrowed attribute strings.
+ */
+
+int					/* O - 0 on success, -1 on failure */
+_mxml_own_attrs(mxml_node_t *node)	/* I - Element node */
+{
+  int		i;			/* Looping var */
+  _mxml_attr_t	*attrs;			/* Copied attributes */
+
+
+  if (!(node->flags & _MXML_NODE_REF_ATTRS))
+    return (0);
+
+  if ((attrs = _mxml_calloc((size_t)mxml_attr_capacity(node->num_attrs), sizeof(_mxml_attr_t))) == NULL)
+  {
+    mxml_error("Unable to allocate memory for attributes in element %s!",
+               node->value.element.name);
+    return (-1);
+  }
+
+  for (i = 0; i < node->num_attrs; i ++)
+  {
+    if (mxml_set_strings(attrs + i, node->value.element.attrs[i].name, node->value.element.attrs[i].value, 0))
+    {
+      mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
+		 node->value.element.attrs[i].name, node->value.element.name);
+
+      while (i > 0)
+        _mxml_free_attr(attrs + (-- i));
+
+      _mxml_free(attrs);
+
+      return (-1);
+    }
+  }
+
+  _mxml_free(node->value.element.attrs);
+
+  node->value.element.attrs = attrs;
+  node->flags               &= ~(_MXML_NODE_REF_ATTRS | _MXML_NODE_ATTRS_INTERNED);
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_attr_capacity()' - Get the allocated size of an attribute array.
+ *
+ * Attribute arrays are allocated in powers of 2, so an array is full when the
+ * number of attributes is 0 or a power of 2.
+ */
+
+static int				/* O - Allocated attributes */
+mxml_attr_capacity(int num_attrs)	/* I - Number of attributes */
+{
+  int	capacity;			/* Allocated attributes */
+
+
+  if (num_attrs <= 0)
+    return (0);
+
+  for (capacity = 1; capacity < num_attrs; capacity *= 2);
+
+  return (capacity);
+}
+
+
+/*
+ * 'mxml_grow_attrs()' - Move the attributes of an element to a larger array.
+ *
+ * Borrowed attributes of elements in an arena get an array in the arena, and
+ * their old array is not freed.
+ */
+
+static int				/* O - 0 on success, -1 on failure */
+mxml_grow_attrs(mxml_node_t *node,	/* I - Element node */
+                int         alloc_attrs)/* I - New size of array */
+{
+  int		arena;			/* Allocate the array in the arena? */
+  _mxml_attr_t	*attrs;			/* New attributes */
+
+
+  arena = node->arena && (!node->num_attrs || (node->flags & _MXML_NODE_REF_ATTRS));
+
+  if (!arena)
+    attrs = _mxml_realloc(node->num_attrs ? node->value.element.attrs : NULL, (size_t)alloc_attrs * sizeof(_mxml_attr_t));
+  else if ((attrs = _mxml_arena_alloc(node->arena, (size_t)alloc_attrs * sizeof(_mxml_attr_t), sizeof(char *))) != NULL && node->num_attrs)
+    memcpy(attrs, node->value.element.attrs, (size_t)node->num_attrs * sizeof(_mxml_attr_t));
+
+  if (!attrs)
+    return (-1);
+
+  node->value.element.attrs = attrs;
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_set_arena_attr()' - Set or add an attribute using arena strings.
+ *
+ * Attribute names are interned.  A replaced value stays in the arena until
+ * the arena is freed.
+ */
+
+static void
+mxml_set_arena_attr(mxml_node_t *node,	/* I - Element node */
+                    const char  *name,	/* I - Attribute name */
+                    const char  *value)	/* I - Attribute value */
+{
+  int		i;			/* Looping var */
+  _mxml_attr_t	*attr;			/* Current attribute */
+  char		*namec,			/* Copy of name */
+		*valuec;		/* Copy of value */
+
+
+  if (value)
+  {
+    if ((valuec = _mxml_arena_strdup(node->arena, value)) == NULL)
+    {
+      mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
+		 name, node->value.element.name);
+      return;
+    }
+  }
+  else
+    valuec = NULL;
+
+  for (i = node->num_attrs, attr = node->value.element.attrs;
+       i > 0;
+       i --, attr ++)
+    if (!strcmp(attr->name, name))
+    {
+      attr->value = valuec;
+      return;
+    }
+
+  if ((namec = _mxml_arena_intern(node->arena, name)) == NULL)
+  {
     mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
                name, node->value.element.name);
-  else if (mxml_set_attr(node, name, value))
-    free(value);
+    return;
+  }
+
+  if (!node->num_attrs)
+    node->flags |= _MXML_NODE_ATTRS_INTERNED;
+
+  if (!_mxml_add_attr(node, namec, valuec))
+    node->flags |= _MXML_NODE_REF_ATTRS;
 }
 
 
 /*
  * 'mxml_set_attr()' - Set or add an attribute name/value pair.
+ *
+ * When "take" is non-zero, the value was allocated and is freed or kept by
+ * the attribute.
  */
 
 static int				/* O - 0 on success, -1 on failure */
 mxml_set_attr(mxml_node_t *node,	/* I - Element node */
               const char  *name,	/* I - Attribute name */
-              char        *value)	/* I - Attribute value */
+              char        *value,	/* I - Attribute value */
+              int         take)		/* I - 1 to take the allocated value, 0 to copy it */
 {
   int		i;			/* Looping var */
-  _mxml_attr_t	*attr;			/* New attribute */
+  _mxml_attr_t	*attr,			/* Current attribute */
+		temp;			/* New attribute strings */
 
 
+ /*
+  * Copy any borrowed attribute strings before changing them...
+  */
+
+  if (_mxml_own_attrs(node))
+  {
+    if (take)
+      _mxml_free(value);
+
+    return (-1);
+  }
+
  /*
   * Look for the attribute...
   */
 
-  for (i = node->value.element.num_attrs, attr = node->value.element.attrs;
+  for (i = node->num_attrs, attr = node->value.element.attrs;
        i > 0;
        i --, attr ++)
     if (!strcmp(attr->name, name))
     {
      /*
-      * Free the old value as needed...
+      * Copy the new value before freeing the old one, which may be the same
+      * string...
       */
 
-      if (attr->value)
-        free(attr->value);
+      if (mxml_set_strings(&temp, attr->name, value, take))
+        return (-1);
 
-      attr->value = value;
+      _mxml_free_attr(attr);
+      *attr = temp;
 
       return (0);
     }
 
  /*
-  * Add a new attribute...
+  * Add a new attribute, copying the value before the array grows...
   */
 
-  if (node->value.element.num_attrs == 0)
-    attr = malloc(sizeof(_mxml_attr_t));
-  else
-    attr = realloc(node->value.element.attrs,
-                   (node->value.element.num_attrs + 1) * sizeof(_mxml_attr_t));
+  if (mxml_set_strings(&temp, name, value, take))
+    return (-1);
 
-  if (!attr)
+  if (_mxml_add_attr(node, temp.name, temp.value))
   {
-    mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
-               name, node->value.element.name);
+    _mxml_free_attr(&temp);
     return (-1);
   }
 
-  node->value.element.attrs = attr;
-  attr += node->value.element.num_attrs;
+  return (0);
+}
+
+
+/*
+ * 'mxml_set_strings()' - Copy the name and value of an attribute.
+ *
+ * Short values are stored after the name in the same allocation, so that
+ * they do not move when the attribute array grows.  Names with a separate
+ * value get a spare nul byte, so that a separate value can never start right
+ * after the name.  When "take" is non-zero, the value was allocated and is
+ * freed or kept by the attribute.  The old strings are not freed.
+ */
+
+static int				/* O - 0 on success, -1 on failure */
+mxml_set_strings(_mxml_attr_t *attr,	/* I - Attribute */
+                 const char   *name,	/* I - Attribute name */
+                 char         *value,	/* I - Attribute value */
+                 int          take)	/* I - 1 to take the allocated value, 0 to copy it */
+{
+  size_t	namelen = strlen(name) + 1,
+					/* Length of name with nul */
+		len = value ? strlen(value) + 1 : 0;
+					/* Length of value with nul */
+  char		*namec,			/* Copy of name */
+		*valuec;		/* Copy of value */
 
-  if ((attr->name = strdup(name)) == NULL)
+
+  if (len && len <= _MXML_INLINE_SIZE)
   {
-    mxml_error("Unable to allocate memory for attribute '%s' in element %s!",
-               name, node->value.element.name);
-    return (-1);
+    if ((namec = _mxml_malloc(namelen + len)) == NULL)
+      goto error;
+
+    valuec = memcpy(namec + namelen, value, len);
+
+    if (take)
+      _mxml_free(value);
   }
+  else
+  {
+    if ((namec = _mxml_malloc(namelen + 1)) == NULL)
+      goto error;
 
-  attr->value = value;
+    namec[namelen] = '\0';
+
+    if (!value || take)
+    {
+      valuec = value;
+    }
+    else if ((valuec = _mxml_strdup(value)) == NULL)
+    {
+      _mxml_free(namec);
+      goto error;
+    }
+  }
 
-  node->value.element.num_attrs ++;
+  attr->name  = memcpy(namec, name, namelen);
+  attr->value = valuec;
 
   return (0);
+
+ /*
+  * Common error return point...
+  */
+
+  error:
+
+  mxml_error("Unable to allocate memory for attribute '%s'.", name);
+
+  if (take)
+    _mxml_free(value);
+
+  return (-1);
 }
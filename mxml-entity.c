@@ -135,10 +135,6 @@ mxmlEntityRemoveCallback(
 int					/* O - Unicode value or -1 */
 _mxml_entity_cb(const char *name)	/* I - Entity name */
 {
-  int	diff,				/* Difference between names */
-	current,			/* Current entity in search */
-	first,				/* First entity in search */
-	last;				/* Last entity in search */
   static const struct
   {
     const char	*name;			/* Entity name */
@@ -404,35 +400,78 @@ _mxml_entity_cb(const char *name)	/* I - Entity name */
     { "zwnj",		8204 }
   };
 
-
  /*
-  * Do a binary search for the named entity...
+  * The disp and slots tables are generated from the entities array.  After
+  * adding or removing entities, regenerate them by running the following
+  * command from the source directory:
+  *
+  *   python3 tools/entity-hash.py mxml-entity.c
   */
 
-  first = 0;
-  last  = (int)(sizeof(entities) / sizeof(entities[0]) - 1);
-
-  while ((last - first) > 1)
+  static const unsigned char disp[128] =
+					/* Displacement for each hash bucket */
   {
-    current = (first + last) / 2;
-
-    if ((diff = strcmp(name, entities[current].name)) == 0)
-      return (entities[current].val);
-    else if (diff < 0)
-      last = current;
-    else
-      first = current;
-  }
+    0, 0, 0, 0, 2, 1, 0, 0, 0, 1, 0, 1, 3, 0, 1, 1,
+    2, 0, 0, 2, 5, 0, 1, 0, 0, 2, 0, 0, 1, 0, 1, 0,
+    0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 1, 4, 0, 0, 1, 0,
+    1, 3, 10, 9, 1, 0, 0, 5, 0, 0, 0, 1, 0, 0, 1, 0,
+    1, 0, 3, 2, 2, 1, 3, 2, 0, 1, 0, 0, 16, 3, 1, 0,
+    4, 0, 0, 2, 0, 2, 0, 0, 0, 0, 1, 1, 0, 3, 0, 1,
+    0, 0, 0, 0, 0, 1, 4, 2, 2, 2, 2, 0, 0, 0, 1, 0,
+    2, 0, 2, 1, 3, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0
+  };
+  static const unsigned short slots[512] =
+					/* Entity index + 1 for each hash slot */
+  {
+    0, 0, 71, 169, 0, 0, 0, 206, 0, 0, 119, 136, 249, 0, 0, 0,
+    8, 0, 0, 0, 0, 0, 0, 0, 173, 0, 0, 201, 0, 0, 0, 219,
+    12, 0, 160, 197, 0, 110, 131, 0, 120, 0, 0, 195, 0, 162, 199, 143,
+    188, 0, 22, 14, 186, 49, 0, 0, 0, 226, 0, 113, 0, 0, 0, 0,
+    0, 200, 109, 27, 125, 11, 0, 238, 254, 0, 0, 231, 220, 17, 0, 15,
+    221, 255, 0, 0, 0, 179, 44, 0, 0, 0, 43, 180, 137, 53, 0, 37,
+    0, 253, 168, 33, 140, 196, 0, 247, 101, 91, 185, 132, 181, 246, 0, 0,
+    184, 187, 223, 129, 0, 225, 102, 0, 142, 0, 0, 159, 0, 0, 0, 124,
+    10, 0, 0, 0, 0, 252, 0, 0, 0, 189, 114, 146, 0, 232, 0, 0,
+    0, 170, 88, 0, 0, 0, 46, 0, 0, 191, 0, 0, 163, 0, 0, 0,
+    0, 0, 0, 167, 0, 157, 0, 0, 156, 0, 86, 0, 81, 151, 216, 0,
+    0, 0, 0, 153, 0, 0, 0, 0, 194, 211, 82, 0, 52, 24, 107, 0,
+    164, 103, 116, 0, 2, 51, 100, 150, 117, 0, 0, 0, 243, 165, 251, 241,
+    182, 0, 0, 0, 0, 209, 73, 230, 21, 256, 224, 121, 240, 108, 148, 67,
+    135, 16, 50, 222, 5, 141, 0, 0, 177, 74, 60, 72, 0, 0, 0, 0,
+    257, 0, 83, 0, 193, 0, 0, 0, 97, 9, 0, 55, 134, 61, 0, 0,
+    96, 84, 64, 0, 0, 0, 178, 0, 115, 0, 122, 208, 0, 0, 0, 0,
+    0, 175, 204, 0, 0, 85, 1, 0, 202, 0, 95, 0, 0, 0, 0, 0,
+    0, 0, 236, 0, 0, 0, 0, 0, 0, 0, 32, 0, 0, 99, 0, 0,
+    0, 0, 0, 144, 38, 35, 68, 6, 65, 166, 0, 18, 127, 0, 0, 0,
+    0, 0, 105, 0, 248, 0, 0, 0, 0, 92, 149, 0, 0, 212, 0, 4,
+    90, 0, 0, 0, 0, 36, 42, 190, 0, 0, 98, 126, 87, 0, 0, 0,
+    0, 0, 0, 207, 0, 0, 210, 0, 0, 57, 203, 20, 0, 174, 34, 0,
+    0, 112, 198, 45, 0, 0, 56, 26, 59, 75, 244, 54, 176, 130, 104, 161,
+    0, 205, 0, 172, 70, 47, 171, 69, 0, 0, 0, 0, 0, 0, 40, 0,
+    0, 0, 0, 0, 0, 0, 242, 76, 145, 106, 0, 48, 250, 0, 0, 66,
+    0, 147, 0, 63, 0, 0, 94, 0, 0, 138, 111, 0, 133, 0, 0, 19,
+    123, 25, 0, 0, 155, 218, 23, 0, 0, 0, 0, 0, 0, 0, 215, 0,
+    0, 0, 152, 0, 0, 62, 39, 183, 0, 237, 3, 77, 31, 28, 80, 118,
+    213, 192, 58, 41, 158, 154, 89, 217, 29, 78, 0, 0, 7, 239, 0, 0,
+    229, 234, 214, 228, 0, 30, 0, 227, 233, 79, 0, 0, 93, 0, 0, 128,
+    0, 235, 0, 0, 245, 0, 139, 0, 0, 0, 0, 0, 0, 13, 0, 0
+  };
+  const char	*ptr;			/* Pointer into name */
+  unsigned	hash = 2166136261U;	/* FNV-1a hash of name */
+  int		index;			/* Entity index + 1 */
+
 
  /*
-  * If we get here, there is a small chance that there is still
-  * a match; check first and last...
+  * Look up the name using a perfect hash: the low 7 bits of the FNV-1a hash
+  * select a bucket, and the rest of the hash plus the bucket's displacement
+  * selects a slot that only one of the entity names maps to...
   */
 
-  if (!strcmp(name, entities[first].name))
-    return (entities[first].val);
-  else if (!strcmp(name, entities[last].name))
-    return (entities[last].val);
+  for (ptr = name; *ptr; ptr ++)
+    hash = (hash ^ (unsigned char)*ptr) * 16777619U;
+
+  if ((index = slots[((hash >> 7) + disp[hash & 127]) & 511]) > 0 && !strcmp(name, entities[index - 1].name))
+    return (entities[index - 1].val);
   else
     return (-1);
 }
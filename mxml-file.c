@@ -17,6 +17,32 @@
 #  include <unistd.h>
 #endif /* !_WIN32 */
 #include "mxml-private.h"
+#include <fcntl.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif /* HAVE_MMAP */
+#ifdef HAVE_X86_SIMD
+#  include <immintrin.h>
+#endif /* HAVE_X86_SIMD */
+#ifdef HAVE_PTHREAD_H
+#  include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_LIBZ
+#  include <zlib.h>
+#endif /* HAVE_LIBZ */
+#ifdef HAVE_LIBZSTD
+#  include <zstd.h>
+#endif /* HAVE_LIBZSTD */
+#ifdef HAVE_LIBURING
+#  include <liburing.h>
+#elif defined(HAVE_AIO_H)
+#  include <aio.h>
+#endif /* HAVE_LIBURING */
+#if defined(HAVE_LIBURING) || defined(HAVE_AIO_H) || defined(HAVE_POSIX_FADVISE)
+#  include <sys/stat.h>
+#  define MXML_BATCH_READAHEAD 1
+#endif /* HAVE_LIBURING || HAVE_AIO_H || HAVE_POSIX_FADVISE */
 
 
 /*
@@ -28,6 +54,31 @@
 #define ENCODE_UTF16LE	2		/* UTF-16 Little-Endian */
 
 
+/*
+ * Number of files each batch worker reads ahead, and the largest file that
+ * is read into memory rather than mapped...
+ */
+
+#define MXML_BATCH_DEPTH 8
+#define MXML_BATCH_MAX	(4 * 1024 * 1024)
+
+
+/*
+ * Offset of UTF-16 data read into the input buffer for conversion.  UTF-8
+ * is at most 1.5 times as long as UTF-16, so with a third of the buffer as
+ * headroom a whole block converts without overwriting unread input...
+ */
+
+#define MXML_UTF16_OFFSET 2752
+
+
+/*
+ * Maximum number of bytes to check for valid UTF-8 at a time...
+ */
+
+#define MXML_VALID_MAX	16384
+
+
 /*
  * Macro to test for a bad XML character...
  */
@@ -35,46 +86,630 @@
 #define mxml_bad_char(ch) ((ch) < ' ' && (ch) != '\n' && (ch) != '\r' && (ch) != '\t')
 
 
+/*
+ * Windows needs binary mode to read UTF-16 files...
+ */
+
+#ifndef O_BINARY
+#  define O_BINARY 0
+#endif /* !O_BINARY */
+
+
+/*
+ * Bulk scanning contexts...
+ */
+
+#define MXML_SCAN_TEXT		0x01	/* Whitespace-delimited data */
+#define MXML_SCAN_OPAQUE	0x02	/* Opaque data */
+#define MXML_SCAN_NAME		0x04	/* Element name */
+#define MXML_SCAN_ATTR		0x08	/* Attribute name */
+#define MXML_SCAN_VALUE		0x10	/* Quoted attribute value */
+#define MXML_SCAN_MARKUP	0x20	/* Comment, CDATA, or directive */
+#define MXML_SCAN_MAX		6	/* Number of scanning contexts */
+
+
+/*
+ * Offset of a missing pull reader string...
+ */
+
+#define MXML_NO_OFFSET		((size_t)-1)
+
+
+/*
+ * Parallel loading limits...
+ */
+
+#define MXML_SEGMENT_MIN	65536	/* Minimum bytes per segment */
+#define MXML_SEGMENTS_PER_THREAD 4	/* Segments per thread for load balancing */
+
+
 /*
  * Types and structures...
  */
 
-typedef int (*_mxml_getc_cb_t)(void *, int *);
 typedef int (*_mxml_putc_cb_t)(int, void *);
+typedef int (*_mxml_read_cb_t)(void *, void *, size_t);
+
+typedef struct _mxml_zstream_s		/**** Compressed stream ****/
+{
+  mxml_compress_t	format;		/* Compression format */
+  int			compress;	/* 1 to compress, 0 to decompress */
+  _mxml_read_cb_t	read_cb;	/* Read callback for compressed input */
+  void			*read_data;	/* Read callback data */
+  int			eof,		/* Non-zero at the end of compressed input */
+			member_end;	/* Non-zero at the end of a gzip member */
+#ifdef HAVE_LIBZ
+  z_stream		zs;		/* zlib stream */
+#endif /* HAVE_LIBZ */
+#ifdef HAVE_LIBZSTD
+  ZSTD_CCtx		*cctx;		/* Zstandard compression context */
+  ZSTD_DCtx		*dctx;		/* Zstandard decompression context */
+  size_t		zret;		/* Last Zstandard decompression status */
+#endif /* HAVE_LIBZSTD */
+  unsigned char		*current,	/* Current position in buffer */
+			*end,		/* End of buffer */
+			buffer[8192];	/* Compressed data buffer */
+} _mxml_zstream_t;
 
 typedef struct _mxml_fdbuf_s		/**** File descriptor buffer ****/
 {
   int		fd;			/* File descriptor */
+  FILE		*fp;			/* File or NULL to write to the file descriptor */
+  _mxml_zstream_t *z;			/* Compressed stream or NULL */
   unsigned char	*current,		/* Current position in buffer */
 		*end,			/* End of buffer */
 		buffer[8192];		/* Character buffer */
 } _mxml_fdbuf_t;
 
+typedef struct _mxml_read_s		/**** Input buffer ****/
+{
+  _mxml_read_cb_t	read_cb;	/* Read callback or NULL for a fixed buffer */
+  void			*read_data;	/* Read callback data */
+  int			encoding;	/* Character encoding */
+  int			string;		/* Nul-terminated string? */
+  unsigned char		*inplace;	/* Write position for in-place strings or NULL */
+  int			error;		/* Non-zero if the input is bad */
+  int			incomplete;	/* Non-zero if more input may follow */
+  int			*line;		/* Current line number for errors or NULL */
+  mxml_node_t		**parent;	/* Current parent node for errors or NULL */
+  int			transcode;	/* UTF-16 encoding being converted to UTF-8 or 0 */
+  int			detect;		/* Non-zero to check for compressed input on the first read */
+  _mxml_zstream_t	*z;		/* Decompression state or NULL */
+  const unsigned char	*current,	/* Current position in buffer */
+			*end,		/* End of buffer */
+			*src,		/* Start of unconverted UTF-16 input */
+			*srcend,	/* End of unconverted UTF-16 input */
+			*valid;		/* End of checked UTF-8 input */
+  unsigned char		buffer[8192];	/* Character buffer */
+} _mxml_read_t;
+
+typedef struct _mxml_segment_s		/**** Parallel load segment ****/
+{
+  const unsigned char	*start,		/* Start of segment */
+			*end;		/* End of segment */
+  mxml_node_t		*tree;		/* Copy of root element with loaded children or NULL on error */
+  int			lines;		/* Number of newlines in segment */
+} _mxml_segment_t;
+
+#ifdef HAVE_PTHREAD_H
+typedef struct _mxml_pload_s		/**** Parallel load state ****/
+{
+  mxml_node_t		*root;		/* Root element */
+  mxml_load_cb_t	cb;		/* Load callback */
+  _mxml_global_t	global;		/* Global data for workers */
+  _mxml_segment_t	*segments;	/* Segments */
+  int			num_segments,	/* Number of segments */
+			next_segment;	/* Next segment to load */
+  pthread_mutex_t	mutex;		/* Mutex for next segment */
+} _mxml_pload_t;
+#endif /* HAVE_PTHREAD_H */
+
+typedef struct _mxml_batch_s		/**** Batch load state ****/
+{
+  const char * const	*filenames;	/* Files to load */
+  int			num_files,	/* Number of files */
+			next_file;	/* Next file to load */
+  mxml_load_cb_t	cb;		/* Load callback */
+  mxml_node_t		**trees;	/* Loaded trees */
+  char			**errors;	/* Error messages or NULL */
+  _mxml_global_t	global;		/* Global data for workers */
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t	mutex;		/* Mutex for next file */
+#endif /* HAVE_PTHREAD_H */
+} _mxml_batch_t;
+
+#ifdef MXML_BATCH_READAHEAD
+typedef struct _mxml_bfile_s		/**** Batch file being read ahead ****/
+{
+  int			file,		/* Index of file in batch */
+			fd,		/* File descriptor or -1 */
+			pending;	/* Read in progress? */
+  unsigned char		*data;		/* File data or NULL to load from descriptor */
+  size_t		length;		/* Length of file */
+  ssize_t		bytes;		/* Bytes read or -1 on error */
+#  if !defined(HAVE_LIBURING) && defined(HAVE_AIO_H)
+  struct aiocb		aio;		/* Asynchronous read */
+#  endif /* !HAVE_LIBURING && HAVE_AIO_H */
+} _mxml_bfile_t;
+
+typedef struct _mxml_bqueue_s		/**** Batch read-ahead queue ****/
+{
+  _mxml_bfile_t		files[MXML_BATCH_DEPTH];
+					/* Files being read */
+  int			first,		/* First file in queue */
+			count,		/* Number of files in queue */
+			async;		/* Can files be read asynchronously? */
+#  ifdef HAVE_LIBURING
+  struct io_uring	ring;		/* Submission and completion queues */
+#  endif /* HAVE_LIBURING */
+} _mxml_bqueue_t;
+#endif /* MXML_BATCH_READAHEAD */
+
+typedef struct _mxml_records_s		/**** Record loading state ****/
+{
+  const char		*name;		/* Record element name */
+  mxml_record_cb_t	cb;		/* Record callback */
+  void			*data;		/* Record callback data */
+  int			depth,		/* Depth inside current record, 0 if none */
+			count;		/* Number of records */
+} _mxml_records_t;
+
+typedef struct _mxml_views_s		/**** SAX view buffers ****/
+{
+  mxml_sax_view_cb_t	cb;		/* SAX view callback */
+  void			*data;		/* SAX view callback data */
+  mxml_node_t		node,		/* Node for data and other markup */
+			*elements;	/* Element nodes, one per depth */
+  size_t		textlen;	/* Length of data text */
+  char			*strings;	/* Open element names and attributes */
+  size_t		strsize,	/* Size of string buffer */
+			strused;	/* Bytes used in string buffer */
+  _mxml_attr_t		*attrs;		/* Attributes of current element */
+  const char		**pairs;	/* Attribute name/value pairs for callback */
+  int			alloc_attrs;	/* Allocated attributes */
+} _mxml_views_t;
+
+typedef struct _mxml_load_s		/**** Load state ****/
+{
+  mxml_node_t		*top,		/* Top node */
+			*first,		/* First node added */
+			*parent;	/* Current parent node */
+  mxml_load_cb_t	cb;		/* Load callback */
+  mxml_sax_cb_t		sax_cb;		/* SAX callback */
+  void			*sax_data;	/* SAX user data */
+  mxml_type_t		type;		/* Current node type */
+  int			line,		/* Current line number */
+			whitespace,	/* Non-zero if whitespace seen */
+			pause;		/* Non-zero to stop after the current token */
+  char			*buffer,	/* String buffer */
+			*bufptr;	/* Pointer into buffer */
+  int			bufsize;	/* Size of buffer */
+  char			*name,		/* Attribute name buffer */
+			*value;		/* Attribute value buffer */
+  int			namesize,	/* Size of name buffer */
+			valsize;	/* Size of value buffer */
+  char			*attrs;		/* Attribute names and values of current element */
+  size_t		attrsize,	/* Size of attribute buffer */
+			attrused;	/* Bytes used in attribute buffer */
+  const char		**pairs;	/* Attribute names, then values at alloc_attrs */
+  int			num_attrs,	/* Number of attributes in buffer */
+			alloc_attrs;	/* Allocated attribute names and values */
+  int			keep;		/* Non-zero to keep the buffers for another load */
+  _mxml_views_t		*views;		/* SAX view buffers or NULL */
+  mxml_typemap_t	*typemap;	/* Element type map or NULL */
+  int			arena;		/* Non-zero to load each document into an arena */
+} _mxml_load_t;
+
+struct _mxml_loader_s			/**** Reusable XML loader ****/
+{
+  _mxml_load_t		load;		/* Load state and string buffers */
+  _mxml_read_t		in;		/* Input buffer */
+};
+
+typedef struct _mxml_typeent_s		/**** Element type map entry ****/
+{
+  char			*name;		/* Element name or attribute value, NULL if unused */
+  unsigned		hash;		/* Hash of name */
+  mxml_type_t		type;		/* Child value type */
+} _mxml_typeent_t;
+
+struct _mxml_typemap_s			/**** Element type map ****/
+{
+  char			*attr;		/* Attribute that selects the type or NULL */
+  int			num_entries,	/* Number of entries */
+			alloc_entries;	/* Allocated entries (power of 2) */
+  _mxml_typeent_t	*entries;	/* Hash table */
+};
+
+struct _mxml_parser_s			/**** XML push parser ****/
+{
+  int			status;		/* 0 while loading, 1 when finished, -1 on error */
+  _mxml_load_t		load;		/* Load state */
+  _mxml_read_t		in;		/* Input buffer */
+  unsigned char		*data;		/* Buffered input data */
+  size_t		datasize,	/* Size of data buffer */
+			pending;	/* Unread bytes at the last partial token */
+  mxml_node_t		*tree;		/* Loaded tree */
+};
+
+typedef struct _mxml_event_s		/**** Pull reader event ****/
+{
+  mxml_reader_event_t	event;		/* Event type */
+  int			depth,		/* Element depth */
+			first_attr,	/* First attribute */
+			num_attrs;	/* Number of attributes */
+  size_t		name,		/* Offset of name string */
+			text;		/* Offset of text string */
+} _mxml_event_t;
+
+typedef struct _mxml_rattr_s		/**** Pull reader attribute ****/
+{
+  size_t		name,		/* Offset of name string */
+			value;		/* Offset of value string or MXML_NO_OFFSET */
+} _mxml_rattr_t;
+
+struct _mxml_reader_s			/**** XML pull reader ****/
+{
+  int			status,		/* 0 while loading, 1 at end of document, -1 on error */
+			error;		/* Non-zero if an event could not be recorded */
+  _mxml_load_t		load;		/* Load state */
+  _mxml_views_t		views;		/* SAX view buffers */
+  _mxml_read_t		in;		/* Input buffer */
+  int			depth,		/* Current element depth */
+			num_events,	/* Number of events from the last token */
+			cur_event;	/* Current event */
+  _mxml_event_t		events[4];	/* Events from the last token */
+  char			*strings;	/* Event strings */
+  size_t		strsize,	/* Size of string buffer */
+			strused;	/* Bytes used in string buffer */
+  _mxml_rattr_t		*attrs;		/* Event attributes */
+  int			num_attrs,	/* Number of attributes */
+			alloc_attrs;	/* Allocated attributes */
+  int			fd;		/* File descriptor */
+};
+
+
+#ifdef HAVE_X86_SIMD
+typedef struct _mxml_simd_s		/**** Vector scanning parameters ****/
+{
+  char		lo,			/* Lowest plain character */
+		extra[3],		/* Plain characters below lo */
+		stop[3];		/* Stop characters at or above lo */
+} _mxml_simd_t;
+#endif /* HAVE_X86_SIMD */
+
+
+/*
+ * Local globals...
+ */
+
+static const unsigned char mxml_scan_chars[256] =
+{					/* Characters that can be copied in bulk */
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x32, 0x00, 0x00, 0x32, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x32, 0x33, 0x23, 0x33, 0x33, 0x33, 0x00, 0x23, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3f, 0x3f, 0x33,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x38, 0x37, 0x13, 0x37,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,
+  0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f
+					/* Non-ASCII always uses mxml_read_char() */
+};
+#ifdef HAVE_X86_SIMD
+static const _mxml_simd_t mxml_scan_simd[MXML_SCAN_MAX] =
+{					/* Vector versions of mxml_scan_chars */
+  { 0x21, { 0x21, 0x21, 0x21 }, { '<', '&', '&' } },
+					/* MXML_SCAN_TEXT */
+  { 0x20, { '\t', '\n', '\r' }, { '<', '&', '&' } },
+					/* MXML_SCAN_OPAQUE */
+  { '0', { '-', '.', '.' }, { '<', '>', '>' } },
+					/* MXML_SCAN_NAME */
+  { '0', { '-', '.', '.' }, { '=', '>', '?' } },
+					/* MXML_SCAN_ATTR */
+  { 0x20, { '\t', '\n', '\r' }, { '\"', '\'', '&' } },
+					/* MXML_SCAN_VALUE */
+  { 0x20, { '\t', '\n', '\r' }, { '>', '&', '&' } }
+					/* MXML_SCAN_MARKUP */
+};
+#endif /* HAVE_X86_SIMD */
+
 
 /*
  * Local functions...
  */
 
+static int		mxml_add_bytes(const unsigned char *s, size_t len, char **bufptr, char **buffer, int *bufsize);
 static int		mxml_add_char(int ch, char **ptr, char **buffer, int *bufsize);
-static int		mxml_fd_getc(void *p, int *encoding);
+static int		mxml_add_run(_mxml_read_t *in, int scan, char **bufptr, char **buffer, int *bufsize, int *line);
+static mxml_compress_t	mxml_compressed(const unsigned char *data, size_t len);
+static int		mxml_fd_finish(_mxml_fdbuf_t *buf);
+static int		mxml_fd_output(_mxml_fdbuf_t *buf, const unsigned char *data, size_t len);
 static int		mxml_fd_putc(int ch, void *p);
-static int		mxml_fd_read(_mxml_fdbuf_t *buf);
+static int		mxml_fd_read(void *p, void *buffer, size_t bytes);
 static int		mxml_fd_write(_mxml_fdbuf_t *buf);
-static int		mxml_file_getc(void *p, int *encoding);
 static int		mxml_file_putc(int ch, void *p);
-static int		mxml_get_entity(mxml_node_t *parent, void *p, int *encoding, _mxml_getc_cb_t getc_cb, int *line);
+static int		mxml_file_read(void *p, void *buffer, size_t bytes);
+#ifdef HAVE_PTHREAD_H
+static void		mxml_ignore_error(const char *message);
+#endif /* HAVE_PTHREAD_H */
+static int		mxml_get_entity(mxml_node_t *parent, _mxml_read_t *in, int *line);
+static int		mxml_has_attr(_mxml_load_t *st, mxml_node_t *node, const char *name);
+static int		mxml_read_char(_mxml_read_t *in);
+static int		mxml_read_control(_mxml_read_t *in, int ch);
+static inline int	mxml_getc(_mxml_read_t *in)
+			{
+			  if (in->current < in->end && *(in->current) >= ' ' && *(in->current) < 0x80 && in->encoding == ENCODE_UTF8)
+			    return (*(in->current)++);
+			  else
+			    return (mxml_read_char(in));
+			}
 static inline int	mxml_isspace(int ch)
 			{
 			  return (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n');
 			}
-static mxml_node_t	*mxml_load_data(mxml_node_t *top, void *p, mxml_load_cb_t cb, _mxml_getc_cb_t getc_cb, mxml_sax_cb_t sax_cb, void *sax_data);
-static int		mxml_parse_element(mxml_node_t *node, void *p, int *encoding, _mxml_getc_cb_t getc_cb, int *line);
-static int		mxml_string_getc(void *p, int *encoding);
+static void		mxml_batch_error(const char *message);
+static int		mxml_batch_next(_mxml_batch_t *batch);
+#ifdef MXML_BATCH_READAHEAD
+static void		mxml_batch_start(_mxml_batch_t *batch, _mxml_bqueue_t *q);
+static void		mxml_batch_wait(_mxml_bqueue_t *q, _mxml_bfile_t *bf);
+#endif /* MXML_BATCH_READAHEAD */
+static void		*mxml_batch_worker(void *data);
+static mxml_node_t	*mxml_load_data(_mxml_load_t *st, mxml_node_t *top, _mxml_read_t *in, mxml_load_cb_t cb, mxml_sax_cb_t sax_cb, void *sax_data);
+static int		mxml_load_event(_mxml_load_t *st, mxml_node_t *node, mxml_sax_event_t event);
+static void		mxml_load_free(_mxml_load_t *st);
+static int		mxml_load_init(_mxml_load_t *st, mxml_node_t *top, mxml_load_cb_t cb, mxml_sax_cb_t sax_cb, void *sax_data);
+static int		mxml_load_more(_mxml_load_t *st, _mxml_read_t *in, mxml_node_t **tree);
+static mxml_node_t	*mxml_load_parallel(mxml_node_t *top, const void *data, size_t len, mxml_load_cb_t cb, int threads);
+static int		mxml_load_reset(_mxml_load_t *st, mxml_node_t *top, mxml_load_cb_t cb, mxml_sax_cb_t sax_cb, void *sax_data);
+static int		mxml_load_records(_mxml_read_t *in, const char *name, mxml_load_cb_t cb, mxml_record_cb_t record_cb, void *record_data);
+static mxml_node_t	*mxml_load_opened(_mxml_load_t *st, mxml_node_t *top, int fd, mxml_load_cb_t cb, mxml_sax_cb_t sax_cb, void *sax_data, int threads);
+static mxml_node_t	*mxml_load_path(_mxml_load_t *st, mxml_node_t *top, const char *filename, mxml_load_cb_t cb, mxml_sax_cb_t sax_cb, void *sax_data, int threads);
+#ifdef HAVE_PTHREAD_H
+static void		mxml_load_segment(_mxml_pload_t *pl, _mxml_segment_t *segment);
+#endif /* HAVE_PTHREAD_H */
+static int		mxml_load_split(const unsigned char *data, size_t len, size_t chunk, const unsigned char **content, _mxml_segment_t **segments);
+#ifdef HAVE_PTHREAD_H
+static void		*mxml_load_worker(void *data);
+#endif /* HAVE_PTHREAD_H */
+static inline mxml_type_t mxml_load_type(_mxml_load_t *st, mxml_node_t *node);
+static int		mxml_load_views(_mxml_read_t *in, mxml_sax_view_cb_t cb, void *cb_data);
+static int		mxml_new_attr(_mxml_load_t *st, _mxml_read_t *in, mxml_node_t *node, const char *name, const char *value);
+static int		mxml_new_attrs(_mxml_load_t *st, mxml_node_t *node);
+static mxml_node_t	*mxml_new_element(_mxml_load_t *st, _mxml_read_t *in, mxml_node_t *parent, const char *name);
+static mxml_node_t	*mxml_new_string(_mxml_load_t *st, _mxml_read_t *in, mxml_node_t *parent, mxml_type_t type, int whitespace, const char *s);
+static int		mxml_parse_element(_mxml_load_t *st, mxml_node_t *node, _mxml_read_t *in, int *line);
+static int		mxml_read_bad(_mxml_read_t *in, int lead);
+static void		mxml_read_buffer(_mxml_read_t *in, const void *data, size_t len);
+static int		mxml_read_byte(_mxml_read_t *in);
+static int		mxml_read_detect(_mxml_read_t *in);
+static void		mxml_read_free(_mxml_read_t *in);
+static void		mxml_read_init(_mxml_read_t *in, _mxml_read_cb_t read_cb, void *read_data);
+static char		*mxml_read_inplace(_mxml_read_t *in, const char *s);
+static int		mxml_read_partial(_mxml_read_t *in);
+static void		mxml_records_sax_cb(mxml_node_t *node, mxml_sax_event_t event, void *data);
+static void		mxml_read_string(_mxml_read_t *in, const char *s);
+static int		mxml_read_unit(_mxml_read_t *in, const unsigned char **ptr);
+static int		mxml_read_utf16(_mxml_read_t *in);
+static const unsigned char *mxml_read_valid(_mxml_read_t *in, const unsigned char *ptr);
+static mxml_reader_t	*mxml_reader_new(void);
+static size_t		mxml_reader_string(mxml_reader_t *reader, const char *s);
+static void		mxml_reader_view_cb(mxml_sax_event_t sax_event, const char *name, const char * const *attrs, const char *text, size_t textlen, void *data);
+static int		mxml_save_fd(mxml_node_t *node, int fd, FILE *fp, mxml_save_cb_t cb);
+static const unsigned char *mxml_scan(const unsigned char *ptr, const unsigned char *end, int scan, int *line);
+#ifdef HAVE_X86_SIMD
+static const unsigned char *mxml_scan_avx2(const unsigned char *ptr, const unsigned char *end, const _mxml_simd_t *simd, int *line) __attribute__((target("avx2")));
+static const unsigned char *mxml_scan_sse2(const unsigned char *ptr, const unsigned char *end, const _mxml_simd_t *simd, int *line);
+#endif /* HAVE_X86_SIMD */
+static const unsigned char *mxml_skip_markup(const unsigned char *ptr, const unsigned char *end, int *depth, int *element);
 static int		mxml_string_putc(int ch, void *p);
+static const unsigned char *mxml_validate(const unsigned char *ptr, const unsigned char *end);
+#ifdef HAVE_X86_SIMD
+static const unsigned char *mxml_validate_avx2(const unsigned char *ptr, const unsigned char *end) __attribute__((target("avx2")));
+#endif /* HAVE_X86_SIMD */
+static void		mxml_views_free(_mxml_views_t *views);
+static void		mxml_views_init(_mxml_views_t *views, mxml_sax_view_cb_t cb, void *cb_data);
+static int		mxml_views_reserve(_mxml_views_t *views, mxml_node_t *node, size_t bytes);
 static int		mxml_write_name(const char *s, void *p, _mxml_putc_cb_t putc_cb);
 static int		mxml_write_node(mxml_node_t *node, void *p, mxml_save_cb_t cb, int col, _mxml_putc_cb_t putc_cb, _mxml_global_t *global);
 static int		mxml_write_string(const char *s, void *p, _mxml_putc_cb_t putc_cb);
 static int		mxml_write_ws(mxml_node_t *node, void *p, mxml_save_cb_t cb, int ws, int col, _mxml_putc_cb_t putc_cb);
+#ifdef HAVE_LIBZ
+static voidpf		mxml_zalloc(voidpf opaque, uInt items, uInt size);
+static void		mxml_zfree(voidpf opaque, voidpf ptr);
+#endif /* HAVE_LIBZ */
+static int		mxml_zread(void *p, void *buffer, size_t bytes);
+static void		mxml_zstream_delete(_mxml_zstream_t *z);
+static _mxml_zstream_t	*mxml_zstream_new(mxml_compress_t format, int compress);
+static int		mxml_zwrite(_mxml_fdbuf_t *buf, const unsigned char *data, size_t len, int finish);
+
+
+/*
+ * 'mxmlLoadBatch()' - Load many files using several threads.
+ *
+ * The files are loaded as for @link mxmlLoadPath@ by up to "threads"
+ * threads (0 for one per CPU), with each thread taking the next file as
+ * soon as it is done with the last one.  Each thread reads the next few
+ * files while it parses the current one.  The tree for each file is stored
+ * in the "trees" array, or @code NULL@ if the file could not be loaded.
+ *
+ * If the "errors" array is not @code NULL@, the first error message for
+ * each file is stored in it instead of being reported, or @code NULL@ if
+ * the file was loaded.  Free the messages with "free".  Otherwise errors
+ * are reported from the thread that loaded the file, so the error callback
+ * must be thread-safe.
+ *
+ * The callback function must also be thread-safe.  Entity and custom data
+ * callbacks are copied from the calling thread.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - Number of files loaded or -1 on error */
+mxmlLoadBatch(
+    const char * const *filenames,	/* I - Files to load */
+    int                num_files,	/* I - Number of files */
+    mxml_load_cb_t     cb,		/* I - Callback function or constant */
+    int                threads,		/* I - Number of threads or 0 for one per CPU */
+    mxml_node_t        **trees,		/* O - Loaded trees */
+    char               **errors)	/* O - Error messages or @code NULL@ */
+{
+  _mxml_batch_t	batch;			/* Batch load state */
+  int		i,			/* Looping var */
+		count;			/* Number of files loaded */
+#ifdef HAVE_PTHREAD_H
+  pthread_t	*workers;		/* Worker threads */
+  int		num_workers;		/* Number of worker threads */
+#endif /* HAVE_PTHREAD_H */
+
+
+ /*
+  * Range check input...
+  */
+
+  if (num_files < 0 || (num_files > 0 && (!filenames || !trees)))
+    return (-1);
+
+  for (i = 0; i < num_files; i ++)
+  {
+    trees[i] = NULL;
+
+    if (errors)
+      errors[i] = NULL;
+  }
+
+ /*
+  * Load the files using this thread and the worker threads...
+  */
+
+  batch.filenames = filenames;
+  batch.num_files = num_files;
+  batch.next_file = 0;
+  batch.cb        = cb;
+  batch.trees     = trees;
+  batch.errors    = errors;
+  batch.global    = *_mxml_global();
+
+  batch.global.error = NULL;
+
+  if (errors)
+    batch.global.error_cb = mxml_batch_error;
+
+#ifdef HAVE_PTHREAD_H
+  if (threads <= 0)
+  {
+#  ifdef _SC_NPROCESSORS_ONLN
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#  else
+    threads = 1;
+#  endif /* _SC_NPROCESSORS_ONLN */
+  }
+
+  pthread_mutex_init(&batch.mutex, NULL);
+
+  if ((num_workers = threads < num_files ? threads - 1 : num_files - 1) > 0 && (workers = _mxml_calloc((size_t)num_workers, sizeof(pthread_t))) != NULL)
+  {
+    for (i = 0; i < num_workers; i ++)
+      if (pthread_create(workers + i, NULL, mxml_batch_worker, &batch))
+        break;
+
+    num_workers = i;
+
+    mxml_batch_worker(&batch);
+
+    for (i = 0; i < num_workers; i ++)
+      pthread_join(workers[i], NULL);
+
+    _mxml_free(workers);
+  }
+  else
+    mxml_batch_worker(&batch);
+
+  pthread_mutex_destroy(&batch.mutex);
+
+#else
+  (void)threads;
+
+  mxml_batch_worker(&batch);
+#endif /* HAVE_PTHREAD_H */
+
+  for (i = 0, count = 0; i < num_files; i ++)
+    if (trees[i])
+      count ++;
+
+  return (count);
+}
+
+
+/*
+ * 'mxmlLoadBuffer()' - Load a memory buffer into an XML node tree.
+ *
+ * The nodes in the specified buffer are added to the specified top node.
+ * If no top node is provided, the XML data MUST be well-formed with a
+ * single parent node like <?xml> for the entire buffer. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child (data) nodes of the specified type.
+ *
+ * Unlike @link mxmlLoadString@, the buffer does not need to be nul-terminated
+ * and may contain UTF-16 data with a byte order mark.  No more than "len"
+ * bytes are read, and a nul character in the buffer is reported as an error.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_node_t *				/* O - First node or @code NULL@ if the buffer has errors. */
+mxmlLoadBuffer(mxml_node_t    *top,	/* I - Top node */
+               const void     *data,	/* I - Buffer to load */
+               size_t         len,	/* I - Length of buffer in bytes */
+               mxml_load_cb_t cb)	/* I - Callback function or constant */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_buffer(&in, data, len);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
+}
+
+
+/*
+ * 'mxmlLoadBufferParallel()' - Load a memory buffer into an XML node tree
+ *                              using several threads.
+ *
+ * The buffer is split between the children of the root element and the
+ * pieces are loaded at the same time by up to "threads" threads (0 for one
+ * per CPU).  The resulting tree is the same as for @link mxmlLoadBuffer@,
+ * which is used for small buffers, UTF-16 buffers, or when threads are not
+ * supported.
+ *
+ * The callback function is called from several threads and must be
+ * thread-safe.  For the children of the root element it is called with a
+ * copy of the root element that has the same name and attributes but no
+ * parent.  Entity and custom data callbacks are copied from the calling
+ * thread.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_node_t *				/* O - First node or @code NULL@ if the buffer has errors. */
+mxmlLoadBufferParallel(
+    mxml_node_t    *top,		/* I - Top node */
+    const void     *data,		/* I - Buffer to load */
+    size_t         len,			/* I - Length of buffer in bytes */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    int            threads)		/* I - Number of threads or 0 for one per CPU */
+{
+  return (mxml_load_parallel(top, data, len, cb, threads));
+}
 
 
 /*
@@ -100,22 +735,20 @@ mxmlLoadFd(mxml_node_t    *top,		/* I - Top node */
            int            fd,		/* I - File descriptor to read from */
            mxml_load_cb_t cb)		/* I - Callback function or constant */
 {
-  _mxml_fdbuf_t	buf;			/* File descriptor buffer */
+  _mxml_read_t	in;			/* Input buffer */
 
 
  /*
-  * Initialize the file descriptor buffer...
+  * Initialize the input buffer...
   */
 
-  buf.fd      = fd;
-  buf.current = buf.buffer;
-  buf.end     = buf.buffer;
+  mxml_read_init(&in, mxml_fd_read, &fd);
 
  /*
   * Read the XML data...
   */
 
-  return (mxml_load_data(top, &buf, cb, mxml_fd_getc, MXML_NO_CALLBACK, NULL));
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
@@ -142,2523 +775,6693 @@ mxmlLoadFile(mxml_node_t    *top,	/* I - Top node */
              FILE           *fp,	/* I - File to read from */
              mxml_load_cb_t cb)		/* I - Callback function or constant */
 {
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_init(&in, mxml_file_read, fp);
+
  /*
   * Read the XML data...
   */
 
-  return (mxml_load_data(top, fp, cb, mxml_file_getc, MXML_NO_CALLBACK, NULL));
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxmlLoadString()' - Load a string into an XML node tree.
+ * 'mxmlLoadPath()' - Load a named file into an XML node tree.
  *
- * The nodes in the specified string are added to the specified top node.
- * If no top node is provided, the XML string MUST be well-formed with a
- * single parent node like <?xml> for the entire string. The callback
+ * The nodes in the specified file are added to the specified top node.
+ * If no top node is provided, the XML file MUST be well-formed with a
+ * single parent node like <?xml> for the entire file. The callback
  * function returns the value type that should be used for child nodes.
  * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
  * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
  * loading child (data) nodes of the specified type.
  *
- * Note: The most common programming error when using the Mini-XML library is
- * to load an XML file using the @code MXML_TEXT_CALLBACK@, which returns inline
- * text as a series of whitespace-delimited words, instead of using the
- * @code MXML_OPAQUE_CALLBACK@ which returns the inline text as a single string
- * (including whitespace).
+ * Regular files are mapped into memory and parsed directly from the mapping
+ * when the platform supports it.  Other files (pipes, devices, etc.) are read
+ * like @link mxmlLoadFd@.  The file must not be truncated while it is being
+ * loaded.
+ *
+ * @since Mini-XML 3.1@
  */
 
-mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
-mxmlLoadString(mxml_node_t    *top,	/* I - Top node */
-               const char     *s,	/* I - String to load */
-               mxml_load_cb_t cb)	/* I - Callback function or constant */
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlLoadPath(mxml_node_t    *top,	/* I - Top node */
+             const char     *filename,	/* I - File to read from */
+             mxml_load_cb_t cb)		/* I - Callback function or constant */
 {
- /*
-  * Read the XML data...
-  */
-
-  return (mxml_load_data(top, (void *)&s, cb, mxml_string_getc, MXML_NO_CALLBACK,
-                         NULL));
+  return (mxml_load_path(NULL, top, filename, cb, MXML_NO_CALLBACK, NULL, 1));
 }
 
 
 /*
- * 'mxmlSaveAllocString()' - Save an XML tree to an allocated string.
+ * 'mxmlLoadPathParallel()' - Load a named file into an XML node tree using
+ *                            several threads.
  *
- * This function returns a pointer to a string containing the textual
- * representation of the XML node tree.  The string should be freed
- * using the free() function when you are done with it.  @code NULL@ is returned
- * if the node would produce an empty string or if the string cannot be
- * allocated.
+ * Regular files are mapped into memory and loaded as for
+ * @link mxmlLoadBufferParallel@.  Other files are loaded as for
+ * @link mxmlLoadPath@.
  *
- * The callback argument specifies a function that returns a whitespace
- * string or NULL before and after each element.  If @code MXML_NO_CALLBACK@
- * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
- * with leading whitespace and before attribute names inside opening
- * element tags.
+ * @since Mini-XML 3.1@
  */
 
-char *					/* O - Allocated string or @code NULL@ */
-mxmlSaveAllocString(
-    mxml_node_t    *node,		/* I - Node to write */
-    mxml_save_cb_t cb)			/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlLoadPathParallel(
+    mxml_node_t    *top,		/* I - Top node */
+    const char     *filename,		/* I - File to read from */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    int            threads)		/* I - Number of threads or 0 for one per CPU */
 {
-  int	bytes;				/* Required bytes */
-  char	buffer[8192];			/* Temporary buffer */
-  char	*s;				/* Allocated string */
-
-
- /*
-  * Write the node to the temporary buffer...
-  */
+  return (mxml_load_path(NULL, top, filename, cb, MXML_NO_CALLBACK, NULL, threads));
+}
 
-  bytes = mxmlSaveString(node, buffer, sizeof(buffer), cb);
 
-  if (bytes <= 0)
-    return (NULL);
+/*
+ * 'mxmlLoadRecordsBuffer()' - Load a memory buffer one record at a time.
+ *
+ * Each element with the specified name is loaded into a node tree of its
+ * own and passed to the record callback once its close tag has been read.
+ * The record has no parent and is deleted when the callback returns unless
+ * the callback calls @link mxmlRetain@ on it, in which case the caller owns
+ * it and must release it with @link mxmlRelease@.  Elements with the same
+ * name inside a record are part of that record.  Everything outside of the
+ * records is discarded as it is read, so memory use is bounded by the size
+ * of the largest record.
+ *
+ * The callback function returns the value type that should be used for
+ * child nodes, as for @link mxmlLoadBuffer@, and the buffer is read as for
+ * @link mxmlLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-  if (bytes < (int)(sizeof(buffer) - 1))
-  {
-   /*
-    * Node fit inside the buffer, so just duplicate that string and
-    * return...
-    */
+int					/* O - Number of records or -1 on error */
+mxmlLoadRecordsBuffer(
+    const void       *data,		/* I - Buffer to load */
+    size_t           len,		/* I - Length of buffer in bytes */
+    const char       *name,		/* I - Record element name */
+    mxml_load_cb_t   cb,		/* I - Callback function or constant */
+    mxml_record_cb_t record_cb,		/* I - Record callback */
+    void             *record_data)	/* I - Record callback data */
+{
+  _mxml_read_t	in;			/* Input buffer */
 
-    return (strdup(buffer));
-  }
 
  /*
-  * Allocate a buffer of the required size and save the node to the
-  * new buffer...
+  * Initialize the input buffer...
   */
 
-  if ((s = malloc(bytes + 1)) == NULL)
-    return (NULL);
-
-  mxmlSaveString(node, s, bytes + 1, cb);
+  mxml_read_buffer(&in, data, len);
 
  /*
-  * Return the allocated string...
+  * Read the XML data...
   */
 
-  return (s);
+  return (mxml_load_records(&in, name, cb, record_cb, record_data));
 }
 
 
 /*
- * 'mxmlSaveFd()' - Save an XML tree to a file descriptor.
+ * 'mxmlLoadRecordsFd()' - Load a file descriptor one record at a time.
  *
- * The callback argument specifies a function that returns a whitespace
- * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
- * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
- * with leading whitespace and before attribute names inside opening
- * element tags.
+ * The records are loaded as for @link mxmlLoadRecordsBuffer@.
+ *
+ * @since Mini-XML 3.1@
  */
 
-int					/* O - 0 on success, -1 on error. */
-mxmlSaveFd(mxml_node_t    *node,	/* I - Node to write */
-           int            fd,		/* I - File descriptor to write to */
-	   mxml_save_cb_t cb)		/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+int					/* O - Number of records or -1 on error */
+mxmlLoadRecordsFd(
+    int              fd,		/* I - File descriptor to read from */
+    const char       *name,		/* I - Record element name */
+    mxml_load_cb_t   cb,		/* I - Callback function or constant */
+    mxml_record_cb_t record_cb,		/* I - Record callback */
+    void             *record_data)	/* I - Record callback data */
 {
-  int		col;			/* Final column */
-  _mxml_fdbuf_t	buf;			/* File descriptor buffer */
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
+  _mxml_read_t	in;			/* Input buffer */
 
 
  /*
-  * Initialize the file descriptor buffer...
+  * Initialize the input buffer...
   */
 
-  buf.fd      = fd;
-  buf.current = buf.buffer;
-  buf.end     = buf.buffer + sizeof(buf.buffer);
+  mxml_read_init(&in, mxml_fd_read, &fd);
 
  /*
-  * Write the node...
-  */
-
-  if ((col = mxml_write_node(node, &buf, cb, 0, mxml_fd_putc, global)) < 0)
-    return (-1);
-
-  if (col > 0)
-    if (mxml_fd_putc('\n', &buf) < 0)
-      return (-1);
-
- /*
-  * Flush and return...
+  * Read the XML data...
   */
 
-  return (mxml_fd_write(&buf));
+  return (mxml_load_records(&in, name, cb, record_cb, record_data));
 }
 
 
 /*
- * 'mxmlSaveFile()' - Save an XML tree to a file.
+ * 'mxmlLoadRecordsFile()' - Load a file one record at a time.
  *
- * The callback argument specifies a function that returns a whitespace
- * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
- * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
- * with leading whitespace and before attribute names inside opening
- * element tags.
+ * The records are loaded as for @link mxmlLoadRecordsBuffer@.
+ *
+ * @since Mini-XML 3.1@
  */
 
-int					/* O - 0 on success, -1 on error. */
-mxmlSaveFile(mxml_node_t    *node,	/* I - Node to write */
-             FILE           *fp,	/* I - File to write to */
-	     mxml_save_cb_t cb)		/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+int					/* O - Number of records or -1 on error */
+mxmlLoadRecordsFile(
+    FILE             *fp,		/* I - File to read from */
+    const char       *name,		/* I - Record element name */
+    mxml_load_cb_t   cb,		/* I - Callback function or constant */
+    mxml_record_cb_t record_cb,		/* I - Record callback */
+    void             *record_data)	/* I - Record callback data */
 {
-  int	col;				/* Final column */
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
+  _mxml_read_t	in;			/* Input buffer */
 
 
  /*
-  * Write the node...
+  * Initialize the input buffer...
   */
 
-  if ((col = mxml_write_node(node, fp, cb, 0, mxml_file_putc, global)) < 0)
-    return (-1);
-
-  if (col > 0)
-    if (putc('\n', fp) < 0)
-      return (-1);
+  mxml_read_init(&in, mxml_file_read, fp);
 
  /*
-  * Return 0 (success)...
+  * Read the XML data...
   */
 
-  return (0);
+  return (mxml_load_records(&in, name, cb, record_cb, record_data));
 }
 
 
 /*
- * 'mxmlSaveString()' - Save an XML node tree to a string.
+ * 'mxmlLoadRecordsString()' - Load a string one record at a time.
  *
- * This function returns the total number of bytes that would be
- * required for the string but only copies (bufsize - 1) characters
- * into the specified buffer.
+ * The records are loaded as for @link mxmlLoadRecordsBuffer@.
  *
- * The callback argument specifies a function that returns a whitespace
- * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
- * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
- * with leading whitespace and before attribute names inside opening
- * element tags.
+ * @since Mini-XML 3.1@
  */
 
-int					/* O - Size of string */
-mxmlSaveString(mxml_node_t    *node,	/* I - Node to write */
-               char           *buffer,	/* I - String buffer */
-               int            bufsize,	/* I - Size of string buffer */
-               mxml_save_cb_t cb)	/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+int					/* O - Number of records or -1 on error */
+mxmlLoadRecordsString(
+    const char       *s,		/* I - String to load */
+    const char       *name,		/* I - Record element name */
+    mxml_load_cb_t   cb,		/* I - Callback function or constant */
+    mxml_record_cb_t record_cb,		/* I - Record callback */
+    void             *record_data)	/* I - Record callback data */
 {
-  int	col;				/* Final column */
-  char	*ptr[2];			/* Pointers for putc_cb */
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
-
-
- /*
-  * Write the node...
-  */
-
-  ptr[0] = buffer;
-  ptr[1] = buffer + bufsize;
+  _mxml_read_t	in;			/* Input buffer */
 
-  if ((col = mxml_write_node(node, ptr, cb, 0, mxml_string_putc, global)) < 0)
-    return (-1);
-
-  if (col > 0)
-    mxml_string_putc('\n', ptr);
 
  /*
-  * Nul-terminate the buffer...
+  * Initialize the input buffer...
   */
 
-  if (ptr[0] >= ptr[1])
-    buffer[bufsize - 1] = '\0';
-  else
-    ptr[0][0] = '\0';
+  mxml_read_string(&in, s);
 
  /*
-  * Return the number of characters...
+  * Read the XML data...
   */
 
-  return ((int)(ptr[0] - buffer));
+  return (mxml_load_records(&in, name, cb, record_cb, record_data));
 }
 
 
 /*
- * 'mxmlSAXLoadFd()' - Load a file descriptor into an XML node tree
- *                     using a SAX callback.
+ * 'mxmlLoadString()' - Load a string into an XML node tree.
  *
- * The nodes in the specified file are added to the specified top node.
- * If no top node is provided, the XML file MUST be well-formed with a
- * single parent node like <?xml> for the entire file. The callback
+ * The nodes in the specified string are added to the specified top node.
+ * If no top node is provided, the XML string MUST be well-formed with a
+ * single parent node like <?xml> for the entire string. The callback
  * function returns the value type that should be used for child nodes.
  * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
  * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
- * loading child nodes of the specified type.
- *
- * The SAX callback must call @link mxmlRetain@ for any nodes that need to
- * be kept for later use. Otherwise, nodes are deleted when the parent
- * node is closed or after each data, comment, CDATA, or directive node.
+ * loading child (data) nodes of the specified type.
  *
- * @since Mini-XML 2.3@
+ * Note: The most common programming error when using the Mini-XML library is
+ * to load an XML file using the @code MXML_TEXT_CALLBACK@, which returns inline
+ * text as a series of whitespace-delimited words, instead of using the
+ * @code MXML_OPAQUE_CALLBACK@ which returns the inline text as a single string
+ * (including whitespace).
  */
 
-mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
-mxmlSAXLoadFd(mxml_node_t    *top,	/* I - Top node */
-              int            fd,	/* I - File descriptor to read from */
-              mxml_load_cb_t cb,	/* I - Callback function or constant */
-              mxml_sax_cb_t  sax_cb,	/* I - SAX callback or @code MXML_NO_CALLBACK@ */
-              void           *sax_data)	/* I - SAX user data */
+mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
+mxmlLoadString(mxml_node_t    *top,	/* I - Top node */
+               const char     *s,	/* I - String to load */
+               mxml_load_cb_t cb)	/* I - Callback function or constant */
 {
-  _mxml_fdbuf_t	buf;			/* File descriptor buffer */
+  _mxml_read_t	in;			/* Input buffer */
 
 
  /*
-  * Initialize the file descriptor buffer...
+  * Initialize the input buffer...
   */
 
-  buf.fd      = fd;
-  buf.current = buf.buffer;
-  buf.end     = buf.buffer;
+  mxml_read_string(&in, s);
 
  /*
   * Read the XML data...
   */
 
-  return (mxml_load_data(top, &buf, cb, mxml_fd_getc, sax_cb, sax_data));
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxmlSAXLoadFile()' - Load a file into an XML node tree
- *                       using a SAX callback.
- *
- * The nodes in the specified file are added to the specified top node.
- * If no top node is provided, the XML file MUST be well-formed with a
- * single parent node like <?xml> for the entire file. The callback
- * function returns the value type that should be used for child nodes.
- * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
- * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
- * loading child nodes of the specified type.
+ * 'mxmlLoadStringInPlace()' - Load a string into an XML node tree, reusing
+ *                             the string buffer.
  *
- * The SAX callback must call @link mxmlRetain@ for any nodes that need to
- * be kept for later use. Otherwise, nodes are deleted when the parent
- * node is closed or after each data, comment, CDATA, or directive node.
+ * This function works like @link mxmlLoadString@ but stores the element names,
+ * attributes, and string values in the string buffer instead of allocating
+ * copies.  Entities are decoded and each value is nul-terminated in the
+ * buffer, so the original contents of the string are destroyed.  The buffer
+ * must remain valid until the nodes are deleted.  Changing a value with the
+ * @code mxmlSet@ or @code mxmlElementSet@ functions replaces it with an
+ * allocated copy as usual.
  *
- * @since Mini-XML 2.3@
+ * @since Mini-XML 3.1@
  */
 
-mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
-mxmlSAXLoadFile(
+mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
+mxmlLoadStringInPlace(
     mxml_node_t    *top,		/* I - Top node */
-    FILE           *fp,			/* I - File to read from */
-    mxml_load_cb_t cb,			/* I - Callback function or constant */
-    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
-    void           *sax_data)		/* I - SAX user data */
+    char           *s,			/* I - Writable string to load */
+    mxml_load_cb_t cb)			/* I - Callback function or constant */
 {
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_string(&in, s);
+
+  in.inplace = (unsigned char *)s;
+
  /*
   * Read the XML data...
   */
 
-  return (mxml_load_data(top, fp, cb, mxml_file_getc, sax_cb, sax_data));
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxmlSAXLoadString()' - Load a string into an XML node tree
- *                         using a SAX callback.
- *
- * The nodes in the specified string are added to the specified top node.
- * If no top node is provided, the XML string MUST be well-formed with a
- * single parent node like <?xml> for the entire string. The callback
- * function returns the value type that should be used for child nodes.
- * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
- * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
- * loading child nodes of the specified type.
- *
- * The SAX callback must call @link mxmlRetain@ for any nodes that need to
- * be kept for later use. Otherwise, nodes are deleted when the parent
- * node is closed or after each data, comment, CDATA, or directive node.
+ * 'mxmlLoaderDelete()' - Delete a loader and free its buffers.
  *
- * @since Mini-XML 2.3@
+ * @since Mini-XML 3.1@
  */
 
-mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
-mxmlSAXLoadString(
-    mxml_node_t    *top,		/* I - Top node */
-    const char     *s,			/* I - String to load */
-    mxml_load_cb_t cb,			/* I - Callback function or constant */
-    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
-    void           *sax_data)		/* I - SAX user data */
+void
+mxmlLoaderDelete(
+    mxml_loader_t *loader)		/* I - Loader */
 {
- /*
-  * Read the XML data...
-  */
+  if (!loader)
+    return;
 
-  return (mxml_load_data(top, (void *)&s, cb, mxml_string_getc, sax_cb, sax_data));
+  mxml_load_free(&loader->load);
+  _mxml_free(loader);
 }
 
 
 /*
- * 'mxmlSetCustomHandlers()' - Set the handling functions for custom data.
- *
- * The load function accepts a node pointer and a data string and must
- * return 0 on success and non-zero on error.
+ * 'mxmlLoaderLoadBuffer()' - Load a memory buffer using a loader.
  *
- * The save function accepts a node pointer and must return a malloc'd
- * string on success and @code NULL@ on error.
+ * This function works like @link mxmlLoadBuffer@ but reuses the string and
+ * input buffers of the loader.
  *
+ * @since Mini-XML 3.1@
  */
 
-void
-mxmlSetCustomHandlers(
-    mxml_custom_load_cb_t load,		/* I - Load function */
-    mxml_custom_save_cb_t save)		/* I - Save function */
+mxml_node_t *				/* O - First node or @code NULL@ if the buffer has errors. */
+mxmlLoaderLoadBuffer(
+    mxml_loader_t  *loader,		/* I - Loader */
+    mxml_node_t    *top,		/* I - Top node */
+    const void     *data,		/* I - Buffer to load */
+    size_t         len,			/* I - Length of buffer in bytes */
+    mxml_load_cb_t cb)			/* I - Callback function or constant */
 {
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
+  if (!loader)
+    return (NULL);
 
+  mxml_read_buffer(&loader->in, data, len);
 
-  global->custom_load_cb = load;
-  global->custom_save_cb = save;
+  return (mxml_load_data(&loader->load, top, &loader->in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxmlSetErrorCallback()' - Set the error message callback.
+ * 'mxmlLoaderLoadFd()' - Load a file descriptor using a loader.
+ *
+ * This function works like @link mxmlLoadFd@ but reuses the string and
+ * input buffers of the loader.
+ *
+ * @since Mini-XML 3.1@
  */
 
-void
-mxmlSetErrorCallback(mxml_error_cb_t cb)/* I - Error callback function */
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlLoaderLoadFd(
+    mxml_loader_t  *loader,		/* I - Loader */
+    mxml_node_t    *top,		/* I - Top node */
+    int            fd,			/* I - File descriptor to read from */
+    mxml_load_cb_t cb)			/* I - Callback function or constant */
 {
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
+  if (!loader)
+    return (NULL);
 
+  mxml_read_init(&loader->in, mxml_fd_read, &fd);
 
-  global->error_cb = cb;
+  return (mxml_load_data(&loader->load, top, &loader->in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxmlSetWrapMargin()' - Set the wrap margin when saving XML data.
+ * 'mxmlLoaderLoadFile()' - Load a file using a loader.
  *
- * Wrapping is disabled when "column" is 0.
+ * This function works like @link mxmlLoadFile@ but reuses the string and
+ * input buffers of the loader.
  *
- * @since Mini-XML 2.3@
+ * @since Mini-XML 3.1@
  */
 
-void
-mxmlSetWrapMargin(int column)		/* I - Column for wrapping, 0 to disable wrapping */
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlLoaderLoadFile(
+    mxml_loader_t  *loader,		/* I - Loader */
+    mxml_node_t    *top,		/* I - Top node */
+    FILE           *fp,			/* I - File to read from */
+    mxml_load_cb_t cb)			/* I - Callback function or constant */
 {
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
+  if (!loader)
+    return (NULL);
 
+  mxml_read_init(&loader->in, mxml_file_read, fp);
 
-  global->wrap = column;
+  return (mxml_load_data(&loader->load, top, &loader->in, cb, MXML_NO_CALLBACK, NULL));
 }
 
 
 /*
- * 'mxml_add_char()' - Add a character to a buffer, expanding as needed.
+ * 'mxmlLoaderLoadString()' - Load a string using a loader.
+ *
+ * This function works like @link mxmlLoadString@ but reuses the string and
+ * input buffers of the loader.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O  - 0 on success, -1 on error */
-mxml_add_char(int  ch,			/* I  - Character to add */
-              char **bufptr,		/* IO - Current position in buffer */
-	      char **buffer,		/* IO - Current buffer */
-	      int  *bufsize)		/* IO - Current buffer size */
+mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
+mxmlLoaderLoadString(
+    mxml_loader_t  *loader,		/* I - Loader */
+    mxml_node_t    *top,		/* I - Top node */
+    const char     *s,			/* I - String to load */
+    mxml_load_cb_t cb)			/* I - Callback function or constant */
 {
-  char	*newbuffer;			/* New buffer value */
+  if (!loader)
+    return (NULL);
 
+  mxml_read_string(&loader->in, s);
 
-  if (*bufptr >= (*buffer + *bufsize - 4))
-  {
-   /*
-    * Increase the size of the buffer...
-    */
+  return (mxml_load_data(&loader->load, top, &loader->in, cb, MXML_NO_CALLBACK, NULL));
+}
 
-    if (*bufsize < 1024)
-      (*bufsize) *= 2;
-    else
-      (*bufsize) += 1024;
 
-    if ((newbuffer = realloc(*buffer, *bufsize)) == NULL)
-    {
-      free(*buffer);
+/*
+ * 'mxmlLoaderNew()' - Create a loader for loading many documents.
+ *
+ * A loader keeps the string buffers used for names, attribute values, and
+ * text, along with its input buffer, from one document to the next, so
+ * loading a stream of small documents does not allocate and free them each
+ * time.  The buffers grow to fit the largest name, value, or text seen and
+ * are freed by @link mxmlLoaderDelete@.
+ *
+ * A loader can only be used by one thread at a time; programs that load
+ * documents in several threads should create a loader for each thread.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-      mxml_error("Unable to expand string buffer to %d bytes!", *bufsize);
+mxml_loader_t *				/* O - New loader or @code NULL@ on error */
+mxmlLoaderNew(void)
+{
+  mxml_loader_t	*loader;		/* New loader */
 
-      return (-1);
-    }
 
-    *bufptr = newbuffer + (*bufptr - *buffer);
-    *buffer = newbuffer;
+  if ((loader = _mxml_calloc(1, sizeof(mxml_loader_t))) == NULL)
+  {
+    mxml_error("Unable to allocate memory for loader.");
+    return (NULL);
   }
 
-  if (ch < 0x80)
+  if (mxml_load_init(&loader->load, NULL, MXML_NO_CALLBACK, MXML_NO_CALLBACK, NULL))
   {
-   /*
-    * Single byte ASCII...
-    */
-
-    *(*bufptr)++ = ch;
+    _mxml_free(loader);
+    return (NULL);
   }
-  else if (ch < 0x800)
-  {
-   /*
-    * Two-byte UTF-8...
-    */
 
-    *(*bufptr)++ = 0xc0 | (ch >> 6);
-    *(*bufptr)++ = 0x80 | (ch & 0x3f);
-  }
-  else if (ch < 0x10000)
-  {
-   /*
-    * Three-byte UTF-8...
-    */
+  loader->load.keep = 1;
 
-    *(*bufptr)++ = 0xe0 | (ch >> 12);
-    *(*bufptr)++ = 0x80 | ((ch >> 6) & 0x3f);
-    *(*bufptr)++ = 0x80 | (ch & 0x3f);
-  }
-  else
-  {
-   /*
-    * Four-byte UTF-8...
-    */
+  return (loader);
+}
 
-    *(*bufptr)++ = 0xf0 | (ch >> 18);
-    *(*bufptr)++ = 0x80 | ((ch >> 12) & 0x3f);
-    *(*bufptr)++ = 0x80 | ((ch >> 6) & 0x3f);
-    *(*bufptr)++ = 0x80 | (ch & 0x3f);
-  }
 
-  return (0);
+/*
+ * 'mxmlLoaderSetArena()' - Set whether a loader uses document arenas.
+ *
+ * When enabled, each document that is loaded without a top node is
+ * allocated from its own arena as described for @link mxmlNewXMLArena@, so
+ * that deleting the document frees its memory in a few large blocks.
+ * Documents loaded under a top node use the top node's arena, if any.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+void
+mxmlLoaderSetArena(
+    mxml_loader_t *loader,		/* I - Loader */
+    int           arena)		/* I - 1 to use arenas, 0 to allocate each node */
+{
+  if (loader)
+    loader->load.arena = arena;
 }
 
 
 /*
- * 'mxml_fd_getc()' - Read a character from a file descriptor.
+ * 'mxmlLoaderSetTypeMap()' - Set the type map used by a loader.
+ *
+ * The type map chooses the child value type for elements listed in it
+ * without calling the load callback; the callback passed to the load
+ * functions is still used for any other elements.  The map is not copied and
+ * must not be changed or deleted while the loader is using it.  Pass
+ * @code NULL@ to stop using a type map.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O  - Character or EOF */
-mxml_fd_getc(void *p,			/* I  - File descriptor buffer */
-             int  *encoding)		/* IO - Encoding */
+void
+mxmlLoaderSetTypeMap(
+    mxml_loader_t  *loader,		/* I - Loader */
+    mxml_typemap_t *map)		/* I - Type map or @code NULL@ */
 {
-  _mxml_fdbuf_t	*buf;			/* File descriptor buffer */
-  int		ch,			/* Current character */
-		temp;			/* Temporary character */
+  if (loader)
+    loader->load.typemap = map;
+}
 
 
- /*
-  * Grab the next character in the buffer...
-  */
+/*
+ * 'mxmlParserDelete()' - Delete a push parser.
+ *
+ * If the document has not been finished, any nodes loaded so far are
+ * deleted as well.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-  buf = (_mxml_fdbuf_t *)p;
+void
+mxmlParserDelete(
+    mxml_parser_t *parser)		/* I - Parser */
+{
+  if (!parser)
+    return;
 
-  if (buf->current >= buf->end)
-    if (mxml_fd_read(buf) < 0)
-      return (EOF);
+  if (parser->status == 0)
+  {
+    mxmlDelete(parser->load.first);
+    mxml_load_free(&parser->load);
+  }
+  else if (parser->tree != parser->load.top)
+    mxmlDelete(parser->tree);
 
-  ch = *(buf->current)++;
+  _mxml_free(parser->data);
+  _mxml_free(parser);
+}
 
-  switch (*encoding)
-  {
-    case ENCODE_UTF8 :
-       /*
-	* Got a UTF-8 character; convert UTF-8 to Unicode and return...
-	*/
 
-	if (!(ch & 0x80))
-	{
-#if DEBUG > 1
-          printf("mxml_fd_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+/*
+ * 'mxmlParserFeed()' - Feed a block of XML data to a push parser.
+ *
+ * The data can be split anywhere, including in the middle of a tag, entity,
+ * or UTF-8/UTF-16 character; any partial markup at the end of the block is
+ * kept until the rest arrives.  SAX callbacks are called as soon as each
+ * node is complete.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  if (mxml_bad_char(ch))
-	  {
-	    mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	       ch);
-	    return (EOF);
-	  }
+int					/* O - 0 on success, -1 on error */
+mxmlParserFeed(mxml_parser_t *parser,	/* I - Parser */
+               const void    *data,	/* I - XML data */
+               size_t        bytes)	/* I - Number of bytes of data */
+{
+  size_t	unread;			/* Bytes not yet parsed */
+  unsigned char	*temp;			/* New data buffer */
 
-	  return (ch);
-        }
-	else if (ch == 0xfe)
-	{
-	 /*
-	  * UTF-16 big-endian BOM?
-	  */
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+ /*
+  * Range check input...
+  */
 
-	  ch = *(buf->current)++;
+  if (!parser || parser->status || (!data && bytes))
+    return (-1);
 
-	  if (ch != 0xff)
-	    return (EOF);
+ /*
+  * Append the data to the unread input...
+  */
 
-	  *encoding = ENCODE_UTF16BE;
+  unread = (size_t)(parser->in.end - parser->in.current);
 
-	  return (mxml_fd_getc(p, encoding));
-	}
-	else if (ch == 0xff)
-	{
-	 /*
-	  * UTF-16 little-endian BOM?
-	  */
+  if (parser->in.current > parser->data)
+    memmove(parser->data, parser->in.current, unread);
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  if ((unread + bytes) > parser->datasize)
+  {
+    size_t datasize = parser->datasize;	/* New size of data buffer */
 
-	  ch = *(buf->current)++;
+    while (datasize < (unread + bytes))
+      datasize *= 2;
 
-	  if (ch != 0xfe)
-	    return (EOF);
+    if ((temp = _mxml_realloc(parser->data, datasize)) == NULL)
+    {
+      mxml_error("Unable to expand push parser buffer to %u bytes.", (unsigned)datasize);
+      return (-1);
+    }
 
-	  *encoding = ENCODE_UTF16LE;
+    parser->data     = temp;
+    parser->datasize = datasize;
+  }
 
-	  return (mxml_fd_getc(p, encoding));
-	}
-	else if ((ch & 0xe0) == 0xc0)
-	{
-	 /*
-	  * Two-byte value...
-	  */
+  memcpy(parser->data + unread, data, bytes);
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  parser->in.current = parser->data;
+  parser->in.end     = parser->data + unread + bytes;
+  parser->in.valid   = parser->data;
 
-	  temp = *(buf->current)++;
+ /*
+  * Don't rescan a partial token until we have at least twice as much data,
+  * so that feeding a large token in small pieces is not quadratic...
+  */
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
+  if ((unread + bytes) < 2 * parser->pending)
+    return (0);
 
-	  ch = ((ch & 0x1f) << 6) | (temp & 0x3f);
+ /*
+  * Load as much as we can...
+  */
 
-	  if (ch < 0x80)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
-	}
-	else if ((ch & 0xf0) == 0xe0)
-	{
-	 /*
-	  * Three-byte value...
-	  */
+  if ((parser->status = mxml_load_more(&parser->load, &parser->in, &parser->tree)) == 0)
+    parser->pending = (size_t)(parser->in.end - parser->in.current);
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  return (parser->status < 0 ? -1 : 0);
+}
 
-	  temp = *(buf->current)++;
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
+/*
+ * 'mxmlParserFinish()' - Finish loading the data fed to a push parser.
+ *
+ * Any remaining data is parsed as the end of the document.  The loaded
+ * tree is returned as for @link mxmlLoadString@ and belongs to the caller.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  ch = ((ch & 0x0f) << 6) | (temp & 0x3f);
+mxml_node_t *				/* O - First node or @code NULL@ if the data has errors. */
+mxmlParserFinish(
+    mxml_parser_t *parser)		/* I - Parser */
+{
+  mxml_node_t	*tree;			/* Loaded tree */
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
 
-	  temp = *(buf->current)++;
+  if (!parser)
+    return (NULL);
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
+  if (parser->status == 0)
+  {
+    parser->in.incomplete = 0;
+    parser->status        = mxml_load_more(&parser->load, &parser->in, &parser->tree);
+  }
 
-	  ch = (ch << 6) | (temp & 0x3f);
+  tree         = parser->tree;
+  parser->tree = NULL;
 
-	  if (ch < 0x800)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
+  return (tree);
+}
 
-         /*
-	  * Ignore (strip) Byte Order Mark (BOM)...
-	  */
 
-	  if (ch == 0xfeff)
-	    return (mxml_fd_getc(p, encoding));
-	}
-	else if ((ch & 0xf8) == 0xf0)
-	{
-	 /*
-	  * Four-byte value...
-	  */
+/*
+ * 'mxmlParserNew()' - Create a push parser that loads an XML node tree.
+ *
+ * The XML data is supplied in blocks with @link mxmlParserFeed@ and the tree
+ * is returned by @link mxmlParserFinish@.  The top node and callback work
+ * the same as for @link mxmlLoadString@.  Delete the parser with
+ * @link mxmlParserDelete@ when done.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+mxml_parser_t *				/* O - New parser or @code NULL@ on error */
+mxmlParserNew(mxml_node_t    *top,	/* I - Top node */
+              mxml_load_cb_t cb)	/* I - Callback function or constant */
+{
+  return (mxmlSAXParserNew(top, cb, MXML_NO_CALLBACK, NULL));
+}
 
-	  temp = *(buf->current)++;
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
+/*
+ * 'mxmlReaderDelete()' - Delete a pull reader.
+ *
+ * The reader can be deleted at any time; the rest of the document is not
+ * read.  File descriptors and files are not closed.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  ch = ((ch & 0x07) << 6) | (temp & 0x3f);
+void
+mxmlReaderDelete(
+    mxml_reader_t *reader)		/* I - Reader */
+{
+  if (!reader)
+    return;
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  if (reader->status == 0)
+    mxml_load_free(&reader->load);
 
-	  temp = *(buf->current)++;
+  mxml_read_free(&reader->in);
+  mxml_views_free(&reader->views);
+  _mxml_free(reader->strings);
+  _mxml_free(reader->attrs);
+  _mxml_free(reader);
+}
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
 
-	  ch = (ch << 6) | (temp & 0x3f);
+/*
+ * 'mxmlReaderGetAttr()' - Get an attribute of the current element.
+ *
+ * @code NULL@ is returned if the current event is not
+ * @code MXML_READER_ELEMENT_OPEN@ or the named attribute does not exist.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+const char *				/* O - Attribute value or @code NULL@ */
+mxmlReaderGetAttr(mxml_reader_t *reader,/* I - Reader */
+                  const char    *name)	/* I - Name of attribute */
+{
+  int		i;			/* Looping var */
+  _mxml_event_t	*event;			/* Current event */
+  _mxml_rattr_t	*attr;			/* Current attribute */
 
-	  temp = *(buf->current)++;
 
-	  if ((temp & 0xc0) != 0x80)
-	    return (EOF);
+  if (!reader || reader->cur_event >= reader->num_events || !name)
+    return (NULL);
 
-	  ch = (ch << 6) | (temp & 0x3f);
+  event = reader->events + reader->cur_event;
 
-	  if (ch < 0x10000)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
-	}
-	else
-	  return (EOF);
-	break;
+  for (i = event->num_attrs, attr = reader->attrs + event->first_attr; i > 0; i --, attr ++)
+  {
+    if (!strcmp(reader->strings + attr->name, name))
+      return (attr->value == MXML_NO_OFFSET ? NULL : reader->strings + attr->value);
+  }
 
-    case ENCODE_UTF16BE :
-       /*
-        * Read UTF-16 big-endian char...
-	*/
+  return (NULL);
+}
 
-	if (buf->current >= buf->end)
-	  if (mxml_fd_read(buf) < 0)
-	    return (EOF);
 
-	temp = *(buf->current)++;
+/*
+ * 'mxmlReaderGetAttrByIndex()' - Get an attribute of the current element by
+ *                                index.
+ *
+ * The index ("idx") is 0-based.  @code NULL@ is returned if the specified
+ * index is out of range.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	ch = (ch << 8) | temp;
+const char *				/* O - Attribute value */
+mxmlReaderGetAttrByIndex(
+    mxml_reader_t *reader,		/* I - Reader */
+    int           idx,			/* I - Attribute index, starting at 0 */
+    const char    **name)		/* O - Attribute name */
+{
+  _mxml_event_t	*event;			/* Current event */
+  _mxml_rattr_t	*attr;			/* Attribute */
 
-	if (mxml_bad_char(ch))
-	{
-	  mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	     ch);
-	  return (EOF);
-	}
-        else if (ch >= 0xd800 && ch <= 0xdbff)
-	{
-	 /*
-	  * Multi-word UTF-16 char...
-	  */
 
-          int lch;
+  if (!reader || reader->cur_event >= reader->num_events)
+    return (NULL);
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  event = reader->events + reader->cur_event;
 
-	  lch = *(buf->current)++;
+  if (idx < 0 || idx >= event->num_attrs)
+    return (NULL);
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+  attr = reader->attrs + event->first_attr + idx;
 
-	  temp = *(buf->current)++;
+  if (name)
+    *name = reader->strings + attr->name;
 
-	  lch = (lch << 8) | temp;
+  return (attr->value == MXML_NO_OFFSET ? NULL : reader->strings + attr->value);
+}
 
-          if (lch < 0xdc00 || lch >= 0xdfff)
-	    return (EOF);
 
-          ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	}
-	break;
+/*
+ * 'mxmlReaderGetAttrCount()' - Get the number of attributes of the current
+ *                              element.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-    case ENCODE_UTF16LE :
-       /*
-        * Read UTF-16 little-endian char...
-	*/
+int					/* O - Number of attributes */
+mxmlReaderGetAttrCount(
+    mxml_reader_t *reader)		/* I - Reader */
+{
+  if (reader && reader->cur_event < reader->num_events)
+    return (reader->events[reader->cur_event].num_attrs);
+  else
+    return (0);
+}
 
-	if (buf->current >= buf->end)
-	  if (mxml_fd_read(buf) < 0)
-	    return (EOF);
 
-	temp = *(buf->current)++;
+/*
+ * 'mxmlReaderGetDepth()' - Get the element depth of the current event.
+ *
+ * The root element is at depth 0, its children at depth 1, and so forth.
+ * The open and close events for an element have the same depth.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - Depth or -1 if there is no current event */
+mxmlReaderGetDepth(
+    mxml_reader_t *reader)		/* I - Reader */
+{
+  if (reader && reader->cur_event < reader->num_events)
+    return (reader->events[reader->cur_event].depth);
+  else
+    return (-1);
+}
 
-	ch |= (temp << 8);
 
-        if (mxml_bad_char(ch))
-	{
-	  mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	     ch);
-	  return (EOF);
-	}
-        else if (ch >= 0xd800 && ch <= 0xdbff)
-	{
-	 /*
-	  * Multi-word UTF-16 char...
-	  */
+/*
+ * 'mxmlReaderGetName()' - Get the name of the current node.
+ *
+ * For elements this is the element name.  For comments, CDATA, and
+ * processing directives this is the whole markup without the enclosing
+ * "<" and ">", as returned by @link mxmlGetElement@.  @code NULL@ is returned
+ * for data.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+const char *				/* O - Name or @code NULL@ */
+mxmlReaderGetName(
+    mxml_reader_t *reader)		/* I - Reader */
+{
+  if (!reader || reader->cur_event >= reader->num_events || reader->events[reader->cur_event].name == MXML_NO_OFFSET)
+    return (NULL);
+  else
+    return (reader->strings + reader->events[reader->cur_event].name);
+}
 
-          int lch;
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
+/*
+ * 'mxmlReaderGetText()' - Get the text of the current node.
+ *
+ * For data this is the text between two pieces of markup, including any
+ * whitespace, with entities decoded.  For CDATA this is the CDATA value.
+ * @code NULL@ is returned for other events.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  lch = *(buf->current)++;
+const char *				/* O - Text or @code NULL@ */
+mxmlReaderGetText(
+    mxml_reader_t *reader)		/* I - Reader */
+{
+  if (!reader || reader->cur_event >= reader->num_events || reader->events[reader->cur_event].text == MXML_NO_OFFSET)
+    return (NULL);
+  else
+    return (reader->strings + reader->events[reader->cur_event].text);
+}
 
-	  if (buf->current >= buf->end)
-	    if (mxml_fd_read(buf) < 0)
-	      return (EOF);
 
-	  temp = *(buf->current)++;
+/*
+ * 'mxmlReaderNewBuffer()' - Create a pull reader for a memory buffer.
+ *
+ * The buffer holds UTF-8 or UTF-16 data as for @link mxmlLoadBuffer@ and
+ * must remain valid until the reader is deleted.
+ *
+ * @since Mini-XML 3.1@
+ */
 
-	  lch |= (temp << 8);
+mxml_reader_t *				/* O - New reader or @code NULL@ on error */
+mxmlReaderNewBuffer(const void *data,	/* I - XML data */
+                    size_t     len)	/* I - Length of data in bytes */
+{
+  mxml_reader_t	*reader;		/* New reader */
 
-          if (lch < 0xdc00 || lch >= 0xdfff)
-	    return (EOF);
 
-          ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	}
-	break;
-  }
+  if (!data || (reader = mxml_reader_new()) == NULL)
+    return (NULL);
 
-#if DEBUG > 1
-  printf("mxml_fd_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+  mxml_read_buffer(&reader->in, data, len);
 
-  return (ch);
+  return (reader);
 }
 
 
 /*
- * 'mxml_fd_putc()' - Write a character to a file descriptor.
+ * 'mxmlReaderNewFd()' - Create a pull reader for a file descriptor.
+ *
+ * The file descriptor is read in blocks as events are requested.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O - 0 on success, -1 on error */
-mxml_fd_putc(int  ch,			/* I - Character */
-             void *p)			/* I - File descriptor buffer */
+mxml_reader_t *				/* O - New reader or @code NULL@ on error */
+mxmlReaderNewFd(int fd)			/* I - File descriptor to read from */
 {
-  _mxml_fdbuf_t	*buf;			/* File descriptor buffer */
-
+  mxml_reader_t	*reader;		/* New reader */
 
- /*
-  * Flush the write buffer as needed...
-  */
-
-  buf = (_mxml_fdbuf_t *)p;
 
-  if (buf->current >= buf->end)
-    if (mxml_fd_write(buf) < 0)
-      return (-1);
+  if (fd < 0 || (reader = mxml_reader_new()) == NULL)
+    return (NULL);
 
-  *(buf->current)++ = ch;
+  reader->fd = fd;
 
- /*
-  * Return successfully...
-  */
+  mxml_read_init(&reader->in, mxml_fd_read, &reader->fd);
 
-  return (0);
+  return (reader);
 }
 
 
 /*
- * 'mxml_fd_read()' - Read a buffer of data from a file descriptor.
+ * 'mxmlReaderNewFile()' - Create a pull reader for a file.
+ *
+ * The file is read in blocks as events are requested.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O - 0 on success, -1 on error */
-mxml_fd_read(_mxml_fdbuf_t *buf)		/* I - File descriptor buffer */
+mxml_reader_t *				/* O - New reader or @code NULL@ on error */
+mxmlReaderNewFile(FILE *fp)		/* I - File to read from */
 {
-  int	bytes;				/* Bytes read... */
+  mxml_reader_t	*reader;		/* New reader */
 
 
- /*
-  * Range check input...
-  */
+  if (!fp || (reader = mxml_reader_new()) == NULL)
+    return (NULL);
 
-  if (!buf)
-    return (-1);
+  mxml_read_init(&reader->in, mxml_file_read, fp);
 
- /*
-  * Read from the file descriptor...
-  */
+  return (reader);
+}
 
-  while ((bytes = (int)read(buf->fd, buf->buffer, sizeof(buf->buffer))) < 0)
-#ifdef EINTR
-    if (errno != EAGAIN && errno != EINTR)
-#else
-    if (errno != EAGAIN)
-#endif /* EINTR */
-      return (-1);
 
-  if (bytes == 0)
-    return (-1);
+/*
+ * 'mxmlReaderNewString()' - Create a pull reader for a string.
+ *
+ * The string must remain valid until the reader is deleted.
+ *
+ * @since Mini-XML 3.1@
+ */
 
- /*
-  * Update the pointers and return success...
-  */
+mxml_reader_t *				/* O - New reader or @code NULL@ on error */
+mxmlReaderNewString(const char *s)	/* I - String to read from */
+{
+  mxml_reader_t	*reader;		/* New reader */
 
-  buf->current = buf->buffer;
-  buf->end     = buf->buffer + bytes;
 
-  return (0);
+  if (!s || (reader = mxml_reader_new()) == NULL)
+    return (NULL);
+
+  mxml_read_string(&reader->in, s);
+
+  return (reader);
 }
 
 
 /*
- * 'mxml_fd_write()' - Write a buffer of data to a file descriptor.
+ * 'mxmlReaderNext()' - Read the next event from a pull reader.
+ *
+ * Only as much of the document as is needed for the next event is read, so
+ * the caller can stop at any point by deleting the reader.  The name, text,
+ * and attributes of the event are valid until the next call.  Data is
+ * reported as for @code MXML_OPAQUE_CALLBACK@, one event for each run of
+ * text between markup.
+ *
+ * @code MXML_READER_EOF@ is returned at the end of the document and
+ * @code MXML_READER_ERROR@ if the document has errors.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O - 0 on success, -1 on error */
-mxml_fd_write(_mxml_fdbuf_t *buf)	/* I - File descriptor buffer */
+mxml_reader_event_t			/* O - Event type */
+mxmlReaderNext(mxml_reader_t *reader)	/* I - Reader */
 {
-  int		bytes;			/* Bytes written */
-  unsigned char	*ptr;			/* Pointer into buffer */
+  int		status;			/* Load status */
+  mxml_node_t	*tree;			/* Loaded tree (always NULL) */
 
 
- /*
-  * Range check...
-  */
+  if (!reader)
+    return (MXML_READER_ERROR);
 
-  if (!buf)
-    return (-1);
+  if ((reader->cur_event + 1) < reader->num_events)
+  {
+   /*
+    * Return the next event from the last token...
+    */
 
- /*
-  * Return 0 if there is nothing to write...
-  */
+    reader->cur_event ++;
 
-  if (buf->current == buf->buffer)
-    return (0);
+    return (reader->events[reader->cur_event].event);
+  }
 
  /*
-  * Loop until we have written everything...
+  * Load the next token(s)...
   */
 
-  for (ptr = buf->buffer; ptr < buf->current; ptr += bytes)
-    if ((bytes = (int)write(buf->fd, ptr, buf->current - ptr)) < 0)
-      return (-1);
+  reader->cur_event  = 0;
+  reader->num_events = 0;
+  reader->num_attrs  = 0;
+  reader->strused    = 0;
 
- /*
-  * All done, reset pointers and return success...
-  */
+  while (!reader->status && !reader->error && !reader->num_events)
+  {
+    reader->load.pause = 0;
 
-  buf->current = buf->buffer;
+    if ((status = mxml_load_more(&reader->load, &reader->in, &tree)) != 0)
+      reader->status = status;
+  }
 
-  return (0);
+  if (reader->status < 0 || reader->error)
+  {
+    reader->num_events = 0;
+
+    return (MXML_READER_ERROR);
+  }
+  else if (reader->num_events > 0)
+    return (reader->events[0].event);
+  else
+    return (MXML_READER_EOF);
 }
 
 
 /*
- * 'mxml_file_getc()' - Get a character from a file.
+ * 'mxmlReaderSkip()' - Skip the rest of the current element.
+ *
+ * If the current event is @code MXML_READER_ELEMENT_OPEN@, events are read
+ * up to and including the matching @code MXML_READER_ELEMENT_CLOSE@ event.
+ * Otherwise nothing is read.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O  - Character or EOF */
-mxml_file_getc(void *p,			/* I  - Pointer to file */
-               int  *encoding)		/* IO - Encoding */
+mxml_reader_event_t			/* O - Current event type after skipping */
+mxmlReaderSkip(mxml_reader_t *reader)	/* I - Reader */
 {
-  int	ch,				/* Character from file */
-	temp;				/* Temporary character */
-  FILE	*fp;				/* Pointer to file */
+  int			depth;		/* Depth of element */
+  mxml_reader_event_t	event;		/* Current event */
 
 
- /*
-  * Read a character from the file and see if it is EOF or ASCII...
-  */
+  if (!reader || reader->cur_event >= reader->num_events)
+    return (MXML_READER_ERROR);
 
-  fp = (FILE *)p;
-  ch = getc(fp);
+  if ((event = reader->events[reader->cur_event].event) != MXML_READER_ELEMENT_OPEN)
+    return (event);
 
-  if (ch == EOF)
-    return (EOF);
+  depth = reader->events[reader->cur_event].depth;
 
-  switch (*encoding)
+  while ((event = mxmlReaderNext(reader)) > MXML_READER_EOF)
   {
-    case ENCODE_UTF8 :
-       /*
-	* Got a UTF-8 character; convert UTF-8 to Unicode and return...
-	*/
-
-	if (!(ch & 0x80))
-	{
-	  if (mxml_bad_char(ch))
-	  {
-	    mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	       ch);
-	    return (EOF);
-	  }
+    if (event == MXML_READER_ELEMENT_CLOSE && reader->events[reader->cur_event].depth == depth)
+      break;
+  }
 
-#if DEBUG > 1
-          printf("mxml_file_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+  return (event);
+}
 
-	  return (ch);
-        }
-	else if (ch == 0xfe)
-	{
-	 /*
-	  * UTF-16 big-endian BOM?
-	  */
 
-          ch = getc(fp);
-	  if (ch != 0xff)
-	    return (EOF);
+/*
+ * 'mxmlSaveAllocString()' - Save an XML tree to an allocated string.
+ *
+ * This function returns a pointer to a string containing the textual
+ * representation of the XML node tree.  The string should be freed
+ * using the free() function when you are done with it.  @code NULL@ is returned
+ * if the node would produce an empty string or if the string cannot be
+ * allocated.
+ *
+ * The callback argument specifies a function that returns a whitespace
+ * string or NULL before and after each element.  If @code MXML_NO_CALLBACK@
+ * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
+ * with leading whitespace and before attribute names inside opening
+ * element tags.
+ */
 
-	  *encoding = ENCODE_UTF16BE;
+char *					/* O - Allocated string or @code NULL@ */
+mxmlSaveAllocString(
+    mxml_node_t    *node,		/* I - Node to write */
+    mxml_save_cb_t cb)			/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+{
+  int	bytes;				/* Required bytes */
+  char	buffer[8192];			/* Temporary buffer */
+  char	*s;				/* Allocated string */
 
-	  return (mxml_file_getc(p, encoding));
-	}
-	else if (ch == 0xff)
-	{
-	 /*
-	  * UTF-16 little-endian BOM?
-	  */
 
-          ch = getc(fp);
-	  if (ch != 0xfe)
-	    return (EOF);
+ /*
+  * Write the node to the temporary buffer...
+  */
 
-	  *encoding = ENCODE_UTF16LE;
+  bytes = mxmlSaveString(node, buffer, sizeof(buffer), cb);
 
-	  return (mxml_file_getc(p, encoding));
-	}
-	else if ((ch & 0xe0) == 0xc0)
-	{
-	 /*
-	  * Two-byte value...
-	  */
+  if (bytes <= 0)
+    return (NULL);
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
+  if (bytes < (int)(sizeof(buffer) - 1))
+  {
+   /*
+    * Node fit inside the buffer, so just duplicate that string and
+    * return...
+    */
 
-	  ch = ((ch & 0x1f) << 6) | (temp & 0x3f);
+    return (strdup(buffer));
+  }
 
-	  if (ch < 0x80)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
-	}
-	else if ((ch & 0xf0) == 0xe0)
-	{
-	 /*
-	  * Three-byte value...
-	  */
+ /*
+  * Allocate a buffer of the required size and save the node to the
+  * new buffer...
+  */
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
+  if ((s = malloc(bytes + 1)) == NULL)
+    return (NULL);
 
-	  ch = ((ch & 0x0f) << 6) | (temp & 0x3f);
+  mxmlSaveString(node, s, bytes + 1, cb);
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
+ /*
+  * Return the allocated string...
+  */
 
-	  ch = (ch << 6) | (temp & 0x3f);
+  return (s);
+}
 
-	  if (ch < 0x800)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
 
-         /*
-	  * Ignore (strip) Byte Order Mark (BOM)...
-	  */
+/*
+ * 'mxmlSaveFd()' - Save an XML tree to a file descriptor.
+ *
+ * The callback argument specifies a function that returns a whitespace
+ * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
+ * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
+ * with leading whitespace and before attribute names inside opening
+ * element tags.
+ *
+ * The output is compressed as set by @link mxmlSetCompression@.
+ */
 
-	  if (ch == 0xfeff)
-	    return (mxml_file_getc(p, encoding));
-	}
-	else if ((ch & 0xf8) == 0xf0)
-	{
-	 /*
-	  * Four-byte value...
-	  */
+int					/* O - 0 on success, -1 on error. */
+mxmlSaveFd(mxml_node_t    *node,	/* I - Node to write */
+           int            fd,		/* I - File descriptor to write to */
+	   mxml_save_cb_t cb)		/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+{
+  return (mxml_save_fd(node, fd, NULL, cb));
+}
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
 
-	  ch = ((ch & 0x07) << 6) | (temp & 0x3f);
+/*
+ * 'mxmlSaveFile()' - Save an XML tree to a file.
+ *
+ * The callback argument specifies a function that returns a whitespace
+ * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
+ * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
+ * with leading whitespace and before attribute names inside opening
+ * element tags.
+ *
+ * The output is compressed as set by @link mxmlSetCompression@.
+ */
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
+int					/* O - 0 on success, -1 on error. */
+mxmlSaveFile(mxml_node_t    *node,	/* I - Node to write */
+             FILE           *fp,	/* I - File to write to */
+	     mxml_save_cb_t cb)		/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+{
+  int	col;				/* Final column */
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
 
-	  ch = (ch << 6) | (temp & 0x3f);
 
-	  if ((temp = getc(fp)) == EOF || (temp & 0xc0) != 0x80)
-	    return (EOF);
+  if (global->compression != MXML_COMPRESS_NONE)
+    return (mxml_save_fd(node, -1, fp, cb));
 
-	  ch = (ch << 6) | (temp & 0x3f);
+ /*
+  * Write the node...
+  */
 
-	  if (ch < 0x10000)
-	  {
-	    mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	    return (EOF);
-	  }
-	}
-	else
-	  return (EOF);
-	break;
+  if ((col = mxml_write_node(node, fp, cb, 0, mxml_file_putc, global)) < 0)
+    return (-1);
 
-    case ENCODE_UTF16BE :
-       /*
-        * Read UTF-16 big-endian char...
-	*/
+  if (col > 0)
+    if (putc('\n', fp) < 0)
+      return (-1);
 
-	ch = (ch << 8) | getc(fp);
+ /*
+  * Return 0 (success)...
+  */
 
-	if (mxml_bad_char(ch))
-	{
-	  mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	     ch);
-	  return (EOF);
-	}
-        else if (ch >= 0xd800 && ch <= 0xdbff)
-	{
-	 /*
-	  * Multi-word UTF-16 char...
-	  */
+  return (0);
+}
 
-          int lch = getc(fp);
-          lch = (lch << 8) | getc(fp);
 
-          if (lch < 0xdc00 || lch >= 0xdfff)
-	    return (EOF);
+/*
+ * 'mxmlSaveString()' - Save an XML node tree to a string.
+ *
+ * This function returns the total number of bytes that would be
+ * required for the string but only copies (bufsize - 1) characters
+ * into the specified buffer.
+ *
+ * The callback argument specifies a function that returns a whitespace
+ * string or NULL before and after each element. If @code MXML_NO_CALLBACK@
+ * is specified, whitespace will only be added before @code MXML_TEXT@ nodes
+ * with leading whitespace and before attribute names inside opening
+ * element tags.
+ */
 
-          ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	}
-	break;
+int					/* O - Size of string */
+mxmlSaveString(mxml_node_t    *node,	/* I - Node to write */
+               char           *buffer,	/* I - String buffer */
+               int            bufsize,	/* I - Size of string buffer */
+               mxml_save_cb_t cb)	/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+{
+  int	col;				/* Final column */
+  char	*ptr[2];			/* Pointers for putc_cb */
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
 
-    case ENCODE_UTF16LE :
-       /*
-        * Read UTF-16 little-endian char...
-	*/
 
-	ch |= (getc(fp) << 8);
+ /*
+  * Write the node...
+  */
 
-        if (mxml_bad_char(ch))
-	{
-	  mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	     ch);
-	  return (EOF);
-	}
-        else if (ch >= 0xd800 && ch <= 0xdbff)
-	{
-	 /*
-	  * Multi-word UTF-16 char...
-	  */
+  ptr[0] = buffer;
+  ptr[1] = buffer + bufsize;
+
+  if ((col = mxml_write_node(node, ptr, cb, 0, mxml_string_putc, global)) < 0)
+    return (-1);
 
-          int lch = getc(fp);
-          lch |= (getc(fp) << 8);
+  if (col > 0)
+    mxml_string_putc('\n', ptr);
 
-          if (lch < 0xdc00 || lch >= 0xdfff)
-	    return (EOF);
+ /*
+  * Nul-terminate the buffer...
+  */
 
-          ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	}
-	break;
-  }
+  if (ptr[0] >= ptr[1])
+    buffer[bufsize - 1] = '\0';
+  else
+    ptr[0][0] = '\0';
 
-#if DEBUG > 1
-  printf("mxml_file_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+ /*
+  * Return the number of characters...
+  */
 
-  return (ch);
+  return ((int)(ptr[0] - buffer));
 }
 
 
 /*
- * 'mxml_file_putc()' - Write a character to a file.
+ * 'mxmlSAXLoadBuffer()' - Load a memory buffer into an XML node tree
+ *                         using a SAX callback.
+ *
+ * The nodes in the specified buffer are added to the specified top node.
+ * If no top node is provided, the XML data MUST be well-formed with a
+ * single parent node like <?xml> for the entire buffer. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child nodes of the specified type.
+ *
+ * The SAX callback must call @link mxmlRetain@ for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ *
+ * The buffer is read as for @link mxmlLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
  */
 
-static int				/* O - 0 on success, -1 on failure */
-mxml_file_putc(int  ch,			/* I - Character to write */
-               void *p)			/* I - Pointer to file */
+mxml_node_t *				/* O - First node or @code NULL@ if the buffer has errors. */
+mxmlSAXLoadBuffer(
+    mxml_node_t    *top,		/* I - Top node */
+    const void     *data,		/* I - Buffer to load */
+    size_t         len,			/* I - Length of buffer in bytes */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+    void           *sax_data)		/* I - SAX user data */
 {
-  return (putc(ch, (FILE *)p) == EOF ? -1 : 0);
-}
+  _mxml_read_t	in;			/* Input buffer */
 
 
-/*
- * 'mxml_get_entity()' - Get the character corresponding to an entity...
- */
+ /*
+  * Initialize the input buffer...
+  */
 
-static int				/* O  - Character value or EOF on error */
-mxml_get_entity(mxml_node_t *parent,	/* I  - Parent node */
-		void        *p,		/* I  - Pointer to source */
-		int         *encoding,	/* IO - Character encoding */
-                int         (*getc_cb)(void *, int *),
-					/* I  - Get character function */
-                int         *line)	/* IO - Current line number */
-{
-  int	ch;				/* Current character */
-  char	entity[64],			/* Entity string */
-	*entptr;			/* Pointer into entity */
+  mxml_read_buffer(&in, data, len);
 
+ /*
+  * Read the XML data...
+  */
 
-  entptr = entity;
+  return (mxml_load_data(NULL, top, &in, cb, sax_cb, sax_data));
+}
 
-  while ((ch = (*getc_cb)(p, encoding)) != EOF)
-  {
-    if (ch > 126 || (!isalnum(ch) && ch != '#'))
-      break;
-    else if (entptr < (entity + sizeof(entity) - 1))
-      *entptr++ = ch;
-    else
-    {
-      mxml_error("Entity name too long under parent <%s> on line %d.", parent ? parent->value.element.name : "null", *line);
-      break;
-    }
-  }
 
-  *entptr = '\0';
+/*
+ * 'mxmlSAXLoadFd()' - Load a file descriptor into an XML node tree
+ *                     using a SAX callback.
+ *
+ * The nodes in the specified file are added to the specified top node.
+ * If no top node is provided, the XML file MUST be well-formed with a
+ * single parent node like <?xml> for the entire file. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child nodes of the specified type.
+ *
+ * The SAX callback must call @link mxmlRetain@ for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ *
+ * @since Mini-XML 2.3@
+ */
 
-  if (ch != ';')
-  {
-    mxml_error("Character entity '%s' not terminated under parent <%s> on line %d.", entity, parent ? parent->value.element.name : "null", *line);
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlSAXLoadFd(mxml_node_t    *top,	/* I - Top node */
+              int            fd,	/* I - File descriptor to read from */
+              mxml_load_cb_t cb,	/* I - Callback function or constant */
+              mxml_sax_cb_t  sax_cb,	/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+              void           *sax_data)	/* I - SAX user data */
+{
+  _mxml_read_t	in;			/* Input buffer */
 
-    if (ch == '\n')
-      (*line)++;
 
-    return (EOF);
-  }
+ /*
+  * Initialize the input buffer...
+  */
 
-  if (entity[0] == '#')
-  {
-    if (entity[1] == 'x')
-      ch = (int)strtol(entity + 2, NULL, 16);
-    else
-      ch = (int)strtol(entity + 1, NULL, 10);
-  }
-  else if ((ch = mxmlEntityGetValue(entity)) < 0)
-    mxml_error("Entity name '%s;' not supported under parent <%s> on line %d.", entity, parent ? parent->value.element.name : "null", *line);
+  mxml_read_init(&in, mxml_fd_read, &fd);
 
-  if (mxml_bad_char(ch))
-  {
-    mxml_error("Bad control character 0x%02x under parent <%s> on line %d not allowed by XML standard.", ch, parent ? parent->value.element.name : "null", *line);
-    return (EOF);
-  }
+ /*
+  * Read the XML data...
+  */
 
-  return (ch);
+  return (mxml_load_data(NULL, top, &in, cb, sax_cb, sax_data));
 }
 
 
 /*
- * 'mxml_load_data()' - Load data into an XML node tree.
+ * 'mxmlSAXLoadFile()' - Load a file into an XML node tree
+ *                       using a SAX callback.
+ *
+ * The nodes in the specified file are added to the specified top node.
+ * If no top node is provided, the XML file MUST be well-formed with a
+ * single parent node like <?xml> for the entire file. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child nodes of the specified type.
+ *
+ * The SAX callback must call @link mxmlRetain@ for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ *
+ * @since Mini-XML 2.3@
  */
 
-static mxml_node_t *			/* O - First node or NULL if the file could not be read. */
-mxml_load_data(
-    mxml_node_t     *top,		/* I - Top node */
-    void            *p,			/* I - Pointer to data */
-    mxml_load_cb_t  cb,			/* I - Callback function or MXML_NO_CALLBACK */
-    _mxml_getc_cb_t getc_cb,		/* I - Read function */
-    mxml_sax_cb_t   sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
-    void            *sax_data)		/* I - SAX user data */
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlSAXLoadFile(
+    mxml_node_t    *top,		/* I - Top node */
+    FILE           *fp,			/* I - File to read from */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+    void           *sax_data)		/* I - SAX user data */
 {
-  mxml_node_t	*node,			/* Current node */
-		*first,			/* First node added */
-		*parent;		/* Current parent node */
-  int		line = 1,		/* Current line number */
-		ch,			/* Character from file */
-		whitespace;		/* Non-zero if whitespace seen */
-  char		*buffer,		/* String buffer */
-		*bufptr;		/* Pointer into buffer */
-  int		bufsize;		/* Size of buffer */
-  mxml_type_t	type;			/* Current node type */
-  int		encoding;		/* Character encoding */
-  _mxml_global_t *global = _mxml_global();
-					/* Global data */
-  static const char * const types[] =	/* Type strings... */
-		{
-		  "MXML_ELEMENT",	/* XML element with attributes */
-		  "MXML_INTEGER",	/* Integer value */
-		  "MXML_OPAQUE",	/* Opaque string */
-		  "MXML_REAL",		/* Real value */
-		  "MXML_TEXT",		/* Text fragment */
-		  "MXML_CUSTOM"		/* Custom data */
-		};
+  _mxml_read_t	in;			/* Input buffer */
 
 
  /*
-  * Read elements and other nodes from the file...
+  * Initialize the input buffer...
   */
 
-  if ((buffer = malloc(64)) == NULL)
-  {
-    mxml_error("Unable to allocate string buffer!");
-    return (NULL);
-  }
-
-  bufsize    = 64;
-  bufptr     = buffer;
-  parent     = top;
-  first      = NULL;
-  whitespace = 0;
-  encoding   = ENCODE_UTF8;
+  mxml_read_init(&in, mxml_file_read, fp);
 
-  if (cb && parent)
-    type = (*cb)(parent);
-  else if (parent)
-    type = MXML_TEXT;
-  else
-    type = MXML_IGNORE;
+ /*
+  * Read the XML data...
+  */
 
-  while ((ch = (*getc_cb)(p, &encoding)) != EOF)
-  {
-    if ((ch == '<' ||
-         (mxml_isspace(ch) && type != MXML_OPAQUE && type != MXML_CUSTOM)) &&
-        bufptr > buffer)
-    {
-     /*
-      * Add a new value node...
-      */
+  return (mxml_load_data(NULL, top, &in, cb, sax_cb, sax_data));
+}
 
-      *bufptr = '\0';
 
-      switch (type)
-      {
-	case MXML_INTEGER :
-            node = mxmlNewInteger(parent, (int)strtol(buffer, &bufptr, 0));
-	    break;
+/*
+ * 'mxmlSAXLoadPath()' - Load a named file into an XML node tree
+ *                       using a SAX callback.
+ *
+ * The nodes in the specified file are added to the specified top node.
+ * If no top node is provided, the XML file MUST be well-formed with a
+ * single parent node like <?xml> for the entire file. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child nodes of the specified type.
+ *
+ * The SAX callback must call @link mxmlRetain@ for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ *
+ * Regular files are mapped into memory as for @link mxmlLoadPath@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_node_t *				/* O - First node or @code NULL@ if the file could not be read. */
+mxmlSAXLoadPath(
+    mxml_node_t    *top,		/* I - Top node */
+    const char     *filename,		/* I - File to read from */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+    void           *sax_data)		/* I - SAX user data */
+{
+  return (mxml_load_path(NULL, top, filename, cb, sax_cb, sax_data, 1));
+}
+
+
+/*
+ * 'mxmlSAXLoadString()' - Load a string into an XML node tree
+ *                         using a SAX callback.
+ *
+ * The nodes in the specified string are added to the specified top node.
+ * If no top node is provided, the XML string MUST be well-formed with a
+ * single parent node like <?xml> for the entire string. The callback
+ * function returns the value type that should be used for child nodes.
+ * The constants @code MXML_INTEGER_CALLBACK@, @code MXML_OPAQUE_CALLBACK@,
+ * @code MXML_REAL_CALLBACK@, and @code MXML_TEXT_CALLBACK@ are defined for
+ * loading child nodes of the specified type.
+ *
+ * The SAX callback must call @link mxmlRetain@ for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ *
+ * @since Mini-XML 2.3@
+ */
+
+mxml_node_t *				/* O - First node or @code NULL@ if the string has errors. */
+mxmlSAXLoadString(
+    mxml_node_t    *top,		/* I - Top node */
+    const char     *s,			/* I - String to load */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+    void           *sax_data)		/* I - SAX user data */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_string(&in, s);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_data(NULL, top, &in, cb, sax_cb, sax_data));
+}
+
+
+/*
+ * 'mxmlSAXParserNew()' - Create a push parser that loads XML data via a SAX
+ *                        callback.
+ *
+ * This function works like @link mxmlParserNew@ but calls the SAX callback
+ * for each node as it is loaded, as for @link mxmlSAXLoadString@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_parser_t *				/* O - New parser or @code NULL@ on error */
+mxmlSAXParserNew(
+    mxml_node_t    *top,		/* I - Top node */
+    mxml_load_cb_t cb,			/* I - Callback function or constant */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or @code MXML_NO_CALLBACK@ */
+    void           *sax_data)		/* I - SAX user data */
+{
+  mxml_parser_t	*parser;		/* New parser */
+
+
+  if ((parser = _mxml_calloc(1, sizeof(mxml_parser_t))) == NULL || (parser->data = _mxml_malloc(4096)) == NULL)
+  {
+    mxml_error("Unable to allocate memory for push parser.");
+    _mxml_free(parser);
+    return (NULL);
+  }
+
+  if (mxml_load_init(&parser->load, top, cb, sax_cb, sax_data))
+  {
+    _mxml_free(parser->data);
+    _mxml_free(parser);
+    return (NULL);
+  }
+
+  parser->datasize = 4096;
+
+  mxml_read_buffer(&parser->in, parser->data, 0);
+
+  parser->in.incomplete = 1;
+
+  return (parser);
+}
+
+
+/*
+ * 'mxmlSAXViewLoadBuffer()' - Load a memory buffer using a SAX view callback.
+ *
+ * No nodes are created.  Instead the callback gets the event, the element
+ * name, a @code NULL@-terminated list of attribute name/value pairs, and
+ * the text of data and CDATA nodes.  These strings are borrowed from the
+ * parser and are only valid until the callback returns.
+ *
+ * The name is @code NULL@ for data events, and the attribute list is empty
+ * except for @code MXML_SAX_ELEMENT_OPEN@ events.  Data is reported as for
+ * @code MXML_OPAQUE_CALLBACK@, one event for each run of text between
+ * markup, and text outside the root element is ignored.
+ *
+ * The buffer is read as for @link mxmlLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on error */
+mxmlSAXViewLoadBuffer(
+    const void         *data,		/* I - Buffer to load */
+    size_t             len,		/* I - Length of buffer in bytes */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_buffer(&in, data, len);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_views(&in, cb, cb_data));
+}
+
+
+/*
+ * 'mxmlSAXViewLoadFd()' - Load a file descriptor using a SAX view callback.
+ *
+ * The callback is used as for @link mxmlSAXViewLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on error */
+mxmlSAXViewLoadFd(
+    int                fd,		/* I - File descriptor to read from */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_init(&in, mxml_fd_read, &fd);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_views(&in, cb, cb_data));
+}
+
+
+/*
+ * 'mxmlSAXViewLoadFile()' - Load a file using a SAX view callback.
+ *
+ * The callback is used as for @link mxmlSAXViewLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on error */
+mxmlSAXViewLoadFile(
+    FILE               *fp,		/* I - File to read from */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_init(&in, mxml_file_read, fp);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_views(&in, cb, cb_data));
+}
+
+
+/*
+ * 'mxmlSAXViewLoadString()' - Load a string using a SAX view callback.
+ *
+ * The callback is used as for @link mxmlSAXViewLoadBuffer@.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on error */
+mxmlSAXViewLoadString(
+    const char         *s,		/* I - String to load */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  _mxml_read_t	in;			/* Input buffer */
+
+
+ /*
+  * Initialize the input buffer...
+  */
+
+  mxml_read_string(&in, s);
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_views(&in, cb, cb_data));
+}
+
+
+/*
+ * 'mxmlSetCompression()' - Set the compression used when saving files.
+ *
+ * The compression applies to the @link mxmlSaveFd@ and @link mxmlSaveFile@
+ * functions called from the current thread.  The default is
+ * @code MXML_COMPRESS_NONE@.  Compressed files are always detected and
+ * decompressed automatically when loaded, regardless of this setting.
+ *
+ * -1 is returned if the requested compression is not supported by this build
+ * of Mini-XML, in which case the setting is not changed.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 if not supported */
+mxmlSetCompression(
+    mxml_compress_t compression)	/* I - @code MXML_COMPRESS_NONE@, @code MXML_COMPRESS_GZIP@, or @code MXML_COMPRESS_ZSTD@ */
+{
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
+
+  switch (compression)
+  {
+    case MXML_COMPRESS_NONE :
+        break;
+
+    case MXML_COMPRESS_GZIP :
+#ifndef HAVE_LIBZ
+        mxml_error("gzip compression is not supported.");
+        return (-1);
+#else
+        break;
+#endif /* !HAVE_LIBZ */
+
+    case MXML_COMPRESS_ZSTD :
+#ifndef HAVE_LIBZSTD
+        mxml_error("Zstandard compression is not supported.");
+        return (-1);
+#else
+        break;
+#endif /* !HAVE_LIBZSTD */
+
+    default :
+        mxml_error("Bad compression %d.", (int)compression);
+        return (-1);
+  }
+
+  global->compression = compression;
+
+  return (0);
+}
+
+
+/*
+ * 'mxmlSetCustomHandlers()' - Set the handling functions for custom data.
+ *
+ * The load function accepts a node pointer and a data string and must
+ * return 0 on success and non-zero on error.
+ *
+ * The save function accepts a node pointer and must return a malloc'd
+ * string on success and @code NULL@ on error.
+ *
+ */
+
+void
+mxmlSetCustomHandlers(
+    mxml_custom_load_cb_t load,		/* I - Load function */
+    mxml_custom_save_cb_t save)		/* I - Save function */
+{
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
+
+  global->custom_load_cb = load;
+  global->custom_save_cb = save;
+}
+
+
+/*
+ * 'mxmlSetErrorCallback()' - Set the error message callback.
+ */
+
+void
+mxmlSetErrorCallback(mxml_error_cb_t cb)/* I - Error callback function */
+{
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
+
+  global->error_cb = cb;
+}
+
+
+/*
+ * 'mxmlSetWrapMargin()' - Set the wrap margin when saving XML data.
+ *
+ * Wrapping is disabled when "column" is 0.
+ *
+ * @since Mini-XML 2.3@
+ */
+
+void
+mxmlSetWrapMargin(int column)		/* I - Column for wrapping, 0 to disable wrapping */
+{
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
+
+  global->wrap = column;
+}
+
+
+/*
+ * 'mxmlTypeMapAdd()' - Add an element to a type map.
+ *
+ * The "name" string is matched against the element name or, when the map was
+ * created with an attribute name, against the value of that attribute.
+ * Adding a name that is already in the map replaces its type.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on error */
+mxmlTypeMapAdd(mxml_typemap_t *map,	/* I - Type map */
+               const char     *name,	/* I - Element name or attribute value */
+               mxml_type_t    type)	/* I - Child value type */
+{
+  _mxml_typeent_t	*ent,		/* Current entry */
+			*entries;	/* New hash table */
+  int			i,		/* Looping var */
+			alloc_entries;	/* New allocated entries */
+  unsigned		hash;		/* Hash of name */
+
+
+  if (!map || !name)
+    return (-1);
+
+ /*
+  * Keep the hash table at most half full...
+  */
+
+  if ((map->num_entries + 1) * 2 > map->alloc_entries)
+  {
+    alloc_entries = map->alloc_entries ? map->alloc_entries * 2 : 16;
+
+    if ((entries = _mxml_calloc((size_t)alloc_entries, sizeof(_mxml_typeent_t))) == NULL)
+    {
+      mxml_error("Unable to allocate memory for type map.");
+      return (-1);
+    }
+
+    for (i = map->alloc_entries, ent = map->entries; i > 0; i --, ent ++)
+    {
+      int j;				/* Index in new table */
+
+      if (!ent->name)
+        continue;
+
+      for (j = (int)ent->hash & (alloc_entries - 1); entries[j].name; j = (j + 1) & (alloc_entries - 1));
+
+      entries[j] = *ent;
+    }
+
+    _mxml_free(map->entries);
+
+    map->entries       = entries;
+    map->alloc_entries = alloc_entries;
+  }
+
+ /*
+  * Find the name or an empty slot...
+  */
+
+  hash = _mxml_strhash(name);
+
+  for (i = (int)hash & (map->alloc_entries - 1), ent = map->entries + i; ent->name; i = (i + 1) & (map->alloc_entries - 1), ent = map->entries + i)
+  {
+    if (ent->hash == hash && !strcmp(ent->name, name))
+    {
+      ent->type = type;
+      return (0);
+    }
+  }
+
+  if ((ent->name = _mxml_strdup(name)) == NULL)
+  {
+    mxml_error("Unable to allocate memory for type map.");
+    return (-1);
+  }
+
+  ent->hash = hash;
+  ent->type = type;
+
+  map->num_entries ++;
+
+  return (0);
+}
+
+
+/*
+ * 'mxmlTypeMapDelete()' - Delete a type map.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+void
+mxmlTypeMapDelete(mxml_typemap_t *map)	/* I - Type map */
+{
+  int			i;		/* Looping var */
+  _mxml_typeent_t	*ent;		/* Current entry */
+
+
+  if (!map)
+    return;
+
+  for (i = map->alloc_entries, ent = map->entries; i > 0; i --, ent ++)
+    _mxml_free(ent->name);
+
+  _mxml_free(map->entries);
+  _mxml_free(map->attr);
+  _mxml_free(map);
+}
+
+
+/*
+ * 'mxmlTypeMapNew()' - Create a type map for loading.
+ *
+ * A type map replaces a load callback that only compares the element name, or
+ * the value of one attribute, against a list of strings.  The map is hashed,
+ * so the child value type of each element is found without calling a
+ * function.  When "attr" is not @code NULL@, elements that have the named
+ * attribute are looked up using its value instead of the element name.
+ *
+ * The same map can be used for any number of loads and by several loaders
+ * at once, as long as it is not changed while in use.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_typemap_t *			/* O - New type map or @code NULL@ on error */
+mxmlTypeMapNew(const char *attr)	/* I - Attribute that selects the type or @code NULL@ for element names only */
+{
+  mxml_typemap_t	*map;		/* New type map */
+
+
+  if ((map = _mxml_calloc(1, sizeof(mxml_typemap_t))) == NULL)
+  {
+    mxml_error("Unable to allocate memory for type map.");
+    return (NULL);
+  }
+
+  if (attr && (map->attr = _mxml_strdup(attr)) == NULL)
+  {
+    mxml_error("Unable to allocate memory for type map.");
+    _mxml_free(map);
+    return (NULL);
+  }
+
+  return (map);
+}
+
+
+/*
+ * 'mxml_add_bytes()' - Add a run of UTF-8 bytes to a buffer, expanding as needed.
+ */
+
+static int				/* O  - 0 on success, -1 on error */
+mxml_add_bytes(const unsigned char *s,	/* I  - Bytes to add */
+               size_t              len,	/* I  - Number of bytes */
+               char                **bufptr,
+					/* IO - Current position in buffer */
+	       char                **buffer,
+					/* IO - Current buffer */
+	       int                 *bufsize)
+					/* IO - Current buffer size */
+{
+  char		*newbuffer;		/* New buffer value */
+  size_t	used;			/* Bytes used in buffer */
+
+
+  if ((used = (size_t)(*bufptr - *buffer)) + len > (size_t)(*bufsize - 4))
+  {
+   /*
+    * Increase the size of the buffer...
+    */
+
+    do
+    {
+      (*bufsize) *= 2;
+    }
+    while (used + len > (size_t)(*bufsize - 4));
+
+    if ((newbuffer = _mxml_realloc(*buffer, *bufsize)) == NULL)
+    {
+      mxml_error("Unable to expand string buffer to %d bytes!", *bufsize);
+
+      return (-1);
+    }
+
+    *bufptr = newbuffer + used;
+    *buffer = newbuffer;
+  }
+
+  memcpy(*bufptr, s, len);
+  *bufptr += len;
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_add_char()' - Add a character to a buffer, expanding as needed.
+ */
+
+static int				/* O  - 0 on success, -1 on error */
+mxml_add_char(int  ch,			/* I  - Character to add */
+              char **bufptr,		/* IO - Current position in buffer */
+	      char **buffer,		/* IO - Current buffer */
+	      int  *bufsize)		/* IO - Current buffer size */
+{
+  char	*newbuffer;			/* New buffer value */
+
+
+  if (*bufptr >= (*buffer + *bufsize - 4))
+  {
+   /*
+    * Increase the size of the buffer...
+    */
+
+    (*bufsize) *= 2;
+
+    if ((newbuffer = _mxml_realloc(*buffer, *bufsize)) == NULL)
+    {
+      mxml_error("Unable to expand string buffer to %d bytes!", *bufsize);
+
+      return (-1);
+    }
+
+    *bufptr = newbuffer + (*bufptr - *buffer);
+    *buffer = newbuffer;
+  }
+
+  if (ch < 0x80)
+  {
+   /*
+    * Single byte ASCII...
+    */
+
+    *(*bufptr)++ = ch;
+  }
+  else if (ch < 0x800)
+  {
+   /*
+    * Two-byte UTF-8...
+    */
+
+    *(*bufptr)++ = 0xc0 | (ch >> 6);
+    *(*bufptr)++ = 0x80 | (ch & 0x3f);
+  }
+  else if (ch < 0x10000)
+  {
+   /*
+    * Three-byte UTF-8...
+    */
+
+    *(*bufptr)++ = 0xe0 | (ch >> 12);
+    *(*bufptr)++ = 0x80 | ((ch >> 6) & 0x3f);
+    *(*bufptr)++ = 0x80 | (ch & 0x3f);
+  }
+  else
+  {
+   /*
+    * Four-byte UTF-8...
+    */
+
+    *(*bufptr)++ = 0xf0 | (ch >> 18);
+    *(*bufptr)++ = 0x80 | ((ch >> 12) & 0x3f);
+    *(*bufptr)++ = 0x80 | ((ch >> 6) & 0x3f);
+    *(*bufptr)++ = 0x80 | (ch & 0x3f);
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_add_run()' - Add a run of plain characters from the input buffer.
+ *
+ * The run ends at the first byte that is not allowed in the given scanning
+ * context or at the end of the current input block; the caller then resumes
+ * character-by-character processing with @code mxml_getc@.  Runs are only
+ * copied for UTF-8 input.  Non-ASCII characters are plain in every context,
+ * so the run continues through any that have been checked for valid UTF-8.
+ */
+
+static int				/* O  - 0 on success, -1 on error */
+mxml_add_run(_mxml_read_t *in,		/* I  - Input buffer */
+             int          scan,		/* I  - Scanning context (MXML_SCAN_xxx) */
+             char         **bufptr,	/* IO - Current position in buffer */
+	     char         **buffer,	/* IO - Current buffer */
+	     int          *bufsize,	/* IO - Current buffer size */
+	     int          *line)	/* IO - Current line number */
+{
+  const unsigned char	*start,		/* Start of run */
+			*ptr;		/* Pointer into run */
+
+
+  if (in->encoding != ENCODE_UTF8)
+    return (0);
+
+  for (start = ptr = in->current;;)
+  {
+    ptr = mxml_scan(ptr, in->end, scan, line);
+
+    if (ptr >= in->end || *ptr < 0x80 || (ptr >= in->valid && mxml_read_valid(in, ptr) == ptr))
+      break;
+
+    while (ptr < in->valid && *ptr >= 0x80)
+      ptr ++;
+  }
+
+  if (ptr == start)
+    return (0);
+
+  in->current = ptr;
+
+  return (mxml_add_bytes(start, (size_t)(ptr - start), bufptr, buffer, bufsize));
+}
+
+
+/*
+ * 'mxml_batch_error()' - Save the first error message for a batch file.
+ */
+
+static void
+mxml_batch_error(const char *message)	/* I - Error message */
+{
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
+
+  if (!global->error)
+    global->error = strdup(message);
+}
+
+
+/*
+ * 'mxml_batch_next()' - Claim the next file of a batch.
+ */
+
+static int				/* O - Index of file or -1 if none are left */
+mxml_batch_next(_mxml_batch_t *batch)	/* I - Batch load state */
+{
+  int	file;				/* File to load */
+
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&batch->mutex);
+#endif /* HAVE_PTHREAD_H */
+
+  if ((file = batch->next_file) < batch->num_files)
+    batch->next_file ++;
+  else
+    file = -1;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&batch->mutex);
+#endif /* HAVE_PTHREAD_H */
+
+  return (file);
+}
+
+
+#ifdef MXML_BATCH_READAHEAD
+/*
+ * 'mxml_batch_start()' - Start reading files until the read-ahead queue is full.
+ *
+ * Small regular files are read into memory using io_uring or POSIX AIO.
+ * Other files are left to the kernel's read-ahead and are loaded from the
+ * descriptor.  Errors are not reported here but when the file is loaded, so
+ * that they are attributed to the right file.
+ */
+
+static void
+mxml_batch_start(_mxml_batch_t  *batch,	/* I - Batch load state */
+                 _mxml_bqueue_t *q)	/* I - Read-ahead queue */
+{
+  _mxml_bfile_t	*bf;			/* Current file */
+  int		file;			/* Index of file */
+  struct stat	fileinfo;		/* File information */
+  int		submit = 0;		/* Number of reads to submit */
+#  ifdef HAVE_LIBURING
+  struct io_uring_sqe *sqe;		/* Submission queue entry */
+#  endif /* HAVE_LIBURING */
+
+
+  while (q->count < MXML_BATCH_DEPTH && (file = mxml_batch_next(batch)) >= 0)
+  {
+    bf = q->files + (q->first + q->count) % MXML_BATCH_DEPTH;
+    q->count ++;
+
+    memset(bf, 0, sizeof(_mxml_bfile_t));
+    bf->file = file;
+
+    if ((bf->fd = open(batch->filenames[file], O_RDONLY | O_BINARY)) < 0)
+      continue;
+
+    if (fstat(bf->fd, &fileinfo) || !S_ISREG(fileinfo.st_mode) || fileinfo.st_size <= 0)
+      continue;
+
+    if (q->async && fileinfo.st_size <= MXML_BATCH_MAX && (bf->data = _mxml_malloc((size_t)fileinfo.st_size)) != NULL)
+    {
+      bf->length = (size_t)fileinfo.st_size;
+
+#  ifdef HAVE_LIBURING
+      if ((sqe = io_uring_get_sqe(&q->ring)) != NULL)
+      {
+        io_uring_prep_read(sqe, bf->fd, bf->data, (unsigned)bf->length, 0);
+        io_uring_sqe_set_data(sqe, bf);
+
+        bf->pending = 1;
+        submit ++;
+        continue;
+      }
+
+#  elif defined(HAVE_AIO_H)
+      bf->aio.aio_fildes = bf->fd;
+      bf->aio.aio_buf    = bf->data;
+      bf->aio.aio_nbytes = bf->length;
+      bf->aio.aio_offset = 0;
+
+      if (!aio_read(&bf->aio))
+      {
+        bf->pending = 1;
+        submit ++;
+        continue;
+      }
+#  endif /* HAVE_LIBURING */
+
+      _mxml_free(bf->data);
+      bf->data = NULL;
+    }
+
+#  ifdef HAVE_POSIX_FADVISE
+    posix_fadvise(bf->fd, 0, 0, POSIX_FADV_WILLNEED);
+#  endif /* HAVE_POSIX_FADVISE */
+  }
+
+#  ifdef HAVE_LIBURING
+  if (submit)
+    io_uring_submit(&q->ring);
+#  else
+  (void)submit;
+#  endif /* HAVE_LIBURING */
+}
+
+
+/*
+ * 'mxml_batch_wait()' - Wait for a file to be read.
+ *
+ * On return "bf->data" holds the whole file or is @code NULL@ if the file must
+ * be loaded from its descriptor.
+ */
+
+static void
+mxml_batch_wait(_mxml_bqueue_t *q,	/* I - Read-ahead queue */
+                _mxml_bfile_t  *bf)	/* I - File */
+{
+  ssize_t	bytes;			/* Bytes read */
+#  ifdef HAVE_LIBURING
+  struct io_uring_cqe *cqe;		/* Completion queue entry */
+  struct io_uring_sqe *sqe;		/* Submission queue entry */
+  _mxml_bfile_t	*done;			/* Completed file */
+  int		canceled = 0;		/* Has the read been canceled? */
+#  elif defined(HAVE_AIO_H)
+  const struct aiocb *list[1];		/* Read to wait for */
+#  endif /* HAVE_LIBURING */
+
+
+#  ifdef HAVE_LIBURING
+ /*
+  * Reads complete in any order, so record each completion until this one
+  * is done...
+  */
+
+  while (bf->pending)
+  {
+    if ((bytes = io_uring_wait_cqe(&q->ring, &cqe)) == -EINTR)
+      continue;
+    else if (bytes < 0)
+    {
+      if (!canceled && (sqe = io_uring_get_sqe(&q->ring)) != NULL)
+      {
+       /*
+        * Cancel the read and wait for its completion, so that the buffer is
+        * not freed and the descriptor is not closed while the kernel may
+        * still use them...
+        */
+
+        io_uring_prep_cancel(sqe, bf, 0);
+        io_uring_sqe_set_data(sqe, NULL);
+        io_uring_submit(&q->ring);
+
+        canceled = 1;
+        continue;
+      }
+
+     /*
+      * The read can neither be canceled nor waited for, so leave the buffer
+      * and descriptor to it and load the file by name...
+      */
+
+      bf->data = NULL;
+      bf->fd   = -1;
+      return;
+    }
+
+    if ((done = (_mxml_bfile_t *)io_uring_cqe_get_data(cqe)) != NULL)
+    {
+      done->bytes   = cqe->res;
+      done->pending = 0;
+    }
+
+    io_uring_cqe_seen(&q->ring, cqe);
+  }
+
+#  elif defined(HAVE_AIO_H)
+  (void)q;
+
+  if (bf->pending)
+  {
+    list[0] = &bf->aio;
+
+    while (aio_error(&bf->aio) == EINPROGRESS)
+      aio_suspend(list, 1, NULL);
+
+    bf->bytes   = aio_return(&bf->aio);
+    bf->pending = 0;
+  }
+
+#  else
+  (void)q;
+#  endif /* HAVE_LIBURING */
+
+  if (!bf->data)
+    return;
+
+ /*
+  * Finish short reads synchronously...
+  */
+
+  while (bf->bytes >= 0 && (size_t)bf->bytes < bf->length)
+  {
+    if ((bytes = pread(bf->fd, bf->data + bf->bytes, bf->length - (size_t)bf->bytes, (off_t)bf->bytes)) > 0)
+      bf->bytes += bytes;
+#  ifdef EINTR
+    else if (bytes < 0 && errno == EINTR)
+      continue;
+#  endif /* EINTR */
+    else
+      break;
+  }
+
+  if (bf->bytes < 0 || (size_t)bf->bytes != bf->length)
+  {
+    _mxml_free(bf->data);
+    bf->data = NULL;
+  }
+}
+#endif /* MXML_BATCH_READAHEAD */
+
+
+/*
+ * 'mxml_batch_worker()' - Load files of a batch until none are left.
+ *
+ * The load state and its string buffers are reused for every file.  When
+ * read-ahead is available, up to MXML_BATCH_DEPTH files are read while the
+ * current file is parsed.
+ */
+
+static void *				/* O - Thread exit status (NULL) */
+mxml_batch_worker(void *data)		/* I - Batch load state */
+{
+  _mxml_batch_t	*batch = (_mxml_batch_t *)data;
+					/* Batch load state */
+  _mxml_global_t *global = _mxml_global(),
+					/* Global data */
+		saved = *global;	/* Saved global data */
+  _mxml_load_t	st,			/* Load state */
+		*stptr;			/* Load state to reuse or NULL */
+  int		file;			/* File to load */
+#ifdef MXML_BATCH_READAHEAD
+  _mxml_bqueue_t q;			/* Read-ahead queue */
+  _mxml_bfile_t	bf;			/* Current file */
+  _mxml_read_t	in;			/* Input buffer */
+#endif /* MXML_BATCH_READAHEAD */
+
+
+ /*
+  * Use the caller's entity, custom data, and error callbacks...
+  */
+
+  *global = batch->global;
+
+  if (mxml_load_init(&st, NULL, batch->cb, MXML_NO_CALLBACK, NULL))
+  {
+    stptr = NULL;
+  }
+  else
+  {
+    stptr   = &st;
+    st.keep = 1;
+  }
+
+#ifdef MXML_BATCH_READAHEAD
+  q.first = 0;
+  q.count = 0;
+#  ifdef HAVE_LIBURING
+  q.async = !io_uring_queue_init(MXML_BATCH_DEPTH, &q.ring, 0);
+#  elif defined(HAVE_AIO_H)
+  q.async = 1;
+#  else
+  q.async = 0;
+#  endif /* HAVE_LIBURING */
+
+  for (;;)
+  {
+    mxml_batch_start(batch, &q);
+
+    if (!q.count)
+      break;
+
+   /*
+    * Take the oldest file off the queue and start reading the next one
+    * before parsing it...
+    */
+
+    mxml_batch_wait(&q, q.files + q.first);
+
+    bf      = q.files[q.first];
+    q.first = (q.first + 1) % MXML_BATCH_DEPTH;
+    q.count --;
+    file    = bf.file;
+
+    mxml_batch_start(batch, &q);
+
+    if (bf.fd < 0)
+    {
+      batch->trees[file] = mxml_load_path(stptr, NULL, batch->filenames[file], batch->cb, MXML_NO_CALLBACK, NULL, 1);
+    }
+    else if (bf.data && mxml_compressed(bf.data, bf.length) == MXML_COMPRESS_NONE)
+    {
+      mxml_read_buffer(&in, bf.data, bf.length);
+
+      batch->trees[file] = mxml_load_data(stptr, NULL, &in, batch->cb, MXML_NO_CALLBACK, NULL);
+    }
+    else
+    {
+      batch->trees[file] = mxml_load_opened(stptr, NULL, bf.fd, batch->cb, MXML_NO_CALLBACK, NULL, 1);
+    }
+
+    _mxml_free(bf.data);
+
+    if (bf.fd >= 0)
+      close(bf.fd);
+
+#else
+  while ((file = mxml_batch_next(batch)) >= 0)
+  {
+    batch->trees[file] = mxml_load_path(stptr, NULL, batch->filenames[file], batch->cb, MXML_NO_CALLBACK, NULL, 1);
+#endif /* MXML_BATCH_READAHEAD */
+
+    if (batch->errors)
+    {
+      if (!batch->trees[file] && !global->error)
+        global->error = strdup("No XML data.");
+
+      batch->errors[file] = global->error;
+      global->error       = NULL;
+    }
+  }
+
+#ifdef HAVE_LIBURING
+  if (q.async)
+    io_uring_queue_exit(&q.ring);
+#endif /* HAVE_LIBURING */
+
+  if (stptr)
+    mxml_load_free(stptr);
+
+  *global = saved;
+
+  return (NULL);
+}
+
+
+/*
+ * 'mxml_compressed()' - Check for compressed data.
+ */
+
+static mxml_compress_t			/* O - Compression format */
+mxml_compressed(
+    const unsigned char *data,		/* I - Start of data */
+    size_t              len)		/* I - Length of data */
+{
+  if (len >= 2 && data[0] == 0x1f && data[1] == 0x8b)
+    return (MXML_COMPRESS_GZIP);
+  else if (len >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd)
+    return (MXML_COMPRESS_ZSTD);
+  else
+    return (MXML_COMPRESS_NONE);
+}
+
+
+/*
+ * 'mxml_fd_finish()' - Flush a file descriptor buffer and end compression.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_fd_finish(_mxml_fdbuf_t *buf)	/* I - File descriptor buffer */
+{
+  int	status;				/* Write status */
+
+
+  status = mxml_fd_write(buf);
+
+  if (buf->z)
+  {
+    if (!status)
+      status = mxml_zwrite(buf, NULL, 0, 1);
+
+    mxml_zstream_delete(buf->z);
+    buf->z = NULL;
+  }
+
+  return (status);
+}
+
+
+/*
+ * 'mxml_fd_output()' - Write data to the file or file descriptor.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_fd_output(
+    _mxml_fdbuf_t       *buf,		/* I - File descriptor buffer */
+    const unsigned char *data,		/* I - Data to write */
+    size_t              len)		/* I - Number of bytes */
+{
+  int			bytes;		/* Bytes written */
+  const unsigned char	*ptr,		/* Pointer into data */
+			*end;		/* End of data */
+
+
+  if (buf->fp)
+    return (fwrite(data, 1, len, buf->fp) == len ? 0 : -1);
+
+ /*
+  * Loop until we have written everything...
+  */
+
+  for (ptr = data, end = data + len; ptr < end; ptr += bytes)
+    if ((bytes = (int)write(buf->fd, ptr, (size_t)(end - ptr))) < 0)
+      return (-1);
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_fd_putc()' - Write a character to a file descriptor.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_fd_putc(int  ch,			/* I - Character */
+             void *p)			/* I - File descriptor buffer */
+{
+  _mxml_fdbuf_t	*buf;			/* File descriptor buffer */
+
+
+ /*
+  * Flush the write buffer as needed...
+  */
+
+  buf = (_mxml_fdbuf_t *)p;
+
+  if (buf->current >= buf->end)
+    if (mxml_fd_write(buf) < 0)
+      return (-1);
+
+  *(buf->current)++ = ch;
+
+ /*
+  * Return successfully...
+  */
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_fd_read()' - Read a buffer of data from a file descriptor.
+ */
+
+static int				/* O - Bytes read, 0 on EOF, -1 on error */
+mxml_fd_read(void   *p,			/* I - Pointer to file descriptor */
+             void   *buffer,		/* I - Buffer */
+             size_t bytes)		/* I - Size of buffer */
+{
+  int	fd;				/* File descriptor */
+  int	count;				/* Bytes read... */
+
+
+ /*
+  * Read from the file descriptor...
+  */
+
+  fd = *((int *)p);
+
+  while ((count = (int)read(fd, buffer, bytes)) < 0)
+#ifdef EINTR
+    if (errno != EAGAIN && errno != EINTR)
+#else
+    if (errno != EAGAIN)
+#endif /* EINTR */
+      return (-1);
+
+  return (count);
+}
+
+
+/*
+ * 'mxml_fd_write()' - Write a buffer of data to a file descriptor.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_fd_write(_mxml_fdbuf_t *buf)	/* I - File descriptor buffer */
+{
+  int		status;			/* Write status */
+
+
+ /*
+  * Range check...
+  */
+
+  if (!buf)
+    return (-1);
+
+ /*
+  * Return 0 if there is nothing to write...
+  */
+
+  if (buf->current == buf->buffer)
+    return (0);
+
+ /*
+  * Write everything, compressing as needed...
+  */
+
+  if (buf->z)
+    status = mxml_zwrite(buf, buf->buffer, (size_t)(buf->current - buf->buffer), 0);
+  else
+    status = mxml_fd_output(buf, buf->buffer, (size_t)(buf->current - buf->buffer));
+
+ /*
+  * All done, reset pointers and return...
+  */
+
+  buf->current = buf->buffer;
+
+  return (status);
+}
+
+
+/*
+ * 'mxml_file_putc()' - Write a character to a file.
+ */
+
+static int				/* O - 0 on success, -1 on failure */
+mxml_file_putc(int  ch,			/* I - Character to write */
+               void *p)			/* I - Pointer to file */
+{
+  return (putc(ch, (FILE *)p) == EOF ? -1 : 0);
+}
+
+
+/*
+ * 'mxml_file_read()' - Read a buffer of data from a file.
+ */
+
+static int				/* O - Bytes read, 0 on EOF, -1 on error */
+mxml_file_read(void   *p,		/* I - Pointer to file */
+               void   *buffer,		/* I - Buffer */
+               size_t bytes)		/* I - Size of buffer */
+{
+  size_t	count;			/* Bytes read */
+
+
+  if ((count = fread(buffer, 1, bytes, (FILE *)p)) == 0 && ferror((FILE *)p))
+    return (-1);
+
+  return ((int)count);
+}
+
+
+#ifdef HAVE_PTHREAD_H
+/*
+ * 'mxml_ignore_error()' - Ignore an error message from a parallel load worker.
+ *
+ * Segments with errors are loaded again sequentially to report the error.
+ */
+
+static void
+mxml_ignore_error(const char *message)	/* I - Error message */
+{
+  (void)message;
+}
+#endif /* HAVE_PTHREAD_H */
+
+
+/*
+ * 'mxml_get_entity()' - Get the character corresponding to an entity...
+ */
+
+static int				/* O  - Character value or EOF on error */
+mxml_get_entity(mxml_node_t  *parent,	/* I  - Parent node */
+		_mxml_read_t *in,	/* I  - Input buffer */
+                int          *line)	/* IO - Current line number */
+{
+  int	ch;				/* Current character */
+  char	entity[64],			/* Entity string */
+	*entptr;			/* Pointer into entity */
+
+
+  entptr = entity;
+
+  while ((ch = mxml_getc(in)) != EOF)
+  {
+    if (ch > 126 || (!isalnum(ch) && ch != '#'))
+      break;
+    else if (entptr < (entity + sizeof(entity) - 1))
+      *entptr++ = ch;
+    else
+    {
+      mxml_error("Entity name too long under parent <%s> on line %d.", parent ? parent->value.element.name : "null", *line);
+      break;
+    }
+  }
+
+  *entptr = '\0';
+
+  if (ch != ';')
+  {
+    mxml_error("Character entity '%s' not terminated under parent <%s> on line %d.", entity, parent ? parent->value.element.name : "null", *line);
+
+    if (ch == '\n')
+      (*line)++;
+
+    return (EOF);
+  }
+
+ /*
+  * Decode character references and the predefined XML entities directly and
+  * look up everything else...
+  */
+
+  if (entity[0] == '#')
+  {
+    if (entity[1] == 'x')
+      ch = (int)strtol(entity + 2, NULL, 16);
+    else
+      ch = (int)strtol(entity + 1, NULL, 10);
+  }
+  else if (!strcmp(entity, "lt"))
+    ch = '<';
+  else if (!strcmp(entity, "gt"))
+    ch = '>';
+  else if (!strcmp(entity, "amp"))
+    ch = '&';
+  else if (!strcmp(entity, "quot"))
+    ch = '\"';
+  else if (!strcmp(entity, "apos"))
+    ch = '\'';
+  else if ((ch = mxmlEntityGetValue(entity)) < 0)
+    mxml_error("Entity name '%s;' not supported under parent <%s> on line %d.", entity, parent ? parent->value.element.name : "null", *line);
+
+  if (mxml_bad_char(ch))
+  {
+    mxml_error("Bad control character 0x%02x under parent <%s> on line %d not allowed by XML standard.", ch, parent ? parent->value.element.name : "null", *line);
+    return (EOF);
+  }
+
+  return (ch);
+}
+
+
+/*
+ * 'mxml_has_attr()' - Determine whether a newly loaded element has an attribute.
+ *
+ * Both the attributes of the element and the attributes that are saved for
+ * mxml_new_attrs are checked.
+ */
+
+static int				/* O - 1 if the attribute exists, 0 otherwise */
+mxml_has_attr(_mxml_load_t *st,		/* I - Load state */
+              mxml_node_t  *node,	/* I - Element node */
+              const char   *name)	/* I - Attribute name */
+{
+  int		i;			/* Looping var */
+
+
+  if (mxmlElementGetAttr(node, name))
+    return (1);
+
+  for (i = 0; i < st->num_attrs; i ++)
+    if (!strcmp(st->pairs[i], name))
+      return (1);
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_load_data()' - Load data into an XML node tree.
+ */
+
+static mxml_node_t *			/* O - First node or NULL if the file could not be read. */
+mxml_load_data(
+    _mxml_load_t    *st,		/* I - Reused load state or NULL */
+    mxml_node_t     *top,		/* I - Top node */
+    _mxml_read_t    *in,		/* I - Input buffer */
+    mxml_load_cb_t  cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t   sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void            *sax_data)		/* I - SAX user data */
+{
+  _mxml_load_t	temp;			/* Temporary load state */
+  mxml_node_t	*tree = NULL;		/* Loaded tree */
+
+
+  if (!st)
+  {
+    st = &temp;
+
+    if (mxml_load_init(st, top, cb, sax_cb, sax_data))
+      return (NULL);
+  }
+  else if (mxml_load_reset(st, top, cb, sax_cb, sax_data))
+    return (NULL);
+
+  mxml_load_more(st, in, &tree);
+  mxml_read_free(in);
+
+  return (tree);
+}
+
+
+/*
+ * 'mxml_load_event()' - Report a loaded node to the SAX or SAX view callback.
+ *
+ * Nodes passed to a SAX view callback are reused by the next event, so 0 is
+ * returned for everything but open elements, just like a released node.
+ */
+
+static int				/* O - 0 if the node was released, non-zero otherwise */
+mxml_load_event(_mxml_load_t     *st,	/* I - Load state */
+                mxml_node_t      *node,	/* I - Loaded node */
+                mxml_sax_event_t event)	/* I - SAX event */
+{
+  _mxml_views_t	*views;			/* SAX view buffers */
+  const char	*name = NULL,		/* Element name */
+		*text = NULL;		/* Data or CDATA text */
+  size_t	textlen = 0;		/* Length of text */
+  const char * const *attrs;		/* Attribute name/value pairs */
+  int		i;			/* Looping var */
+  static const char * const noattrs[1] = { NULL };
+					/* Empty attribute list */
+
+
+  if ((views = st->views) == NULL)
+  {
+    if (!st->sax_cb)
+      return (1);
+
+    (*st->sax_cb)(node, event, st->sax_data);
+
+    if (event == MXML_SAX_ELEMENT_OPEN)
+      return (1);
+    else
+      return (mxmlRelease(node));
+  }
+
+  if (!node)
+    return (0);
+
+  attrs = noattrs;
+
+  if (event == MXML_SAX_DATA)
+  {
+    text    = node->value.opaque;
+    textlen = views->textlen;
+  }
+  else
+  {
+    name = node->value.element.name;
+
+    if (event == MXML_SAX_CDATA)
+    {
+      text    = name + 8;
+      textlen = strlen(text);
+    }
+    else if (event == MXML_SAX_ELEMENT_OPEN && node->num_attrs > 0)
+    {
+      for (i = 0; i < node->num_attrs; i ++)
+      {
+        views->pairs[2 * i]     = views->attrs[i].name;
+        views->pairs[2 * i + 1] = views->attrs[i].value;
+      }
+
+      views->pairs[2 * i] = NULL;
+      attrs               = views->pairs;
+    }
+  }
+
+  (*views->cb)(event, name, attrs, text, textlen, views->data);
+
+  if (event == MXML_SAX_ELEMENT_OPEN)
+  {
+   /*
+    * Drop the attribute strings but keep the name for the close tag...
+    */
+
+    views->strused  = (size_t)(name - views->strings) + strlen(name) + 1;
+    node->num_attrs = 0;
+
+    return (1);
+  }
+  else if (event == MXML_SAX_ELEMENT_CLOSE)
+    views->strused = (size_t)(name - views->strings);
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_load_free()' - Free the string buffers of the load state.
+ */
+
+static void
+mxml_load_free(_mxml_load_t *st)	/* I - Load state */
+{
+  _mxml_free(st->buffer);
+  _mxml_free(st->name);
+  _mxml_free(st->value);
+  _mxml_free(st->attrs);
+  _mxml_free(st->pairs);
+
+  st->buffer = NULL;
+  st->name   = NULL;
+  st->value  = NULL;
+  st->attrs  = NULL;
+  st->pairs  = NULL;
+}
+
+
+/*
+ * 'mxml_load_init()' - Initialize the load state.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_load_init(
+    _mxml_load_t    *st,		/* I - Load state */
+    mxml_node_t     *top,		/* I - Top node */
+    mxml_load_cb_t  cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t   sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void            *sax_data)		/* I - SAX user data */
+{
+  st->buffer   = NULL;
+  st->name     = NULL;
+  st->value    = NULL;
+  st->namesize = 0;
+  st->valsize  = 0;
+  st->keep     = 0;
+  st->typemap  = NULL;
+  st->arena    = 0;
+
+  st->attrs       = NULL;
+  st->attrsize    = 0;
+  st->attrused    = 0;
+  st->pairs       = NULL;
+  st->num_attrs   = 0;
+  st->alloc_attrs = 0;
+
+  return (mxml_load_reset(st, top, cb, sax_cb, sax_data));
+}
+
+
+/*
+ * 'mxml_load_reset()' - Reset the load state for a new document.
+ *
+ * The string buffers of a previous load are reused when the load state is
+ * marked to keep them.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_load_reset(
+    _mxml_load_t    *st,		/* I - Load state */
+    mxml_node_t     *top,		/* I - Top node */
+    mxml_load_cb_t  cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t   sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void            *sax_data)		/* I - SAX user data */
+{
+  if (!st->buffer)
+  {
+    if ((st->buffer = _mxml_malloc(64)) == NULL)
+    {
+      mxml_error("Unable to allocate string buffer!");
+      return (-1);
+    }
+
+    st->bufsize = 64;
+  }
+
+  st->top        = top;
+  st->first      = NULL;
+  st->parent     = top;
+  st->cb         = cb;
+  st->sax_cb     = sax_cb;
+  st->sax_data   = sax_data;
+  st->line       = 1;
+  st->whitespace = 0;
+  st->pause      = 0;
+  st->bufptr     = st->buffer;
+  st->views      = NULL;
+
+  if (top)
+    st->type = mxml_load_type(st, top);
+  else
+    st->type = MXML_IGNORE;
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_load_more()' - Load more data into an XML node tree.
+ *
+ * When the input buffer is marked incomplete, loading stops in front of the
+ * first character, entity, or markup that is not fully buffered and 0 is
+ * returned; call again with more data to continue.  Otherwise the load
+ * state is freed, "tree" is set to the loaded tree (NULL on error), and the
+ * result is 1 on success or -1 on error.
+ */
+
+static int				/* O - 1 when done, 0 if more input is needed, -1 on error */
+mxml_load_more(_mxml_load_t *st,	/* I - Load state */
+               _mxml_read_t *in,	/* I - Input buffer */
+               mxml_node_t  **tree)	/* O - Loaded tree */
+{
+  mxml_node_t	*node,			/* Current node */
+		*top = st->top,		/* Top node */
+		*first = st->first,	/* First node added */
+		*parent = st->parent;	/* Current parent node */
+  mxml_load_cb_t cb = st->cb;		/* Load callback */
+  int		line = st->line,	/* Current line number */
+		ch,			/* Character from file */
+		whitespace = st->whitespace;
+					/* Non-zero if whitespace seen */
+  char		*buffer = st->buffer,	/* String buffer */
+		*bufptr = st->bufptr;	/* Pointer into buffer */
+  int		bufsize = st->bufsize;	/* Size of buffer */
+  mxml_type_t	type = st->type;	/* Current node type */
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+  static const char * const types[] =	/* Type strings... */
+		{
+		  "MXML_ELEMENT",	/* XML element with attributes */
+		  "MXML_INTEGER",	/* Integer value */
+		  "MXML_OPAQUE",	/* Opaque string */
+		  "MXML_REAL",		/* Real value */
+		  "MXML_TEXT",		/* Text fragment */
+		  "MXML_CUSTOM"		/* Custom data */
+		};
+
+
+ /*
+  * Read elements and other nodes from the file...
+  */
+
+  in->line   = &line;
+  in->parent = &parent;
+
+  for (;;)
+  {
+    if (st->pause || (in->incomplete && mxml_read_partial(in)))
+    {
+     /*
+      * Save the state and wait for the caller or the rest of the input...
+      */
+
+      in->line       = NULL;
+      in->parent     = NULL;
+      st->first      = first;
+      st->parent     = parent;
+      st->type       = type;
+      st->line       = line;
+      st->whitespace = whitespace;
+      st->buffer     = buffer;
+      st->bufptr     = bufptr;
+      st->bufsize    = bufsize;
+
+      return (0);
+    }
+
+    if ((ch = mxml_getc(in)) == EOF)
+      break;
+
+    if ((ch == '<' ||
+         (mxml_isspace(ch) && type != MXML_OPAQUE && type != MXML_CUSTOM)) &&
+        bufptr > buffer)
+    {
+     /*
+      * Add a new value node...
+      */
+
+      *bufptr = '\0';
+
+      switch (type)
+      {
+	case MXML_INTEGER :
+            node = mxmlNewInteger64(parent, _mxml_strtoll(buffer, &bufptr));
+	    break;
+
+	case MXML_OPAQUE :
+            node = mxml_new_string(st, in, parent, MXML_OPAQUE, 0, buffer);
+	    break;
+
+	case MXML_REAL :
+            node = mxmlNewReal(parent, _mxml_strtod(buffer, &bufptr));
+	    break;
+
+	case MXML_TEXT :
+            node = mxml_new_string(st, in, parent, MXML_TEXT, whitespace, buffer);
+	    break;
+
+	case MXML_CUSTOM :
+	    if (global->custom_load_cb)
+	    {
+	     /*
+	      * Use the callback to fill in the custom data...
+	      */
+
+              node = mxmlNewCustom(parent, NULL, NULL);
+
+	      if ((*global->custom_load_cb)(node, buffer))
+	      {
+	        mxml_error("Bad custom value '%s' in parent <%s> on line %d.", buffer, parent ? parent->value.element.name : "null", line);
+		mxmlDelete(node);
+		node = NULL;
+	      }
+	      break;
+	    }
+
+        default : /* Ignore... */
+	    node = NULL;
+	    break;
+      }
+
+      if (*bufptr)
+      {
+       /*
+        * Bad integer/real number value...
+	*/
+
+        mxml_error("Bad %s value '%s' in parent <%s> on line %d.", type == MXML_INTEGER ? "integer" : "real", buffer, parent ? parent->value.element.name : "null", line);
+	break;
+      }
+
+      bufptr     = buffer;
+      whitespace = mxml_isspace(ch) && type == MXML_TEXT;
+
+      if (!node && type != MXML_IGNORE)
+      {
+       /*
+	* Print error and return...
+	*/
+
+	mxml_error("Unable to add value node of type %s to parent <%s> on line %d.", types[type], parent ? parent->value.element.name : "null", line);
+	goto error;
+      }
+
+      if (!mxml_load_event(st, node, MXML_SAX_DATA))
+        node = NULL;
+
+      if (!first && node)
+        first = node;
+    }
+    else if (mxml_isspace(ch) && type == MXML_TEXT)
+      whitespace = 1;
+
+    if (ch == '\n')
+      line ++;
+
+   /*
+    * Add lone whitespace node if we have an element and existing
+    * whitespace...
+    */
+
+    if (ch == '<' && whitespace && type == MXML_TEXT)
+    {
+      if (parent)
+      {
+	node = mxml_new_string(st, in, parent, MXML_TEXT, whitespace, "");
+
+	if (!mxml_load_event(st, node, MXML_SAX_DATA))
+	  node = NULL;
+
+	if (!first && node)
+	  first = node;
+      }
+
+      whitespace = 0;
+    }
+
+    if (ch == '<')
+    {
+     /*
+      * Start of open/close tag...
+      */
+
+      bufptr = buffer;
+
+      while ((ch = mxml_getc(in)) != EOF)
+      {
+        if (mxml_isspace(ch) || ch == '>' || (ch == '/' && bufptr > buffer))
+	  break;
+	else if (ch == '<')
+	{
+	  mxml_error("Bare < in element!");
+	  goto error;
+	}
+	else if (ch == '&')
+	{
+	  if ((ch = mxml_get_entity(parent, in, &line)) == EOF)
+	    goto error;
+
+	  if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
+	    goto error;
+	}
+	else if (ch < '0' && ch != '!' && ch != '-' && ch != '.' && ch != '/')
+	  goto error;
+	else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
+	  goto error;
+	else if (((bufptr - buffer) == 1 && buffer[0] == '?') ||
+	         ((bufptr - buffer) == 3 && !strncmp(buffer, "!--", 3)) ||
+	         ((bufptr - buffer) == 8 && !strncmp(buffer, "![CDATA[", 8)))
+	  break;
+	else if (buffer[0] != '!' && mxml_add_run(in, MXML_SCAN_NAME, &bufptr, &buffer, &bufsize, &line))
+	  goto error;
+
+	if (ch == '\n')
+	  line ++;
+      }
+
+      *bufptr = '\0';
+
+      if (!strcmp(buffer, "!--"))
+      {
+       /*
+        * Gather rest of comment...
+	*/
+
+	while ((ch = mxml_getc(in)) != EOF)
+	{
+	  if (ch == '>' && bufptr > (buffer + 4) &&
+	      bufptr[-3] != '-' && bufptr[-2] == '-' && bufptr[-1] == '-')
+	    break;
+	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize) ||
+	           mxml_add_run(in, MXML_SCAN_MARKUP, &bufptr, &buffer, &bufsize, &line))
+	    goto error;
+
+	  if (ch == '\n')
+	    line ++;
+	}
+
+       /*
+        * Error out if we didn't get the whole comment...
+	*/
+
+        if (ch != '>')
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Early EOF in comment node on line %d.", line);
+	  goto error;
+	}
+
+
+       /*
+        * Otherwise add this as an element under the current parent...
+	*/
+
+	*bufptr = '\0';
+
+        if (!parent && first)
+	{
+	 /*
+	  * There can only be one root element!
+	  */
+
+	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
+          goto error;
+	}
+
+	if ((node = mxml_new_string(st, in, parent, MXML_ELEMENT, 0, buffer)) == NULL)
+	{
+	 /*
+	  * Just print error for now...
+	  */
+
+	  mxml_error("Unable to add comment node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
+	  break;
+	}
+
+        if (!mxml_load_event(st, node, MXML_SAX_COMMENT))
+          node = NULL;
+
+	if (node && !first)
+	  first = node;
+      }
+      else if (!strcmp(buffer, "![CDATA["))
+      {
+       /*
+        * Gather CDATA section...
+	*/
+
+	while ((ch = mxml_getc(in)) != EOF)
+	{
+	  if (ch == '>' && !strncmp(bufptr - 2, "]]", 2))
+	  {
+	   /*
+	    * Drop terminator from CDATA string...
+	    */
+
+	    bufptr[-2] = '\0';
+	    break;
+	  }
+	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize) ||
+	           mxml_add_run(in, MXML_SCAN_MARKUP, &bufptr, &buffer, &bufsize, &line))
+	    goto error;
+
+	  if (ch == '\n')
+	    line ++;
+	}
+
+       /*
+        * Error out if we didn't get the whole comment...
+	*/
+
+        if (ch != '>')
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Early EOF in CDATA node on line %d.", line);
+	  goto error;
+	}
+
+
+       /*
+        * Otherwise add this as an element under the current parent...
+	*/
+
+	*bufptr = '\0';
+
+        if (!parent && first)
+	{
+	 /*
+	  * There can only be one root element!
+	  */
+
+	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
+          goto error;
+	}
+
+	if ((node = mxml_new_string(st, in, parent, MXML_ELEMENT, 0, buffer)) == NULL)
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Unable to add CDATA node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
+	  goto error;
+	}
+
+        if (!mxml_load_event(st, node, MXML_SAX_CDATA))
+          node = NULL;
+
+	if (node && !first)
+	  first = node;
+      }
+      else if (buffer[0] == '?')
+      {
+       /*
+        * Gather rest of processing instruction...
+	*/
+
+	while ((ch = mxml_getc(in)) != EOF)
+	{
+	  if (ch == '>' && bufptr > buffer && bufptr[-1] == '?')
+	    break;
+	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize) ||
+	           mxml_add_run(in, MXML_SCAN_MARKUP, &bufptr, &buffer, &bufsize, &line))
+	    goto error;
+
+	  if (ch == '\n')
+	    line ++;
+	}
+
+       /*
+        * Error out if we didn't get the whole processing instruction...
+	*/
+
+        if (ch != '>')
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Early EOF in processing instruction node on line %d.", line);
+	  goto error;
+	}
+
+       /*
+        * Otherwise add this as an element under the current parent...
+	*/
+
+	*bufptr = '\0';
+
+        if (!parent && first)
+	{
+	 /*
+	  * There can only be one root element!
+	  */
+
+	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
+          goto error;
+	}
+
+	if ((node = mxml_new_string(st, in, parent, MXML_ELEMENT, 0, buffer)) == NULL)
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Unable to add processing instruction node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
+	  goto error;
+	}
+
+        if (!mxml_load_event(st, node, MXML_SAX_DIRECTIVE))
+          node = NULL;
+
+        if (node)
+	{
+	  if (!first)
+            first = node;
+
+	  if (!parent)
+	  {
+	    parent = node;
+	    type   = mxml_load_type(st, parent);
+	  }
+	}
+      }
+      else if (buffer[0] == '!')
+      {
+       /*
+        * Gather rest of declaration...
+	*/
+
+	do
+	{
+	  if (ch == '>')
+	    break;
+	  else
+	  {
+            if (ch == '&')
+            {
+	      if ((ch = mxml_get_entity(parent, in, &line)) == EOF)
+		goto error;
+            }
+
+	    if (mxml_add_char(ch, &bufptr, &buffer, &bufsize) ||
+	        mxml_add_run(in, MXML_SCAN_MARKUP, &bufptr, &buffer, &bufsize, &line))
+	      goto error;
+	  }
+
+	  if (ch == '\n')
+	    line ++;
+	}
+        while ((ch = mxml_getc(in)) != EOF);
+
+       /*
+        * Error out if we didn't get the whole declaration...
+	*/
+
+        if (ch != '>')
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Early EOF in declaration node on line %d.", line);
+	  goto error;
+	}
+
+       /*
+        * Otherwise add this as an element under the current parent...
+	*/
+
+	*bufptr = '\0';
+
+        if (!parent && first)
+	{
+	 /*
+	  * There can only be one root element!
+	  */
+
+	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
+          goto error;
+	}
+
+	if ((node = mxml_new_string(st, in, parent, MXML_ELEMENT, 0, buffer)) == NULL)
+	{
+	 /*
+	  * Print error and return...
+	  */
+
+	  mxml_error("Unable to add declaration node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
+	  goto error;
+	}
+
+        if (!mxml_load_event(st, node, MXML_SAX_DIRECTIVE))
+          node = NULL;
+
+        if (node)
+	{
+	  if (!first)
+            first = node;
+
+	  if (!parent)
+	  {
+	    parent = node;
+	    type   = mxml_load_type(st, parent);
+	  }
+	}
+      }
+      else if (buffer[0] == '/')
+      {
+       /*
+        * Handle close tag...
+	*/
+
+        if (!parent || strcmp(buffer + 1, parent->value.element.name))
+	{
+	 /*
+	  * Close tag doesn't match tree; print an error for now...
+	  */
+
+	  mxml_error("Mismatched close tag <%s> under parent <%s> on line %d.", buffer, parent ? parent->value.element.name : "(null)", line);
+          goto error;
+	}
+
+       /*
+        * Keep reading until we see >...
+	*/
+
+        while (ch != '>' && ch != EOF)
+	  ch = mxml_getc(in);
+
+        node   = parent;
+        parent = parent->parent;
+
+        if (!mxml_load_event(st, node, MXML_SAX_ELEMENT_CLOSE) && first == node)
+	  first = NULL;
+
+       /*
+	* Ascend into the parent and set the value type as needed...
+	*/
+
+	if ((cb || st->typemap) && parent)
+	  type = mxml_load_type(st, parent);
+      }
+      else
+      {
+       /*
+        * Handle open tag...
+	*/
+
+        if (!parent && first)
+	{
+	 /*
+	  * There can only be one root element!
+	  */
+
+	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
+          goto error;
+	}
+
+        if ((node = mxml_new_element(st, in, parent, buffer)) == NULL)
+	{
+	 /*
+	  * Just print error for now...
+	  */
+
+	  mxml_error("Unable to add element node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
+	  goto error;
+	}
+
+        if (mxml_isspace(ch))
+        {
+	  if ((ch = mxml_parse_element(st, node, in, &line)) == EOF)
+	  {
+	    if (!st->views)
+              mxmlDelete(node);
+
+	    goto error;
+	  }
+        }
+        else if (ch == '/')
+	{
+	  if ((ch = mxml_getc(in)) != '>')
+	  {
+	    mxml_error("Expected > but got '%c' instead for element <%s/> on line %d.", ch, buffer, line);
+
+	    if (!st->views)
+              mxmlDelete(node);
+
+            goto error;
+	  }
+
+	  ch = '/';
+	}
+
+        mxml_load_event(st, node, MXML_SAX_ELEMENT_OPEN);
+
+        if (!first)
+	  first = node;
+
+	if (ch == EOF)
+	  break;
+
+        if (ch != '/')
+	{
+	 /*
+	  * Descend into this node, setting the value type as needed...
+	  */
+
+	  parent = node;
+	  type   = mxml_load_type(st, parent);
+	}
+        else if (!mxml_load_event(st, node, MXML_SAX_ELEMENT_CLOSE) && first == node)
+          first = NULL;
+      }
+
+      bufptr  = buffer;
+    }
+    else if (ch == '&')
+    {
+     /*
+      * Add character entity to current buffer...
+      */
+
+      if ((ch = mxml_get_entity(parent, in, &line)) == EOF)
+	goto error;
+
+      if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
+	goto error;
+    }
+    else if (type == MXML_OPAQUE || type == MXML_CUSTOM || !mxml_isspace(ch))
+    {
+     /*
+      * Add character to current buffer, followed by any run of plain
+      * characters that can be copied directly from the input buffer...
+      */
+
+      if (mxml_add_char(ch, &bufptr, &buffer, &bufsize) ||
+          mxml_add_run(in, (type == MXML_OPAQUE || type == MXML_CUSTOM) ? MXML_SCAN_OPAQUE : MXML_SCAN_TEXT, &bufptr, &buffer, &bufsize, &line))
+	goto error;
+    }
+  }
+
+ /*
+  * Stop if the input ended because of a bad character inside an element.
+  * Outside of the root element the bad character just ends the input, as
+  * it always has...
+  */
+
+  in->line   = NULL;
+  in->parent = NULL;
+
+  if (in->error && parent != top)
+    goto error;
+
+ /*
+  * Free the string buffers - we don't need them anymore...
+  */
+
+  st->buffer  = buffer;
+  st->bufsize = bufsize;
+
+  if (!st->keep)
+    mxml_load_free(st);
+
+ /*
+  * Find the top element and return it...
+  */
+
+  st->line = line;
+
+  if (parent)
+  {
+    node = parent;
+
+    while (parent != top && parent->parent)
+      parent = parent->parent;
+
+    if (node != parent)
+    {
+      mxml_error("Missing close tag </%s> under parent <%s> on line %d.", node->value.element.name, node->parent ? node->parent->value.element.name : "(null)", line);
+
+      if (!st->views)
+        mxmlDelete(first);
+
+      *tree = NULL;
+
+      return (-1);
+    }
+  }
+
+  if (st->views)
+    *tree = NULL;
+  else if (parent)
+    *tree = parent;
+  else
+    *tree = first;
+
+  return (1);
+
+ /*
+  * Common error return...
+  */
+
+  error:
+
+  in->line   = NULL;
+  in->parent = NULL;
+
+  if (!st->views)
+    mxmlDelete(first);
+
+  st->buffer  = buffer;
+  st->bufsize = bufsize;
+
+  if (!st->keep)
+    mxml_load_free(st);
+
+  *tree = NULL;
+
+  return (-1);
+}
+
+
+/*
+ * 'mxml_load_parallel()' - Load a memory buffer using several threads.
+ *
+ * The prolog and root start tag are loaded first, then the segments between
+ * the children of the root element are loaded into copies of the root
+ * element by a pool of threads.  The loaded children are moved under the
+ * root element in order and the rest of the buffer is loaded sequentially.
+ */
+
+static mxml_node_t *			/* O - First node or NULL on error */
+mxml_load_parallel(
+    mxml_node_t    *top,		/* I - Top node */
+    const void     *data,		/* I - Buffer to load */
+    size_t         len,			/* I - Length of buffer in bytes */
+    mxml_load_cb_t cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    int            threads)		/* I - Number of threads or 0 for one per CPU */
+{
+  _mxml_read_t		in;		/* Input buffer */
+#ifdef HAVE_PTHREAD_H
+  const unsigned char	*bytes = (const unsigned char *)data,
+					/* Bytes in buffer */
+			*content;	/* Start of root element content */
+  _mxml_load_t		st;		/* Load state */
+  _mxml_pload_t		pl;		/* Parallel load state */
+  _mxml_segment_t	*segment;	/* Current segment */
+  _mxml_global_t	*global;	/* Global data */
+  void			(*error_cb)(const char *);
+					/* Error callback of this thread */
+  pthread_t		*workers;	/* Worker threads */
+  mxml_node_t		*last,		/* Last child of top before loading */
+			*root,		/* Root element */
+			*node,		/* Current node */
+			*tree;		/* Loaded tree */
+  size_t		chunk;		/* Target bytes per segment */
+  int			i,		/* Looping var */
+			num_workers,	/* Number of worker threads */
+			status;		/* Load status */
+
+
+  if (threads <= 0)
+  {
+#  ifdef _SC_NPROCESSORS_ONLN
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#  else
+    threads = 1;
+#  endif /* _SC_NPROCESSORS_ONLN */
+  }
+
+ /*
+  * Split the buffer, loading small and UTF-16 buffers sequentially...
+  */
+
+  if (threads < 2 || len < 2 * MXML_SEGMENT_MIN || bytes[0] == 0xfe || bytes[0] == 0xff)
+    goto sequential;
+
+  if ((chunk = len / (size_t)(threads * MXML_SEGMENTS_PER_THREAD)) < MXML_SEGMENT_MIN)
+    chunk = MXML_SEGMENT_MIN;
+
+  if ((pl.num_segments = mxml_load_split(bytes, len, chunk, &content, &pl.segments)) < 2)
+  {
+    _mxml_free(pl.segments);
+    goto sequential;
+  }
+
+ /*
+  * Load the prolog and root start tag and stop inside the root element...
+  */
+
+  if (mxml_load_init(&st, top, cb, MXML_NO_CALLBACK, NULL))
+  {
+    _mxml_free(pl.segments);
+    return (NULL);
+  }
+
+  last = top ? top->last_child : NULL;
+
+  mxml_read_buffer(&in, bytes, (size_t)(content - bytes));
+  in.incomplete = 1;
+
+  if ((status = mxml_load_more(&st, &in, &tree)) < 0)
+  {
+    _mxml_free(pl.segments);
+    return (NULL);
+  }
+  else if (status > 0 || !st.parent || st.parent == top || st.parent->type != MXML_ELEMENT || in.current != in.end || in.encoding != ENCODE_UTF8)
+  {
+    _mxml_free(pl.segments);
+    goto undo;
+  }
+
+  root = st.parent;
+
+ /*
+  * Load the segments using this thread and the worker threads...
+  */
+
+  global = _mxml_global();
+
+  pl.root         = root;
+  pl.cb           = cb;
+  pl.global       = *global;
+  pl.next_segment = 0;
+
+  pl.global.error_cb = mxml_ignore_error;
+
+  error_cb         = global->error_cb;
+  global->error_cb = mxml_ignore_error;
+
+  pthread_mutex_init(&pl.mutex, NULL);
+
+  if ((num_workers = threads < pl.num_segments ? threads - 1 : pl.num_segments - 1) > 0 && (workers = _mxml_calloc((size_t)num_workers, sizeof(pthread_t))) != NULL)
+  {
+    for (i = 0; i < num_workers; i ++)
+      if (pthread_create(workers + i, NULL, mxml_load_worker, &pl))
+        break;
+
+    num_workers = i;
+
+    mxml_load_worker(&pl);
+
+    for (i = 0; i < num_workers; i ++)
+      pthread_join(workers[i], NULL);
+
+    _mxml_free(workers);
+  }
+  else
+    mxml_load_worker(&pl);
+
+  pthread_mutex_destroy(&pl.mutex);
+
+  global->error_cb = error_cb;
+
+  for (i = pl.num_segments, segment = pl.segments; i > 0; i --, segment ++)
+    if (!segment->tree)
+      break;
+
+  if (i > 0)
+  {
+   /*
+    * Load everything again to report the error...
+    */
+
+    for (i = pl.num_segments, segment = pl.segments; i > 0; i --, segment ++)
+      mxmlDelete(segment->tree);
+
+    _mxml_free(pl.segments);
+    goto undo;
+  }
+
+ /*
+  * Move the children of each segment under the root element...
+  */
+
+  for (i = pl.num_segments, segment = pl.segments; i > 0; i --, segment ++)
+  {
+    if ((node = segment->tree->child) != NULL)
+    {
+      for (; node; node = node->next)
+        node->parent = root;
+
+      node = segment->tree->child;
+
+      if (root->last_child)
+        root->last_child->next = node;
+      else
+        root->child = node;
+
+      node->prev       = root->last_child;
+      root->last_child = segment->tree->last_child;
+
+      segment->tree->child      = NULL;
+      segment->tree->last_child = NULL;
+    }
+
+    st.line += segment->lines;
+
+    mxmlDelete(segment->tree);
+  }
+
+ /*
+  * Load the rest of the root element and anything after it...
+  */
+
+  in.current    = pl.segments[pl.num_segments - 1].end;
+  in.end        = bytes + len;
+  in.incomplete = 0;
+
+  _mxml_free(pl.segments);
+
+  mxml_load_more(&st, &in, &tree);
+
+  return (tree);
+
+ /*
+  * Remove everything that was loaded and start over...
+  */
+
+  undo:
+
+  if (top)
+  {
+    while ((node = last ? last->next : top->child) != NULL)
+      mxmlDelete(node);
+  }
+  else
+    mxmlDelete(st.first);
+
+  mxml_load_free(&st);
+
+  sequential:
+
+#else
+  (void)threads;
+#endif /* HAVE_PTHREAD_H */
+
+  mxml_read_buffer(&in, data, len);
+
+  return (mxml_load_data(NULL, top, &in, cb, MXML_NO_CALLBACK, NULL));
+}
+
+
+/*
+ * 'mxml_load_opened()' - Load an open file, mapping it into memory if possible.
+ *
+ * The file descriptor is not closed.
+ */
+
+static mxml_node_t *			/* O - First node or NULL if the file could not be read. */
+mxml_load_opened(
+    _mxml_load_t   *st,			/* I - Reused load state or NULL */
+    mxml_node_t    *top,		/* I - Top node */
+    int            fd,			/* I - File descriptor */
+    mxml_load_cb_t cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void           *sax_data,		/* I - SAX user data */
+    int            threads)		/* I - Number of threads, 0 for one per CPU, or 1 to load sequentially */
+{
+  _mxml_read_t	in;			/* Input buffer */
+  mxml_node_t	*node;			/* First node */
+#ifdef HAVE_MMAP
+  struct stat	fileinfo;		/* File information */
+  size_t	length;			/* Length of file */
+  void		*data;			/* Mapped file data */
+#endif /* HAVE_MMAP */
+
+
+#ifdef HAVE_MMAP
+ /*
+  * Map regular files into memory and parse directly from the mapping...
+  */
+
+  data = MAP_FAILED;
+
+  if (!fstat(fd, &fileinfo) && S_ISREG(fileinfo.st_mode) && fileinfo.st_size > 0 && (off_t)(length = (size_t)fileinfo.st_size) == fileinfo.st_size)
+    data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (data != MAP_FAILED && mxml_compressed((const unsigned char *)data, length) != MXML_COMPRESS_NONE)
+  {
+   /*
+    * Compressed files are decompressed a block at a time below...
+    */
+
+    munmap(data, length);
+  }
+  else if (data != MAP_FAILED)
+  {
+    if (threads != 1)
+    {
+      node = mxml_load_parallel(top, data, length, cb, threads);
+    }
+    else
+    {
+#  ifdef MADV_SEQUENTIAL
+      madvise(data, length, MADV_SEQUENTIAL);
+#  endif /* MADV_SEQUENTIAL */
+
+      mxml_read_buffer(&in, data, length);
+
+      node = mxml_load_data(st, top, &in, cb, sax_cb, sax_data);
+    }
+
+    munmap(data, length);
+
+    return (node);
+  }
+#endif /* HAVE_MMAP */
+
+ /*
+  * Otherwise read the file in blocks...
+  */
+
+  (void)threads;
+
+  mxml_read_init(&in, mxml_fd_read, &fd);
+
+  return (mxml_load_data(st, top, &in, cb, sax_cb, sax_data));
+}
+
+
+/*
+ * 'mxml_load_path()' - Load a named file, mapping it into memory if possible.
+ */
+
+static mxml_node_t *			/* O - First node or NULL if the file could not be read. */
+mxml_load_path(
+    _mxml_load_t   *st,			/* I - Reused load state or NULL */
+    mxml_node_t    *top,		/* I - Top node */
+    const char     *filename,		/* I - File to read from */
+    mxml_load_cb_t cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void           *sax_data,		/* I - SAX user data */
+    int            threads)		/* I - Number of threads, 0 for one per CPU, or 1 to load sequentially */
+{
+  int		fd;			/* File descriptor */
+  mxml_node_t	*node;			/* First node */
+
+
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+  {
+    mxml_error("Unable to open \"%s\": %s", filename, strerror(errno));
+    return (NULL);
+  }
+
+  node = mxml_load_opened(st, top, fd, cb, sax_cb, sax_data, threads);
+
+  close(fd);
+
+  return (node);
+}
+
+
+/*
+ * 'mxml_load_records()' - Load data one record at a time.
+ */
+
+static int				/* O - Number of records or -1 on error */
+mxml_load_records(
+    _mxml_read_t     *in,		/* I - Input buffer */
+    const char       *name,		/* I - Record element name */
+    mxml_load_cb_t   cb,		/* I - Callback function or constant */
+    mxml_record_cb_t record_cb,		/* I - Record callback */
+    void             *record_data)	/* I - Record callback data */
+{
+  _mxml_load_t		st;		/* Load state */
+  _mxml_records_t	records;	/* Record loading state */
+  mxml_node_t		*tree;		/* Loaded tree (a retained top-level record or NULL) */
+  int			status;		/* Load status */
+
+
+  if (!name || !record_cb)
+  {
+    mxml_error("No record name or callback.");
+    return (-1);
+  }
+
+  records.name  = name;
+  records.cb    = record_cb;
+  records.data  = record_data;
+  records.depth = 0;
+  records.count = 0;
+
+  if (mxml_load_init(&st, NULL, cb, mxml_records_sax_cb, &records))
+    return (-1);
+
+  status = mxml_load_more(&st, in, &tree);
+
+  mxml_read_free(in);
+
+  return (status < 0 ? -1 : records.count);
+}
+
+
+#ifdef HAVE_PTHREAD_H
+/*
+ * 'mxml_load_segment()' - Load a segment of a parallel load.
+ */
+
+static void
+mxml_load_segment(
+    _mxml_pload_t   *pl,		/* I - Parallel load state */
+    _mxml_segment_t *segment)		/* I - Segment */
+{
+  _mxml_load_t	st;			/* Load state */
+  _mxml_read_t	in;			/* Input buffer */
+  _mxml_attr_t	*attr;			/* Current attribute */
+  mxml_node_t	*tree;			/* Loaded tree */
+  int		i;			/* Looping var */
+
+
+ /*
+  * Copy the root element...
+  */
+
+  if ((segment->tree = mxmlNewElement(MXML_NO_PARENT, pl->root->value.element.name)) == NULL)
+    return;
+
+  for (i = pl->root->num_attrs, attr = pl->root->value.element.attrs; i > 0; i --, attr ++)
+    mxmlElementSetAttr(segment->tree, attr->name, attr->value);
+
+ /*
+  * Load the children, which must leave the copy as the only open element...
+  */
+
+  if (mxml_load_init(&st, segment->tree, pl->cb, MXML_NO_CALLBACK, NULL))
+  {
+    mxmlDelete(segment->tree);
+    segment->tree = NULL;
+    return;
+  }
+
+  mxml_read_buffer(&in, segment->start, (size_t)(segment->end - segment->start));
+
+  if (mxml_load_more(&st, &in, &tree) != 1 || tree != segment->tree || in.error)
+  {
+    mxmlDelete(segment->tree);
+    segment->tree = NULL;
+    return;
+  }
+
+  segment->lines = st.line - 1;
+}
+
+
+/*
+ * 'mxml_load_worker()' - Load segments of a parallel load until none are left.
+ */
+
+static void *				/* O - Thread exit status (NULL) */
+mxml_load_worker(void *data)		/* I - Parallel load state */
+{
+  _mxml_pload_t	*pl = (_mxml_pload_t *)data;
+					/* Parallel load state */
+  int		segment;		/* Segment to load */
+
+
+ /*
+  * Use the caller's entity and custom data callbacks...
+  */
+
+  *_mxml_global() = pl->global;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&pl->mutex);
+    segment = pl->next_segment ++;
+    pthread_mutex_unlock(&pl->mutex);
+
+    if (segment >= pl->num_segments)
+      break;
+
+    mxml_load_segment(pl, pl->segments + segment);
+  }
+
+  return (NULL);
+}
+#endif /* HAVE_PTHREAD_H */
+
+
+/*
+ * 'mxml_load_split()' - Split the content of the root element into segments.
+ *
+ * Segments end after a child element of the root element, once they are at
+ * least "chunk" bytes long.  Markup is skipped the same way the loader reads
+ * it, so that each segment holds complete children.
+ */
+
+static int				/* O - Number of segments or 0 if the data cannot be split */
+mxml_load_split(
+    const unsigned char *data,		/* I - Buffer */
+    size_t              len,		/* I - Length of buffer */
+    size_t              chunk,		/* I - Target bytes per segment */
+    const unsigned char **content,	/* O - Start of root element content */
+    _mxml_segment_t     **segments)	/* O - Segments */
+{
+  const unsigned char	*ptr = data,	/* Pointer into buffer */
+			*end = data + len,
+					/* End of buffer */
+			*start = NULL,	/* Start of current segment */
+			*child = NULL;	/* End of last child element */
+  _mxml_segment_t	*temp;		/* New segments */
+  int			depth = 0,	/* Element depth */
+			element,	/* Was markup an element tag? */
+			num_segments = 0,
+					/* Number of segments */
+			alloc_segments = 0;
+					/* Allocated segments */
+
+
+  *content  = NULL;
+  *segments = NULL;
+
+  while ((ptr = memchr(ptr, '<', (size_t)(end - ptr))) != NULL)
+  {
+    if ((ptr = mxml_skip_markup(ptr + 1, end, &depth, &element)) == NULL || depth < 0)
+      return (0);
+
+    if (!element)
+      continue;
+
+    if (!start)
+    {
+     /*
+      * The first element is the root element...
+      */
+
+      if (depth != 1)
+        return (0);
+
+      *content = start = ptr;
+    }
+    else if (depth == 0)
+    {
+     /*
+      * Close of the root element...
+      */
+
+      break;
+    }
+    else if (depth == 1)
+    {
+     /*
+      * End of a child element...
+      */
+
+      child = ptr;
+
+      if ((size_t)(ptr - start) < chunk)
+        continue;
+    }
+    else
+      continue;
+
+    if (child)
+    {
+     /*
+      * Add a segment for the children since the last one...
+      */
+
+      if (num_segments >= alloc_segments)
+      {
+        alloc_segments += 32;
+
+        if ((temp = _mxml_realloc(*segments, (size_t)alloc_segments * sizeof(_mxml_segment_t))) == NULL)
+          return (0);
+
+        *segments = temp;
+      }
+
+      temp        = *segments + num_segments;
+      temp->start = start;
+      temp->end   = child;
+      temp->tree  = NULL;
+      temp->lines = 0;
+
+      num_segments ++;
+
+      start = child;
+    }
+  }
+
+  if (!ptr || depth != 0)
+    return (0);
+
+ /*
+  * Add the remaining children...
+  */
+
+  if (child && child > start)
+  {
+    if (num_segments >= alloc_segments)
+    {
+      if ((temp = _mxml_realloc(*segments, (size_t)(alloc_segments + 1) * sizeof(_mxml_segment_t))) == NULL)
+        return (0);
+
+      *segments = temp;
+    }
+
+    temp        = *segments + num_segments;
+    temp->start = start;
+    temp->end   = child;
+    temp->tree  = NULL;
+    temp->lines = 0;
+
+    num_segments ++;
+  }
+
+  return (num_segments);
+}
+
+
+/*
+ * 'mxml_load_type()' - Get the child value type for an element.
+ *
+ * The type map, if any, is checked first using the element name or the value
+ * of the map's attribute, and the load callback is used for anything else.
+ */
+
+static inline mxml_type_t		/* O - Child value type */
+mxml_load_type(_mxml_load_t *st,	/* I - Load state */
+               mxml_node_t  *node)	/* I - Element node */
+{
+  mxml_typemap_t	*map;		/* Type map */
+  const char		*key;		/* Name or attribute value to look up */
+  _mxml_attr_t		*attr;		/* Current attribute */
+  _mxml_typeent_t	*ent;		/* Current entry */
+  unsigned		hash;		/* Hash of key */
+  int			i;		/* Looping var */
+
+
+  if ((map = st->typemap) != NULL && map->num_entries > 0 && node->type == MXML_ELEMENT)
+  {
+    key = node->value.element.name;
+
+    if (map->attr)
+    {
+      for (i = node->num_attrs, attr = node->value.element.attrs; i > 0; i --, attr ++)
+      {
+        if (!strcmp(attr->name, map->attr))
+        {
+          key = attr->value;
+          break;
+        }
+      }
+    }
+
+    hash = _mxml_strhash(key);
+
+    for (i = (int)hash & (map->alloc_entries - 1), ent = map->entries + i; ent->name; i = (i + 1) & (map->alloc_entries - 1), ent = map->entries + i)
+    {
+      if (ent->hash == hash && !strcmp(ent->name, key))
+        return (ent->type);
+    }
+  }
+
+  if (st->cb)
+    return ((*st->cb)(node));
+  else
+    return (MXML_TEXT);
+}
+
+
+/*
+ * 'mxml_load_views()' - Load data using a SAX view callback.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_load_views(
+    _mxml_read_t       *in,		/* I - Input buffer */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  _mxml_load_t	st;			/* Load state */
+  _mxml_views_t	views;			/* SAX view buffers */
+  mxml_node_t	*tree;			/* Loaded tree (always NULL) */
+  int		status;			/* Load status */
+
+
+  if (!cb)
+  {
+    mxml_error("No SAX view callback.");
+    return (-1);
+  }
+
+  if (mxml_load_init(&st, NULL, MXML_OPAQUE_CALLBACK, MXML_NO_CALLBACK, NULL))
+    return (-1);
+
+  mxml_views_init(&views, cb, cb_data);
+
+  st.views = &views;
+  status   = mxml_load_more(&st, in, &tree);
+
+  mxml_read_free(in);
+  mxml_views_free(&views);
+
+  return (status < 0 ? -1 : 0);
+}
+
+
+/*
+ * 'mxml_new_attr()' - Add an attribute to a newly loaded element.
+ *
+ * When loading in place, the name and value are copied back into the
+ * source buffer and borrowed by the element.  Otherwise they are saved until
+ * the end of the tag and set by mxml_new_attrs.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_new_attr(_mxml_load_t *st,	/* I - Load state */
+              _mxml_read_t *in,		/* I - Input buffer */
+              mxml_node_t  *node,	/* I - Element node */
+              const char   *name,	/* I - Attribute name */
+              const char   *value)	/* I - Attribute value */
+{
+  size_t	namelen,		/* Length of name */
+		valuelen;		/* Length of value */
+  _mxml_views_t	*views;			/* SAX view buffers */
+  _mxml_attr_t	*attr;			/* New attribute */
+
+
+  if ((views = st->views) != NULL)
+  {
+   /*
+    * Copy the attribute to the reused view buffers...
+    */
+
+    if (node->num_attrs >= views->alloc_attrs)
+    {
+      int		alloc_attrs = views->alloc_attrs ? 2 * views->alloc_attrs : 16;
+					/* New attribute count */
+      const char	**pairs;	/* New name/value pairs */
+
+      if ((attr = _mxml_realloc(views->attrs, (size_t)alloc_attrs * sizeof(_mxml_attr_t))) == NULL)
+      {
+        mxml_error("Unable to allocate memory for attribute '%s' in element %s!", name, node->value.element.name);
+        return (-1);
+      }
+
+      views->attrs              = attr;
+      node->value.element.attrs = attr;
+
+      if ((pairs = _mxml_realloc(views->pairs, (size_t)(2 * alloc_attrs + 1) * sizeof(char *))) == NULL)
+      {
+        mxml_error("Unable to allocate memory for attribute '%s' in element %s!", name, node->value.element.name);
+        return (-1);
+      }
+
+      views->pairs       = pairs;
+      views->alloc_attrs = alloc_attrs;
+    }
+
+    namelen  = strlen(name) + 1;
+    valuelen = strlen(value) + 1;
+
+    if (mxml_views_reserve(views, node, namelen + valuelen))
+      return (-1);
+
+    attr        = views->attrs + node->num_attrs;
+    attr->name  = memcpy(views->strings + views->strused, name, namelen);
+    attr->value = memcpy(views->strings + views->strused + namelen, value, valuelen);
+
+    views->strused += namelen + valuelen;
+    node->num_attrs ++;
+
+    return (0);
+  }
+
+  namelen  = strlen(name) + 1;
+  valuelen = strlen(value) + 1;
+
+  if (in->inplace)
+  {
+    if ((!node->num_attrs || (node->flags & _MXML_NODE_REF_ATTRS)) &&
+        (namelen + valuelen) <= (size_t)(in->current - in->inplace))
+    {
+      if (_mxml_add_attr(node, mxml_read_inplace(in, name), mxml_read_inplace(in, value)))
+        return (-1);
+
+      node->flags = (node->flags | _MXML_NODE_REF_ATTRS) & ~_MXML_NODE_ATTRS_INTERNED;
+
+      return (0);
+    }
+
+    mxmlElementSetAttr(node, name, value);
+
+    return (0);
+  }
+
+ /*
+  * Otherwise save the attribute so that mxml_new_attrs can set all of the
+  * attributes of the element with a single allocation...
+  */
+
+  if (st->num_attrs >= st->alloc_attrs)
+  {
+    int		alloc_attrs = st->alloc_attrs ? 2 * st->alloc_attrs : 16;
+					/* New attribute count */
+    const char	**pairs;		/* New name and value pointers */
+
+    if ((pairs = _mxml_realloc(st->pairs, (size_t)(2 * alloc_attrs) * sizeof(char *))) == NULL)
+    {
+      mxml_error("Unable to allocate memory for attribute '%s' in element %s!", name, node->value.element.name);
+      return (-1);
+    }
+
+    if (st->num_attrs)
+      memmove(pairs + alloc_attrs, pairs + st->alloc_attrs, (size_t)st->num_attrs * sizeof(char *));
+
+    st->pairs       = pairs;
+    st->alloc_attrs = alloc_attrs;
+  }
+
+  if ((st->attrused + namelen + valuelen) > st->attrsize)
+  {
+    size_t	attrsize = st->attrsize ? 2 * st->attrsize : 1024;
+					/* New buffer size */
+    char	*attrs;			/* New buffer */
+    int		i;			/* Looping var */
+
+    while (attrsize < (st->attrused + namelen + valuelen))
+      attrsize *= 2;
+
+    if ((attrs = _mxml_realloc(st->attrs, attrsize)) == NULL)
+    {
+      mxml_error("Unable to allocate memory for attribute '%s' in element %s!", name, node->value.element.name);
+      return (-1);
+    }
+
+    st->attrs    = attrs;
+    st->attrsize = attrsize;
+
+   /*
+    * Point the saved names and values at the new buffer...
+    */
+
+    for (i = 0; i < st->num_attrs; i ++)
+    {
+      st->pairs[i]                   = attrs;
+      attrs                          += strlen(attrs) + 1;
+      st->pairs[st->alloc_attrs + i] = attrs;
+      attrs                          += strlen(attrs) + 1;
+    }
+  }
+
+  st->pairs[st->num_attrs]                   = memcpy(st->attrs + st->attrused, name, namelen);
+  st->pairs[st->alloc_attrs + st->num_attrs] = memcpy(st->attrs + st->attrused + namelen, value, valuelen);
+
+  st->attrused += namelen + valuelen;
+  st->num_attrs ++;
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_new_attrs()' - Set the saved attributes of a newly loaded element.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_new_attrs(_mxml_load_t *st,	/* I - Load state */
+               mxml_node_t  *node)	/* I - Element node */
+{
+  int		num_attrs;		/* Number of attributes */
+
+
+  if ((num_attrs = st->num_attrs) == 0)
+    return (0);
+
+  st->num_attrs = 0;
+  st->attrused  = 0;
+
+  return (mxmlElementSetAttrs(node, st->pairs, st->pairs + st->alloc_attrs, num_attrs));
+}
+
+
+/*
+ * 'mxml_new_element()' - Create a new element node for an open tag.
+ *
+ * When loading with a SAX view callback, each depth reuses the same node
+ * and the name is kept in the view buffers until the element is closed.
+ */
+
+static mxml_node_t *			/* O - New node */
+mxml_new_element(_mxml_load_t *st,	/* I - Load state */
+                 _mxml_read_t *in,	/* I - Input buffer */
+                 mxml_node_t  *parent,	/* I - Parent node */
+                 const char   *name)	/* I - Element name */
+{
+  _mxml_views_t	*views;			/* SAX view buffers */
+  mxml_node_t	*node;			/* New node */
+  size_t	namelen;		/* Length of name */
+
+
+  if ((views = st->views) == NULL)
+    return (mxml_new_string(st, in, parent, MXML_ELEMENT, 0, name));
+
+  if ((node = parent ? parent->child : views->elements) == NULL)
+  {
+    if ((node = _mxml_new(parent, MXML_ELEMENT)) == NULL)
+      return (NULL);
+
+    node->flags = _MXML_NODE_REF_VALUE | _MXML_NODE_REF_ATTRS;
+
+    if (!parent)
+      views->elements = node;
+  }
+
+  namelen = strlen(name) + 1;
+
+  if (mxml_views_reserve(views, NULL, namelen))
+    return (NULL);
+
+  node->value.element.name  = memcpy(views->strings + views->strused, name, namelen);
+  node->value.element.attrs = views->attrs;
+  node->num_attrs           = 0;
+
+  views->strused += namelen;
+
+  return (node);
+}
+
+
+/*
+ * 'mxml_new_string()' - Create a new element, opaque, or text node.
+ *
+ * When loading in place, the string is copied back into the source buffer
+ * and borrowed by the node.  When loading with a SAX view callback, the
+ * same node is reused for every string and borrows it until the next one.
+ */
+
+static mxml_node_t *			/* O - New node */
+mxml_new_string(_mxml_load_t *st,	/* I - Load state */
+                _mxml_read_t *in,	/* I - Input buffer */
+                mxml_node_t  *parent,	/* I - Parent node */
+                mxml_type_t  type,	/* I - Node type */
+                int          whitespace,/* I - Leading whitespace for text nodes */
+                const char   *s)	/* I - String */
+{
+  char		*ref;			/* String in source buffer */
+  mxml_node_t	*node;			/* New node */
+
+
+  if (st->views)
+  {
+    node = &st->views->node;
+
+    if (type == MXML_ELEMENT)
+    {
+      node->type               = MXML_ELEMENT;
+      node->value.element.name = (char *)s;
+      node->num_attrs          = 0;
+    }
+    else
+    {
+      node->type         = MXML_OPAQUE;
+      node->value.opaque = (char *)s;
+      st->views->textlen = strlen(s);
+    }
+
+    return (node);
+  }
+
+  if ((ref = mxml_read_inplace(in, s)) == NULL && (parent || !st->arena))
+  {
+    if (type == MXML_ELEMENT)
+      return (mxmlNewElement(parent, s));
+    else if (type == MXML_OPAQUE)
+      return (mxmlNewOpaque(parent, s));
+    else
+      return (mxmlNewText(parent, whitespace, s));
+  }
+
+ /*
+  * Top-level nodes start a new arena when asked; nodes under them then use
+  * it as well...
+  */
+
+  if ((node = (parent || !st->arena) ? _mxml_new(parent, type) : _mxml_new_arena(type)) != NULL)
+  {
+    if (ref)
+    {
+      node->flags |= _MXML_NODE_REF_VALUE;
+    }
+    else if ((ref = _mxml_strdup_value(node, s)) == NULL)
+    {
+      mxmlDelete(node);
+      return (NULL);
+    }
+
+    if (type == MXML_ELEMENT)
+    {
+      node->value.element.name = ref;
+    }
+    else if (type == MXML_OPAQUE)
+    {
+      node->value.opaque = ref;
+    }
+    else
+    {
+      node->value.text.whitespace = whitespace;
+      node->value.text.string     = ref;
+    }
+  }
+
+  return (node);
+}
+
+
+/*
+ * 'mxml_parse_element()' - Parse an element for any attributes...
+ */
+
+static int				/* O  - Terminating character */
+mxml_parse_element(
+    _mxml_load_t    *st,		/* I  - Load state */
+    mxml_node_t     *node,		/* I  - Element node */
+    _mxml_read_t    *in,		/* I  - Input buffer */
+    int             *line)		/* IO - Current line number */
+{
+  int	ch,				/* Current character in file */
+	quote;				/* Quoting character */
+  char	*name,				/* Attribute name */
+	*value,				/* Attribute value */
+	*ptr;				/* Pointer into name/value */
+  int	namesize,			/* Size of name string */
+	valsize;			/* Size of value string */
+
+
+ /*
+  * Initialize the name and value buffers, which are reused for every
+  * element...
+  */
+
+  if (!st->name)
+  {
+    if ((st->name = _mxml_malloc(64)) == NULL)
+    {
+      mxml_error("Unable to allocate memory for name!");
+      return (EOF);
+    }
+
+    st->namesize = 64;
+  }
+
+  if (!st->value)
+  {
+    if ((st->value = _mxml_malloc(64)) == NULL)
+    {
+      mxml_error("Unable to allocate memory for value!");
+      return (EOF);
+    }
+
+    st->valsize = 64;
+  }
 
-	case MXML_OPAQUE :
-            node = mxmlNewOpaque(parent, buffer);
-	    break;
+  name     = st->name;
+  namesize = st->namesize;
+  value    = st->value;
+  valsize  = st->valsize;
 
-	case MXML_REAL :
-            node = mxmlNewReal(parent, strtod(buffer, &bufptr));
-	    break;
+  st->num_attrs = 0;
+  st->attrused  = 0;
 
-	case MXML_TEXT :
-            node = mxmlNewText(parent, whitespace, buffer);
-	    break;
+ /*
+  * Loop until we hit a >, /, ?, or EOF...
+  */
 
-	case MXML_CUSTOM :
-	    if (global->custom_load_cb)
+  while ((ch = mxml_getc(in)) != EOF)
+  {
+#if DEBUG > 1
+    fprintf(stderr, "parse_element: ch='%c'\n", ch);
+#endif /* DEBUG > 1 */
+
+   /*
+    * Skip leading whitespace...
+    */
+
+    if (mxml_isspace(ch))
+    {
+      if (ch == '\n')
+        (*line)++;
+
+      continue;
+    }
+
+   /*
+    * Stop at /, ?, or >...
+    */
+
+    if (ch == '/' || ch == '?')
+    {
+     /*
+      * Grab the > character and print an error if it isn't there...
+      */
+
+      quote = mxml_getc(in);
+
+      if (quote != '>')
+      {
+        mxml_error("Expected '>' after '%c' for element %s, but got '%c' on line %d.", ch, node->value.element.name, quote, *line);
+        goto error;
+      }
+
+      break;
+    }
+    else if (ch == '<')
+    {
+      mxml_error("Bare < in element %s on line %d.", node->value.element.name, *line);
+      goto error;
+    }
+    else if (ch == '>')
+      break;
+
+   /*
+    * Read the attribute name...
+    */
+
+    name[0] = ch;
+    ptr     = name + 1;
+
+    if (ch == '\"' || ch == '\'')
+    {
+     /*
+      * Name is in quotes, so get a quoted string...
+      */
+
+      quote = ch;
+
+      while ((ch = mxml_getc(in)) != EOF)
+      {
+        if (ch == '&')
+        {
+	  if ((ch = mxml_get_entity(node, in, line)) == EOF)
+	    goto error;
+	}
+	else if (ch == '\n')
+	  (*line)++;
+
+	if (mxml_add_char(ch, &ptr, &name, &namesize))
+	  goto error;
+
+	if (ch == quote)
+          break;
+      }
+
+      if (ch != quote)
+      {
+        if (!in->error)
+	  mxml_error("Missing closing quote for attribute name in element %s on line %d.", node->value.element.name, *line);
+	goto error;
+      }
+    }
+    else
+    {
+     /*
+      * Grab an normal, non-quoted name...
+      */
+
+      while ((ch = mxml_getc(in)) != EOF)
+      {
+	if (mxml_isspace(ch) || ch == '=' || ch == '/' || ch == '>' ||
+	    ch == '?')
+	{
+	  if (ch == '\n')
+	    (*line)++;
+          break;
+        }
+	else
+	{
+          if (ch == '&')
+          {
+	    if ((ch = mxml_get_entity(node, in, line)) == EOF)
+	      goto error;
+          }
+
+	  if (mxml_add_char(ch, &ptr, &name, &namesize) ||
+	      mxml_add_run(in, MXML_SCAN_ATTR, &ptr, &name, &namesize, line))
+	    goto error;
+	}
+      }
+
+      if (in->error)
+        goto error;
+    }
+
+    *ptr = '\0';
+
+    if (mxml_has_attr(st, node, name))
+    {
+      mxml_error("Duplicate attribute '%s' in element %s on line %d.", name, node->value.element.name, name, *line);
+      goto error;
+    }
+
+    while (ch != EOF && mxml_isspace(ch))
+    {
+      ch = mxml_getc(in);
+
+      if (ch == '\n')
+        (*line)++;
+    }
+
+    if (ch == '=')
+    {
+     /*
+      * Read the attribute value...
+      */
+
+      while ((ch = mxml_getc(in)) != EOF && mxml_isspace(ch))
+      {
+        if (ch == '\n')
+          (*line)++;
+      }
+
+      if (ch == EOF)
+      {
+        mxml_error("Missing value for attribute '%s' in element %s on line %d.", name, node->value.element.name, *line);
+        goto error;
+      }
+
+      if (ch == '\'' || ch == '\"')
+      {
+       /*
+        * Read quoted value...
+	*/
+
+        quote = ch;
+	ptr   = value;
+
+        while ((ch = mxml_getc(in)) != EOF)
+        {
+	  if (ch == quote)
+	  {
+	    break;
+	  }
+	  else
+	  {
+	    if (ch == '&')
 	    {
-	     /*
-	      * Use the callback to fill in the custom data...
-	      */
+	      if ((ch = mxml_get_entity(node, in, line)) == EOF)
+	        goto error;
+	    }
+	    else if (ch == '\n')
+	      (*line)++;
 
-              node = mxmlNewCustom(parent, NULL, NULL);
+	    if (mxml_add_char(ch, &ptr, &value, &valsize) ||
+	        mxml_add_run(in, MXML_SCAN_VALUE, &ptr, &value, &valsize, line))
+	      goto error;
+	  }
+	}
 
-	      if ((*global->custom_load_cb)(node, buffer))
-	      {
-	        mxml_error("Bad custom value '%s' in parent <%s> on line %d.", buffer, parent ? parent->value.element.name : "null", line);
-		mxmlDelete(node);
-		node = NULL;
-	      }
-	      break;
+        if (ch != quote)
+        {
+         /*
+	  * EOF here is either the end of the input or a bad character, and
+	  * neither one ends the value...
+	  */
+
+          if (!in->error)
+	    mxml_error("Missing closing quote for attribute '%s' in element %s on line %d.", name, node->value.element.name, *line);
+	  goto error;
+	}
+
+        *ptr = '\0';
+      }
+      else
+      {
+       /*
+        * Read unquoted value...
+	*/
+
+	value[0] = ch;
+	ptr      = value + 1;
+
+	while ((ch = mxml_getc(in)) != EOF)
+	{
+	  if (mxml_isspace(ch) || ch == '=' || ch == '/' || ch == '>')
+	  {
+	    if (ch == '\n')
+	      (*line)++;
+
+            break;
+          }
+	  else
+	  {
+	    if (ch == '&')
+	    {
+	      if ((ch = mxml_get_entity(node, in, line)) == EOF)
+	        goto error;
 	    }
 
-        default : /* Ignore... */
-	    node = NULL;
-	    break;
+	    if (mxml_add_char(ch, &ptr, &value, &valsize) ||
+	        mxml_add_run(in, MXML_SCAN_ATTR, &ptr, &value, &valsize, line))
+	      goto error;
+	  }
+	}
+
+        if (in->error)
+	  goto error;
+
+        *ptr = '\0';
       }
 
-      if (*bufptr)
-      {
-       /*
-        * Bad integer/real number value...
-	*/
+     /*
+      * Set the attribute with the given string value...
+      */
+
+      if (mxml_new_attr(st, in, node, name, value))
+        goto error;
+    }
+    else
+    {
+      mxml_error("Missing value for attribute '%s' in element %s on line %d.", name, node->value.element.name, *line);
+      goto error;
+    }
+
+   /*
+    * Check the end character...
+    */
+
+    if (ch == '/' || ch == '?')
+    {
+     /*
+      * Grab the > character and print an error if it isn't there...
+      */
+
+      quote = mxml_getc(in);
+
+      if (quote != '>')
+      {
+        mxml_error("Expected '>' after '%c' for element %s, but got '%c' on line %d.", ch, node->value.element.name, quote, *line);
+        ch = EOF;
+      }
+
+      break;
+    }
+    else if (ch == '>')
+      break;
+  }
+
+ /*
+  * Set the saved attributes, then save the name and value buffers and return...
+  */
 
-        mxml_error("Bad %s value '%s' in parent <%s> on line %d.", type == MXML_INTEGER ? "integer" : "real", buffer, parent ? parent->value.element.name : "null", line);
-	break;
-      }
+  if (mxml_new_attrs(st, node))
+    ch = EOF;
 
-      bufptr     = buffer;
-      whitespace = mxml_isspace(ch) && type == MXML_TEXT;
+  st->name     = name;
+  st->namesize = namesize;
+  st->value    = value;
+  st->valsize  = valsize;
 
-      if (!node && type != MXML_IGNORE)
-      {
-       /*
-	* Print error and return...
-	*/
+  return (ch);
 
-	mxml_error("Unable to add value node of type %s to parent <%s> on line %d.", types[type], parent ? parent->value.element.name : "null", line);
-	goto error;
-      }
+ /*
+  * Common error return point...
+  */
 
-      if (sax_cb)
-      {
-        (*sax_cb)(node, MXML_SAX_DATA, sax_data);
+  error:
 
-        if (!mxmlRelease(node))
-          node = NULL;
-      }
+  st->name     = name;
+  st->namesize = namesize;
+  st->value    = value;
+  st->valsize  = valsize;
 
-      if (!first && node)
-        first = node;
-    }
-    else if (mxml_isspace(ch) && type == MXML_TEXT)
-      whitespace = 1;
+  return (EOF);
+}
 
-    if (ch == '\n')
-      line ++;
 
-   /*
-    * Add lone whitespace node if we have an element and existing
-    * whitespace...
-    */
+/*
+ * 'mxml_read_bad()' - Report an invalid UTF-8 sequence.
+ */
 
-    if (ch == '<' && whitespace && type == MXML_TEXT)
-    {
-      if (parent)
-      {
-	node = mxmlNewText(parent, whitespace, "");
+static int				/* O - EOF */
+mxml_read_bad(_mxml_read_t *in,		/* I - Input buffer */
+              int          lead)	/* I - Lead byte of sequence */
+{
+  if (in->line)
+    mxml_error("Invalid UTF-8 sequence starting with 0x%02x under parent <%s> on line %d.", lead, *(in->parent) ? (*(in->parent))->value.element.name : "null", *(in->line));
+  else
+    mxml_error("Invalid UTF-8 sequence starting with 0x%02x.", lead);
 
-	if (sax_cb)
-	{
-	  (*sax_cb)(node, MXML_SAX_DATA, sax_data);
+  in->error = 1;
 
-	  if (!mxmlRelease(node))
-	    node = NULL;
-	}
+  return (EOF);
+}
 
-	if (!first && node)
-	  first = node;
-      }
 
-      whitespace = 0;
-    }
+/*
+ * 'mxml_read_buffer()' - Initialize an input buffer for a fixed block of memory.
+ */
 
-    if (ch == '<')
-    {
-     /*
-      * Start of open/close tag...
-      */
+static void
+mxml_read_buffer(_mxml_read_t *in,	/* I - Input buffer */
+                 const void   *data,	/* I - Data */
+                 size_t       len)	/* I - Length of data */
+{
+  in->read_cb   = NULL;
+  in->read_data = NULL;
+  in->encoding  = ENCODE_UTF8;
+  in->string    = 0;
+  in->inplace   = NULL;
+  in->error     = 0;
+  in->incomplete = 0;
+  in->line      = NULL;
+  in->parent    = NULL;
+  in->transcode = 0;
+  in->detect    = 0;
+  in->z         = NULL;
+  in->current   = (const unsigned char *)data;
+  in->end       = (const unsigned char *)data + len;
+  in->valid     = in->current;
+}
 
-      bufptr = buffer;
 
-      while ((ch = (*getc_cb)(p, &encoding)) != EOF)
-      {
-        if (mxml_isspace(ch) || ch == '>' || (ch == '/' && bufptr > buffer))
-	  break;
-	else if (ch == '<')
-	{
-	  mxml_error("Bare < in element!");
-	  goto error;
-	}
-	else if (ch == '&')
-	{
-	  if ((ch = mxml_get_entity(parent, p, &encoding, getc_cb, &line)) == EOF)
-	    goto error;
+/*
+ * 'mxml_read_byte()' - Read a byte from the input buffer, refilling as needed.
+ */
 
-	  if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	    goto error;
-	}
-	else if (ch < '0' && ch != '!' && ch != '-' && ch != '.' && ch != '/')
-	  goto error;
-	else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	  goto error;
-	else if (((bufptr - buffer) == 1 && buffer[0] == '?') ||
-	         ((bufptr - buffer) == 3 && !strncmp(buffer, "!--", 3)) ||
-	         ((bufptr - buffer) == 8 && !strncmp(buffer, "![CDATA[", 8)))
-	  break;
+static int				/* O - Byte or EOF */
+mxml_read_byte(_mxml_read_t *in)	/* I - Input buffer */
+{
+  int	bytes;				/* Bytes read */
 
-	if (ch == '\n')
-	  line ++;
-      }
 
-      *bufptr = '\0';
+  if (in->current >= in->end)
+  {
+    if (in->transcode)
+    {
+      if (!mxml_read_utf16(in))
+        return (EOF);
+    }
+    else if (!in->read_cb)
+      return (EOF);
+    else if ((bytes = in->detect ? mxml_read_detect(in) : (*in->read_cb)(in->read_data, in->buffer, sizeof(in->buffer))) <= 0)
+    {
+      if (bytes < 0)
+        in->error = 1;			/* Read or decompression error */
 
-      if (!strcmp(buffer, "!--"))
-      {
-       /*
-        * Gather rest of comment...
-	*/
+      return (EOF);
+    }
+    else
+    {
+      in->current = in->buffer;
+      in->end     = in->buffer + bytes;
+      in->valid   = in->buffer;
+    }
+  }
 
-	while ((ch = (*getc_cb)(p, &encoding)) != EOF)
-	{
-	  if (ch == '>' && bufptr > (buffer + 4) &&
-	      bufptr[-3] != '-' && bufptr[-2] == '-' && bufptr[-1] == '-')
-	    break;
-	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	    goto error;
+  return (*(in->current)++);
+}
 
-	  if (ch == '\n')
-	    line ++;
-	}
 
-       /*
-        * Error out if we didn't get the whole comment...
-	*/
+/*
+ * 'mxml_read_char()' - Read and decode a character from the input buffer.
+ */
 
-        if (ch != '>')
-	{
-	 /*
-	  * Print error and return...
-	  */
+static int				/* O - Character or EOF */
+mxml_read_char(_mxml_read_t *in)	/* I - Input buffer */
+{
+  int		ch,			/* Current character */
+		lead,			/* Lead byte of UTF-8 sequence */
+		lch,			/* Low surrogate */
+		temp;			/* Temporary character */
 
-	  mxml_error("Early EOF in comment node on line %d.", line);
-	  goto error;
-	}
 
+  if ((ch = lead = mxml_read_byte(in)) == EOF)
+    return (EOF);
 
+  switch (in->encoding)
+  {
+    case ENCODE_UTF8 :
        /*
-        * Otherwise add this as an element under the current parent...
+	* Got a UTF-8 character; convert UTF-8 to Unicode and return...
 	*/
 
-	*bufptr = '\0';
+	if (!(ch & 0x80))
+	{
+	  if (mxml_bad_char(ch))
+	    return (mxml_read_control(in, ch));
 
-        if (!parent && first)
+	  return (ch);
+        }
+	else if (in->current <= in->valid || mxml_read_valid(in, in->current - 1) >= in->current)
 	{
 	 /*
-	  * There can only be one root element!
+	  * Already checked, just decode it...
 	  */
 
-	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
-          goto error;
+	  if (ch < 0xe0)
+	  {
+	    ch = ((ch & 0x1f) << 6) | (in->current[0] & 0x3f);
+	    in->current ++;
+	  }
+	  else if (ch < 0xf0)
+	  {
+	    ch = ((ch & 0x0f) << 12) | ((in->current[0] & 0x3f) << 6) | (in->current[1] & 0x3f);
+	    in->current += 2;
+	  }
+	  else
+	  {
+	    ch = ((ch & 0x07) << 18) | ((in->current[0] & 0x3f) << 12) | ((in->current[1] & 0x3f) << 6) | (in->current[2] & 0x3f);
+	    in->current += 3;
+	  }
 	}
-
-	if ((node = mxmlNewElement(parent, buffer)) == NULL)
+	else if (ch == 0xfe || ch == 0xff)
 	{
 	 /*
-	  * Just print error for now...
+	  * UTF-16 big-endian (FE FF) or little-endian (FF FE) BOM?
 	  */
 
-	  mxml_error("Unable to add comment node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
-	  break;
-	}
+	  if ((temp = mxml_read_byte(in)) != (ch ^ 1))
+	    return (mxml_read_bad(in, lead));
 
-        if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_COMMENT, sax_data);
+	  in->encoding = ch == 0xfe ? ENCODE_UTF16BE : ENCODE_UTF16LE;
 
-          if (!mxmlRelease(node))
-            node = NULL;
-        }
+	  if (in->string)
+	  {
+	   /*
+	    * A string ends at its first nul byte, so only the whole UTF-16 code
+	    * units before it can be read.  UTF-16 text containing nul bytes must
+	    * be loaded with mxmlLoadBuffer...
+	    */
 
-	if (node && !first)
-	  first = node;
-      }
-      else if (!strcmp(buffer, "![CDATA["))
-      {
-       /*
-        * Gather CDATA section...
-	*/
+	    in->end = in->current + ((size_t)(in->end - in->current) & ~(size_t)1);
+	  }
 
-	while ((ch = (*getc_cb)(p, &encoding)) != EOF)
-	{
-	  if (ch == '>' && !strncmp(bufptr - 2, "]]", 2))
+	  if (!in->incomplete)
 	  {
 	   /*
-	    * Drop terminator from CDATA string...
+	    * Convert the rest of the input to UTF-8 a block at a time so the
+	    * UTF-8 fast paths can be used.  Strings can no longer be loaded in
+	    * place since the converted text lives in the input buffer...
 	    */
 
-	    bufptr[-2] = '\0';
-	    break;
+	    in->transcode = in->encoding;
+	    in->encoding  = ENCODE_UTF8;
+	    in->inplace   = NULL;
+	    in->src       = in->current;
+	    in->srcend    = in->end;
+	    in->current   = in->buffer;
+	    in->end       = in->buffer;
+	    in->valid     = in->buffer;
 	  }
-	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	    goto error;
 
-	  if (ch == '\n')
-	    line ++;
+	  return (mxml_read_char(in));
 	}
-
-       /*
-        * Error out if we didn't get the whole comment...
-	*/
-
-        if (ch != '>')
+	else if ((ch & 0xe0) == 0xc0)
 	{
 	 /*
-	  * Print error and return...
+	  * Two-byte value...
 	  */
 
-	  mxml_error("Early EOF in CDATA node on line %d.", line);
-	  goto error;
-	}
-
-
-       /*
-        * Otherwise add this as an element under the current parent...
-	*/
-
-	*bufptr = '\0';
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
 
-        if (!parent && first)
-	{
-	 /*
-	  * There can only be one root element!
-	  */
+	  ch = ((ch & 0x1f) << 6) | (temp & 0x3f);
 
-	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
-          goto error;
+	  if (ch < 0x80)
+	    return (mxml_read_bad(in, lead));
 	}
-
-	if ((node = mxmlNewElement(parent, buffer)) == NULL)
+	else if ((ch & 0xf0) == 0xe0)
 	{
 	 /*
-	  * Print error and return...
+	  * Three-byte value...
 	  */
 
-	  mxml_error("Unable to add CDATA node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
-	  goto error;
-	}
-
-        if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_CDATA, sax_data);
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
 
-          if (!mxmlRelease(node))
-            node = NULL;
-        }
+	  ch = ((ch & 0x0f) << 6) | (temp & 0x3f);
 
-	if (node && !first)
-	  first = node;
-      }
-      else if (buffer[0] == '?')
-      {
-       /*
-        * Gather rest of processing instruction...
-	*/
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
 
-	while ((ch = (*getc_cb)(p, &encoding)) != EOF)
-	{
-	  if (ch == '>' && bufptr > buffer && bufptr[-1] == '?')
-	    break;
-	  else if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	    goto error;
+	  ch = (ch << 6) | (temp & 0x3f);
 
-	  if (ch == '\n')
-	    line ++;
-	}
+	  if (ch < 0x800 || (ch >= 0xd800 && ch <= 0xdfff))
+	    return (mxml_read_bad(in, lead));
 
-       /*
-        * Error out if we didn't get the whole processing instruction...
-	*/
+         /*
+	  * Ignore (strip) Byte Order Mark (BOM)...
+	  */
 
-        if (ch != '>')
+	  if (ch == 0xfeff)
+	    return (mxml_read_char(in));
+	}
+	else if ((ch & 0xf8) == 0xf0)
 	{
 	 /*
-	  * Print error and return...
+	  * Four-byte value...
 	  */
 
-	  mxml_error("Early EOF in processing instruction node on line %d.", line);
-	  goto error;
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
+
+	  ch = ((ch & 0x07) << 6) | (temp & 0x3f);
+
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
+
+	  ch = (ch << 6) | (temp & 0x3f);
+
+	  if (((temp = mxml_read_byte(in)) & 0xc0) != 0x80)
+	    return (mxml_read_bad(in, lead));
+
+	  ch = (ch << 6) | (temp & 0x3f);
+
+	  if (ch < 0x10000 || ch > 0x10ffff)
+	    return (mxml_read_bad(in, lead));
 	}
+	else
+	  return (mxml_read_bad(in, lead));
+	break;
 
+    case ENCODE_UTF16BE :
+    case ENCODE_UTF16LE :
        /*
-        * Otherwise add this as an element under the current parent...
+        * Read UTF-16 char...
 	*/
 
-	*bufptr = '\0';
+	if ((temp = mxml_read_byte(in)) == EOF)
+	  return (EOF);
 
-        if (!parent && first)
+        if (in->encoding == ENCODE_UTF16BE)
+	  ch = (ch << 8) | temp;
+	else
+	  ch |= temp << 8;
+
+	if (mxml_bad_char(ch))
+	  return (mxml_read_control(in, ch));
+        else if (ch >= 0xd800 && ch <= 0xdbff)
 	{
 	 /*
-	  * There can only be one root element!
+	  * Multi-word UTF-16 char...
 	  */
 
-	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
-          goto error;
-	}
+	  if ((lch = mxml_read_byte(in)) == EOF || (temp = mxml_read_byte(in)) == EOF)
+	    return (EOF);
 
-	if ((node = mxmlNewElement(parent, buffer)) == NULL)
-	{
-	 /*
-	  * Print error and return...
-	  */
+	  if (in->encoding == ENCODE_UTF16BE)
+	    lch = (lch << 8) | temp;
+	  else
+	    lch |= temp << 8;
 
-	  mxml_error("Unable to add processing instruction node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
-	  goto error;
-	}
+          if (lch < 0xdc00 || lch >= 0xdfff)
+	    return (EOF);
 
-        if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_DIRECTIVE, sax_data);
+          ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
+	}
+	break;
+  }
 
-          if (!mxmlRelease(node))
-            node = NULL;
-        }
+#if DEBUG > 1
+  printf("mxml_read_char: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
+#endif /* DEBUG > 1 */
 
-        if (node)
-	{
-	  if (!first)
-            first = node;
+  return (ch);
+}
 
-	  if (!parent)
-	  {
-	    parent = node;
 
-	    if (cb)
-	      type = (*cb)(parent);
-	    else
-	      type = MXML_TEXT;
-	  }
-	}
-      }
-      else if (buffer[0] == '!')
-      {
-       /*
-        * Gather rest of declaration...
-	*/
+/*
+ * 'mxml_read_control()' - Report a control character that is not allowed.
+ */
 
-	do
-	{
-	  if (ch == '>')
-	    break;
-	  else
-	  {
-            if (ch == '&')
-            {
-	      if ((ch = mxml_get_entity(parent, p, &encoding, getc_cb, &line)) == EOF)
-		goto error;
-            }
+static int				/* O - EOF */
+mxml_read_control(_mxml_read_t *in,	/* I - Input buffer */
+                  int          ch)	/* I - Control character */
+{
+  if (in->line)
+    mxml_error("Bad control character 0x%02x under parent <%s> on line %d not allowed by XML standard.", ch, *(in->parent) ? (*(in->parent))->value.element.name : "null", *(in->line));
+  else
+    mxml_error("Bad control character 0x%02x not allowed by XML standard.", ch);
 
-	    if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	      goto error;
-	  }
+  in->error = 1;
 
-	  if (ch == '\n')
-	    line ++;
-	}
-        while ((ch = (*getc_cb)(p, &encoding)) != EOF);
+  return (EOF);
+}
 
-       /*
-        * Error out if we didn't get the whole declaration...
-	*/
 
-        if (ch != '>')
-	{
-	 /*
-	  * Print error and return...
-	  */
+/*
+ * 'mxml_read_detect()' - Read the first block of input, checking for
+ *                        compressed data.
+ *
+ * Compressed input is decompressed a block at a time by switching the read
+ * callback to mxml_zread().
+ */
 
-	  mxml_error("Early EOF in declaration node on line %d.", line);
-	  goto error;
-	}
+static int				/* O - Bytes read, 0 on EOF, -1 on error */
+mxml_read_detect(_mxml_read_t *in)	/* I - Input buffer */
+{
+  int			bytes,		/* Bytes read */
+			more;		/* More bytes read */
+  mxml_compress_t	format;		/* Compression format */
+  _mxml_zstream_t	*z;		/* Decompression state */
 
-       /*
-        * Otherwise add this as an element under the current parent...
-	*/
 
-	*bufptr = '\0';
+  in->detect = 0;
 
-        if (!parent && first)
-	{
-	 /*
-	  * There can only be one root element!
-	  */
+ /*
+  * Read enough for the longest magic number...
+  */
 
-	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
-          goto error;
-	}
+  if ((bytes = (*in->read_cb)(in->read_data, in->buffer, sizeof(in->buffer))) <= 0)
+    return (bytes);
 
-	if ((node = mxmlNewElement(parent, buffer)) == NULL)
-	{
-	 /*
-	  * Print error and return...
-	  */
+  while (bytes < 4 && (more = (*in->read_cb)(in->read_data, in->buffer + bytes, sizeof(in->buffer) - (size_t)bytes)) > 0)
+    bytes += more;
 
-	  mxml_error("Unable to add declaration node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
-	  goto error;
-	}
+  if ((format = mxml_compressed(in->buffer, (size_t)bytes)) == MXML_COMPRESS_NONE)
+    return (bytes);
 
-        if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_DIRECTIVE, sax_data);
+ /*
+  * Move the compressed data to the decompression state and read through it...
+  */
 
-          if (!mxmlRelease(node))
-            node = NULL;
-        }
+  if ((z = mxml_zstream_new(format, 0)) == NULL)
+    return (-1);
 
-        if (node)
-	{
-	  if (!first)
-            first = node;
+  memcpy(z->buffer, in->buffer, (size_t)bytes);
 
-	  if (!parent)
-	  {
-	    parent = node;
+  z->read_cb   = in->read_cb;
+  z->read_data = in->read_data;
+  z->current   = z->buffer;
+  z->end       = z->buffer + bytes;
 
-	    if (cb)
-	      type = (*cb)(parent);
-	    else
-	      type = MXML_TEXT;
-	  }
-	}
-      }
-      else if (buffer[0] == '/')
-      {
-       /*
-        * Handle close tag...
-	*/
+  in->z         = z;
+  in->read_cb   = mxml_zread;
+  in->read_data = z;
 
-        if (!parent || strcmp(buffer + 1, parent->value.element.name))
-	{
-	 /*
-	  * Close tag doesn't match tree; print an error for now...
-	  */
+  return (mxml_zread(z, in->buffer, sizeof(in->buffer)));
+}
 
-	  mxml_error("Mismatched close tag <%s> under parent <%s> on line %d.", buffer, parent ? parent->value.element.name : "(null)", line);
-          goto error;
-	}
 
-       /*
-        * Keep reading until we see >...
-	*/
+/*
+ * 'mxml_read_free()' - Free the decompression state of an input buffer.
+ */
 
-        while (ch != '>' && ch != EOF)
-	  ch = (*getc_cb)(p, &encoding);
+static void
+mxml_read_free(_mxml_read_t *in)	/* I - Input buffer */
+{
+  if (in->z)
+  {
+    mxml_zstream_delete(in->z);
+    in->z = NULL;
+  }
+}
 
-        node   = parent;
-        parent = parent->parent;
 
-        if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_ELEMENT_CLOSE, sax_data);
+/*
+ * 'mxml_read_init()' - Initialize an input buffer for a read callback.
+ */
 
-          if (!mxmlRelease(node) && first == node)
-	    first = NULL;
-        }
+static void
+mxml_read_init(
+    _mxml_read_t    *in,		/* I - Input buffer */
+    _mxml_read_cb_t read_cb,		/* I - Read callback */
+    void            *read_data)		/* I - Read callback data */
+{
+  in->read_cb   = read_cb;
+  in->read_data = read_data;
+  in->encoding  = ENCODE_UTF8;
+  in->string    = 0;
+  in->inplace   = NULL;
+  in->error     = 0;
+  in->incomplete = 0;
+  in->line      = NULL;
+  in->parent    = NULL;
+  in->transcode = 0;
+  in->detect    = 1;
+  in->z         = NULL;
+  in->current   = in->buffer;
+  in->end       = in->buffer;
+  in->valid     = in->buffer;
+}
 
-       /*
-	* Ascend into the parent and set the value type as needed...
-	*/
 
-	if (cb && parent)
-	  type = (*cb)(parent);
-      }
-      else
-      {
-       /*
-        * Handle open tag...
-	*/
+/*
+ * 'mxml_read_inplace()' - Copy a decoded string back into the source buffer.
+ *
+ * Decoded UTF-8 strings are never longer than the markup they came from, so
+ * the copy lands in the part of the buffer that has already been read.  NULL
+ * is returned when not loading in place or if the string does not fit (which
+ * can happen for UTF-16 input), in which case the caller makes a copy.
+ */
 
-        if (!parent && first)
-	{
-	 /*
-	  * There can only be one root element!
-	  */
+static char *				/* O - String in source buffer or NULL */
+mxml_read_inplace(_mxml_read_t *in,	/* I - Input buffer */
+                  const char   *s)	/* I - String */
+{
+  char		*ptr;			/* String in source buffer */
+  size_t	len;			/* Length of string with nul */
 
-	  mxml_error("<%s> cannot be a second root node after <%s> on line %d.", buffer, first->value.element.name, line);
-          goto error;
-	}
 
-        if ((node = mxmlNewElement(parent, buffer)) == NULL)
-	{
-	 /*
-	  * Just print error for now...
-	  */
+  if (!in->inplace || (len = strlen(s) + 1) > (size_t)(in->current - in->inplace))
+    return (NULL);
 
-	  mxml_error("Unable to add element node to parent <%s> on line %d.", parent ? parent->value.element.name : "null", line);
-	  goto error;
-	}
+  ptr         = (char *)in->inplace;
+  in->inplace += len;
 
-        if (mxml_isspace(ch))
-        {
-	  if ((ch = mxml_parse_element(node, p, &encoding, getc_cb, &line)) == EOF)
-	    goto error;
-        }
-        else if (ch == '/')
-	{
-	  if ((ch = (*getc_cb)(p, &encoding)) != '>')
-	  {
-	    mxml_error("Expected > but got '%c' instead for element <%s/> on line %d.", ch, buffer, line);
-            mxmlDelete(node);
-            goto error;
-	  }
+  memcpy(ptr, s, len);
 
-	  ch = '/';
-	}
+  return (ptr);
+}
 
-        if (sax_cb)
-          (*sax_cb)(node, MXML_SAX_ELEMENT_OPEN, sax_data);
 
-        if (!first)
-	  first = node;
+/*
+ * 'mxml_read_partial()' - Check whether the next token is only partly buffered.
+ *
+ * The push parser uses this to stop in front of a character, entity, or
+ * markup sequence that continues past the end of the data fed so far.  The
+ * checks mirror how mxml_load_more() and mxml_parse_element() find the end
+ * of each token.  Byte order marks are consumed here so that the token
+ * after them gets checked as well.
+ */
 
-	if (ch == EOF)
-	  break;
+static int				/* O - 1 if more input is needed, 0 otherwise */
+mxml_read_partial(_mxml_read_t *in)	/* I - Input buffer */
+{
+  int			ch,		/* Current code unit */
+			c1, c2, c3,	/* Previous code units */
+			count,		/* Number of code units in markup */
+			quote,		/* Quote character */
+			start;		/* At start of attribute name or value? */
+  const unsigned char	*ptr;		/* Pointer into buffer */
+  char			prefix[9];	/* Start of markup */
 
-        if (ch != '/')
-	{
-	 /*
-	  * Descend into this node, setting the value type as needed...
-	  */
 
-	  parent = node;
+  for (;;)
+  {
+    ptr = in->current;
 
-	  if (cb && parent)
-	    type = (*cb)(parent);
-	  else
-	    type = MXML_TEXT;
-	}
-        else if (sax_cb)
-        {
-          (*sax_cb)(node, MXML_SAX_ELEMENT_CLOSE, sax_data);
+    if ((ch = mxml_read_unit(in, &ptr)) == EOF)
+      return (1);
 
-          if (!mxmlRelease(node) && first == node)
-            first = NULL;
-        }
-      }
+    if (in->encoding != ENCODE_UTF8 || ch < 0x80)
+      break;
 
-      bufptr  = buffer;
-    }
-    else if (ch == '&')
+    if (ch == 0xfe || ch == 0xff)
     {
      /*
-      * Add character entity to current buffer...
+      * UTF-16 BOM?
       */
 
-      if ((ch = mxml_get_entity(parent, p, &encoding, getc_cb, &line)) == EOF)
-	goto error;
+      if (ptr >= in->end)
+        return (1);
+      else if (*ptr != (ch ^ 1))
+        return (0);
 
-      if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	goto error;
+      in->encoding = ch == 0xfe ? ENCODE_UTF16BE : ENCODE_UTF16LE;
+      in->current  = ptr + 1;
     }
-    else if (type == MXML_OPAQUE || type == MXML_CUSTOM || !mxml_isspace(ch))
+    else if (ch == 0xef && (in->end - ptr) >= 2 && ptr[0] == 0xbb && ptr[1] == 0xbf)
     {
      /*
-      * Add character to current buffer...
+      * UTF-8 BOM...
       */
 
-      if (mxml_add_char(ch, &bufptr, &buffer, &bufsize))
-	goto error;
-    }
+      in->current = ptr + 2;
+    }
+    else if ((ch & 0xe0) == 0xc0)
+      return (ptr >= in->end);
+    else if ((ch & 0xf0) == 0xe0)
+      return ((in->end - ptr) < 2);
+    else if ((ch & 0xf8) == 0xf0)
+      return ((in->end - ptr) < 3);
+    else
+      return (0);
+  }
+
+  if (ch >= 0xd800 && ch <= 0xdbff)
+  {
+   /*
+    * UTF-16 surrogate pair...
+    */
+
+    return (mxml_read_unit(in, &ptr) == EOF);
+  }
+  else if (ch == '&')
+  {
+   /*
+    * Entity, which ends with the first non-alphanumeric character...
+    */
+
+    while ((ch = mxml_read_unit(in, &ptr)) != EOF)
+      if (ch > 126 || (!isalnum(ch) && ch != '#'))
+        return (0);
+
+    return (1);
   }
+  else if (ch != '<')
+    return (0);
 
  /*
-  * Free the string buffer - we don't need it anymore...
+  * Markup - look at the first few characters to see what kind it is...
   */
 
-  free(buffer);
+  for (count = 0; count < 8 && (ch = mxml_read_unit(in, &ptr)) != EOF; count ++)
+    prefix[count] = ch < 0x80 ? (char)ch : '\x80';
 
- /*
-  * Find the top element and return it...
-  */
+  prefix[count] = '\0';
 
-  if (parent)
+  if (!strncmp(prefix, "!--", 3))
   {
-    node = parent;
+   /*
+    * Comment, which ends with "-->" (but not "--->")...
+    */
 
-    while (parent != top && parent->parent)
-      parent = parent->parent;
+    for (ptr = in->current + (in->encoding == ENCODE_UTF8 ? 4 : 8), count = 3, c3 = '!', c2 = c1 = '-'; (ch = mxml_read_unit(in, &ptr)) != EOF; count ++, c3 = c2, c2 = c1, c1 = ch)
+      if (ch == '>' && count > 4 && c3 != '-' && c2 == '-' && c1 == '-')
+        return (0);
 
-    if (node != parent)
-    {
-      mxml_error("Missing close tag </%s> under parent <%s> on line %d.", node->value.element.name, node->parent ? node->parent->value.element.name : "(null)", line);
+    return (1);
+  }
+  else if (!strcmp(prefix, "![CDATA["))
+  {
+   /*
+    * CDATA, which ends with "]]>"...
+    */
 
-      mxmlDelete(first);
+    for (ptr = in->current + (in->encoding == ENCODE_UTF8 ? 9 : 18), c2 = 'A', c1 = '['; (ch = mxml_read_unit(in, &ptr)) != EOF; c2 = c1, c1 = ch)
+      if (ch == '>' && c2 == ']' && c1 == ']')
+        return (0);
 
-      return (NULL);
-    }
+    return (1);
   }
+  else if (!strncmp(prefix, "!--", (size_t)count) || !strncmp(prefix, "![CDATA[", (size_t)count))
+  {
+   /*
+    * Not enough data to tell a comment or CDATA from a declaration...
+    */
 
-  if (parent)
-    return (parent);
-  else
-    return (first);
+    return (1);
+  }
+  else if (prefix[0] == '?')
+  {
+   /*
+    * Processing instruction, which ends with "?>"...
+    */
+
+    for (ptr = in->current + (in->encoding == ENCODE_UTF8 ? 2 : 4), c1 = '?'; (ch = mxml_read_unit(in, &ptr)) != EOF; c1 = ch)
+      if (ch == '>' && c1 == '?')
+        return (0);
+
+    return (1);
+  }
+  else if (prefix[0] == '!')
+  {
+   /*
+    * Declaration, which ends with the first ">"...
+    */
+
+    for (ptr = in->current + (in->encoding == ENCODE_UTF8 ? 1 : 2); (ch = mxml_read_unit(in, &ptr)) != EOF;)
+      if (ch == '>')
+        return (0);
+
+    return (1);
+  }
 
  /*
-  * Common error return...
+  * Element, which ends with the first ">" outside of a quoted attribute name
+  * or value...
   */
 
-  error:
+  for (ptr = in->current + (in->encoding == ENCODE_UTF8 ? 1 : 2), quote = 0, start = 0; (ch = mxml_read_unit(in, &ptr)) != EOF;)
+  {
+    if (quote)
+    {
+      if (ch == quote)
+        quote = start = 0;
+    }
+    else if (ch == '>')
+      return (0);
+    else if (start && (ch == '\"' || ch == '\''))
+      quote = ch;
+    else
+      start = mxml_isspace(ch) || ch == '=';
+  }
 
-  mxmlDelete(first);
+  return (1);
+}
 
-  free(buffer);
 
-  return (NULL);
+/*
+ * 'mxml_read_string()' - Initialize an input buffer for a nul-terminated string.
+ */
+
+static void
+mxml_read_string(_mxml_read_t *in,	/* I - Input buffer */
+                 const char   *s)	/* I - String */
+{
+  in->read_cb   = NULL;
+  in->read_data = NULL;
+  in->encoding  = ENCODE_UTF8;
+  in->string    = 1;
+  in->inplace   = NULL;
+  in->error     = 0;
+  in->incomplete = 0;
+  in->line      = NULL;
+  in->parent    = NULL;
+  in->transcode = 0;
+  in->detect    = 0;
+  in->z         = NULL;
+  in->current   = (const unsigned char *)s;
+  in->end       = (const unsigned char *)s + strlen(s);
+  in->valid     = in->current;
 }
 
 
 /*
- * 'mxml_parse_element()' - Parse an element for any attributes...
+ * 'mxml_read_unit()' - Get the next code unit from the input buffer.
+ *
+ * This looks ahead without consuming anything, returning bytes for UTF-8
+ * and 16-bit words for UTF-16.
  */
 
-static int				/* O  - Terminating character */
-mxml_parse_element(
-    mxml_node_t     *node,		/* I  - Element node */
-    void            *p,			/* I  - Data to read from */
-    int             *encoding,		/* IO - Encoding */
-    _mxml_getc_cb_t getc_cb,		/* I  - Data callback */
-    int             *line)		/* IO - Current line number */
+static int				/* O  - Code unit or EOF if not buffered */
+mxml_read_unit(_mxml_read_t        *in,	/* I  - Input buffer */
+               const unsigned char **ptr)
+					/* IO - Position in input buffer */
 {
-  int	ch,				/* Current character in file */
-	quote;				/* Quoting character */
-  char	*name,				/* Attribute name */
-	*value,				/* Attribute value */
-	*ptr;				/* Pointer into name/value */
-  int	namesize,			/* Size of name string */
-	valsize;			/* Size of value string */
-
+  const unsigned char	*p = *ptr;	/* Position in input buffer */
 
- /*
-  * Initialize the name and value buffers...
-  */
 
-  if ((name = malloc(64)) == NULL)
+  if (in->encoding == ENCODE_UTF8)
   {
-    mxml_error("Unable to allocate memory for name!");
-    return (EOF);
-  }
+    if (p >= in->end)
+      return (EOF);
 
-  namesize = 64;
+    *ptr = p + 1;
 
-  if ((value = malloc(64)) == NULL)
-  {
-    free(name);
-    mxml_error("Unable to allocate memory for value!");
-    return (EOF);
+    return (*p);
   }
+  else if ((in->end - p) < 2)
+    return (EOF);
 
-  valsize = 64;
+  *ptr = p + 2;
 
- /*
-  * Loop until we hit a >, /, ?, or EOF...
-  */
+  if (in->encoding == ENCODE_UTF16BE)
+    return ((p[0] << 8) | p[1]);
+  else
+    return (p[0] | (p[1] << 8));
+}
 
-  while ((ch = (*getc_cb)(p, encoding)) != EOF)
-  {
-#if DEBUG > 1
-    fprintf(stderr, "parse_element: ch='%c'\n", ch);
-#endif /* DEBUG > 1 */
 
+/*
+ * 'mxml_read_utf16()' - Convert the next block of UTF-16 input to UTF-8.
+ *
+ * Input from a read callback is read into the input buffer at
+ * MXML_UTF16_OFFSET and converted to the start of the same buffer, never
+ * writing past the unconverted input.  Fixed buffers and strings are
+ * converted straight from the caller's memory.  Runs of ASCII are converted
+ * 8 code units at a time with SSE2 when available.
+ */
+
+static int				/* O - Number of bytes converted or 0 at end of input */
+mxml_read_utf16(_mxml_read_t *in)	/* I - Input buffer */
+{
+  int			ch,		/* Current character */
+			lch,		/* Low surrogate */
+			bytes,		/* Bytes read */
+			len;		/* Length of UTF-8 sequence */
+  size_t		left;		/* Unconverted bytes left */
+  const unsigned char	*src,		/* Current UTF-16 input */
+			*next;		/* Next UTF-16 input */
+  unsigned char		*out,		/* Current UTF-8 output */
+			*outend;	/* End of UTF-8 output */
+#ifdef HAVE_X86_SIMD
+  __m128i		units;		/* 8 code units */
+  const __m128i		nonascii = _mm_set1_epi16((short)0xff80),
+			zero = _mm_setzero_si128();
+					/* Constants */
+#endif /* HAVE_X86_SIMD */
+
+
+  if (in->read_cb && (left = (size_t)(in->srcend - in->src)) < 4)
+  {
    /*
-    * Skip leading whitespace...
+    * Keep any partial character and read more input...
     */
 
-    if (mxml_isspace(ch))
-    {
-      if (ch == '\n')
-        (*line)++;
+    memmove(in->buffer + MXML_UTF16_OFFSET, in->src, left);
 
-      continue;
+    if ((bytes = (*in->read_cb)(in->read_data, in->buffer + MXML_UTF16_OFFSET + left, sizeof(in->buffer) - MXML_UTF16_OFFSET - left)) < 0)
+    {
+      in->error = 1;
+      bytes     = 0;
     }
 
-   /*
-    * Stop at /, ?, or >...
-    */
+    in->src    = in->buffer + MXML_UTF16_OFFSET;
+    in->srcend = in->src + left + bytes;
+  }
 
-    if (ch == '/' || ch == '?')
+  for (src = in->src, out = in->buffer, outend = in->buffer + sizeof(in->buffer); (in->srcend - src) >= 2; src = next)
+  {
+#ifdef HAVE_X86_SIMD
+    if ((in->srcend - src) >= 16 && (outend - out) >= 8)
     {
-     /*
-      * Grab the > character and print an error if it isn't there...
-      */
+      units = _mm_loadu_si128((const __m128i *)src);
 
-      quote = (*getc_cb)(p, encoding);
+      if (in->transcode == ENCODE_UTF16BE)
+        units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
 
-      if (quote != '>')
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, nonascii), zero)) == 0xffff)
       {
-        mxml_error("Expected '>' after '%c' for element %s, but got '%c' on line %d.", ch, node->value.element.name, quote, *line);
-        goto error;
-      }
+        _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(units, units));
 
-      break;
-    }
-    else if (ch == '<')
-    {
-      mxml_error("Bare < in element %s on line %d.", node->value.element.name, *line);
-      goto error;
+        next = src + 16;
+        out  += 8;
+        continue;
+      }
     }
-    else if (ch == '>')
-      break;
+#endif /* HAVE_X86_SIMD */
 
-   /*
-    * Read the attribute name...
-    */
+    if (in->transcode == ENCODE_UTF16BE)
+      ch = (src[0] << 8) | src[1];
+    else
+      ch = src[0] | (src[1] << 8);
 
-    name[0] = ch;
-    ptr     = name + 1;
+    next = src + 2;
 
-    if (ch == '\"' || ch == '\'')
+    if (ch >= 0xd800 && ch <= 0xdbff)
     {
      /*
-      * Name is in quotes, so get a quoted string...
+      * Multi-word UTF-16 char...
       */
 
-      quote = ch;
+      if ((in->srcend - src) < 4)
+        break;
+
+      if (in->transcode == ENCODE_UTF16BE)
+	lch = (src[2] << 8) | src[3];
+      else
+	lch = src[2] | (src[3] << 8);
 
-      while ((ch = (*getc_cb)(p, encoding)) != EOF)
+      if (lch < 0xdc00 || lch > 0xdfff)
       {
-        if (ch == '&')
+        if (out == in->buffer)
         {
-	  if ((ch = mxml_get_entity(node, p, encoding, getc_cb, line)) == EOF)
-	    goto error;
+	  mxml_error("Invalid UTF-16 surrogate pair 0x%04x 0x%04x!", ch, lch);
+	  in->error = 1;
 	}
-	else if (ch == '\n')
-	  (*line)++;
-
-	if (mxml_add_char(ch, &ptr, &name, &namesize))
-	  goto error;
-
-	if (ch == quote)
-          break;
+	break;
       }
+
+      ch   = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
+      next = src + 4;
     }
-    else
+
+    len = ch < 0x80 ? 1 : ch < 0x800 ? 2 : ch < 0x10000 ? 3 : 4;
+
+    if (out + len > (in->read_cb ? next : outend))
+      break;
+
+    switch (len)
     {
-     /*
-      * Grab an normal, non-quoted name...
-      */
+      case 1 :
+          *out++ = (unsigned char)ch;
+          break;
 
-      while ((ch = (*getc_cb)(p, encoding)) != EOF)
-      {
-	if (mxml_isspace(ch) || ch == '=' || ch == '/' || ch == '>' ||
-	    ch == '?')
-	{
-	  if (ch == '\n')
-	    (*line)++;
+      case 2 :
+          *out++ = (unsigned char)(0xc0 | (ch >> 6));
+          *out++ = (unsigned char)(0x80 | (ch & 0x3f));
           break;
-        }
-	else
-	{
-          if (ch == '&')
-          {
-	    if ((ch = mxml_get_entity(node, p, encoding, getc_cb, line)) == EOF)
-	      goto error;
-          }
 
-	  if (mxml_add_char(ch, &ptr, &name, &namesize))
-	    goto error;
-	}
-      }
+      case 3 :
+          *out++ = (unsigned char)(0xe0 | (ch >> 12));
+          *out++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3f));
+          *out++ = (unsigned char)(0x80 | (ch & 0x3f));
+          break;
+
+      default :
+          *out++ = (unsigned char)(0xf0 | (ch >> 18));
+          *out++ = (unsigned char)(0x80 | ((ch >> 12) & 0x3f));
+          *out++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3f));
+          *out++ = (unsigned char)(0x80 | (ch & 0x3f));
+          break;
     }
+  }
+
+  in->src     = src;
+  in->current = in->buffer;
+  in->end     = out;
+  in->valid   = in->buffer;
+
+  return ((int)(out - in->buffer));
+}
+
+
+/*
+ * 'mxml_read_valid()' - Check the UTF-8 input starting at a character.
+ *
+ * Up to MXML_VALID_MAX bytes are checked at a time.  The end of the checked
+ * input is returned; it is the same as "ptr" if the character at "ptr" is
+ * invalid or not completely buffered, in which case mxml_read_char() reports
+ * the error.
+ */
+
+static const unsigned char *		/* O - End of checked input */
+mxml_read_valid(
+    _mxml_read_t        *in,		/* I - Input buffer */
+    const unsigned char *ptr)		/* I - Start of character */
+{
+  return (in->valid = mxml_validate(ptr, (in->end - ptr) > MXML_VALID_MAX ? ptr + MXML_VALID_MAX : in->end));
+}
+
+
+/*
+ * 'mxml_reader_new()' - Create a pull reader without an input source.
+ */
+
+static mxml_reader_t *			/* O - New reader or NULL on error */
+mxml_reader_new(void)
+{
+  mxml_reader_t	*reader;		/* New reader */
 
-    *ptr = '\0';
 
-    if (mxmlElementGetAttr(node, name))
+  if ((reader = _mxml_calloc(1, sizeof(mxml_reader_t))) == NULL)
+  {
+    mxml_error("Unable to allocate memory for pull reader.");
+    return (NULL);
+  }
+
+  if (mxml_load_init(&reader->load, NULL, MXML_OPAQUE_CALLBACK, MXML_NO_CALLBACK, NULL))
+  {
+    _mxml_free(reader);
+    return (NULL);
+  }
+
+  mxml_views_init(&reader->views, mxml_reader_view_cb, reader);
+
+  reader->load.views = &reader->views;
+
+  return (reader);
+}
+
+
+/*
+ * 'mxml_reader_string()' - Copy a string to the pull reader.
+ */
+
+static size_t				/* O - Offset of string or MXML_NO_OFFSET on error */
+mxml_reader_string(
+    mxml_reader_t *reader,		/* I - Reader */
+    const char    *s)			/* I - String */
+{
+  size_t	len = strlen(s) + 1,	/* Length of string with nul */
+		offset;			/* Offset of string */
+
+
+  if ((reader->strused + len) > reader->strsize)
+  {
+    size_t	strsize = reader->strsize ? reader->strsize : 1024;
+					/* New size of string buffer */
+    char	*strings;		/* New string buffer */
+
+    while (strsize < (reader->strused + len))
+      strsize *= 2;
+
+    if ((strings = _mxml_realloc(reader->strings, strsize)) == NULL)
     {
-      mxml_error("Duplicate attribute '%s' in element %s on line %d.", name, node->value.element.name, name, *line);
-      goto error;
+      mxml_error("Unable to allocate memory for pull reader strings.");
+      reader->error = 1;
+      return (MXML_NO_OFFSET);
     }
 
-    while (ch != EOF && mxml_isspace(ch))
-    {
-      ch = (*getc_cb)(p, encoding);
+    reader->strings = strings;
+    reader->strsize = strsize;
+  }
 
-      if (ch == '\n')
-        (*line)++;
-    }
+  offset = reader->strused;
 
-    if (ch == '=')
-    {
-     /*
-      * Read the attribute value...
-      */
+  memcpy(reader->strings + offset, s, len);
 
-      while ((ch = (*getc_cb)(p, encoding)) != EOF && mxml_isspace(ch))
-      {
-        if (ch == '\n')
-          (*line)++;
-      }
+  reader->strused += len;
+
+  return (offset);
+}
+
+
+/*
+ * 'mxml_reader_view_cb()' - Record a loaded token as a pull reader event.
+ *
+ * The strings are only valid during the callback, so they are copied to the
+ * reader and the load is paused.
+ */
+
+static void
+mxml_reader_view_cb(
+    mxml_sax_event_t   sax_event,	/* I - SAX event */
+    const char         *name,		/* I - Element name or NULL */
+    const char * const *attrs,		/* I - Attribute name/value pairs */
+    const char         *text,		/* I - Data or CDATA text or NULL */
+    size_t             textlen,		/* I - Length of text */
+    void               *data)		/* I - Reader */
+{
+  mxml_reader_t	*reader = (mxml_reader_t *)data;
+					/* Reader */
+  _mxml_event_t	*event;			/* New event */
+  _mxml_rattr_t	*rattr;			/* New reader attribute */
+  int		num_attrs;		/* Number of attributes */
+
+
+  (void)textlen;
+
+  if (reader->error)
+    return;
+
+  reader->load.pause = 1;
+
+  if (reader->num_events >= (int)(sizeof(reader->events) / sizeof(reader->events[0])))
+  {
+    mxml_error("Too many pull reader events.");
+    reader->error = 1;
+    return;
+  }
+
+  event             = reader->events + reader->num_events;
+  event->event      = (mxml_reader_event_t)(sax_event + MXML_READER_CDATA);
+  event->first_attr = reader->num_attrs;
+  event->num_attrs  = 0;
+  event->name       = MXML_NO_OFFSET;
+  event->text       = MXML_NO_OFFSET;
+
+  if (sax_event == MXML_SAX_ELEMENT_OPEN)
+    event->depth = reader->depth ++;
+  else if (sax_event == MXML_SAX_ELEMENT_CLOSE)
+    event->depth = -- reader->depth;
+  else
+    event->depth = reader->depth;
+
+  if (sax_event == MXML_SAX_DATA)
+  {
+    if ((event->text = mxml_reader_string(reader, text)) == MXML_NO_OFFSET)
+      return;
+  }
+  else if ((event->name = mxml_reader_string(reader, name)) == MXML_NO_OFFSET)
+    return;
+  else if (sax_event == MXML_SAX_CDATA)
+    event->text = event->name + 8;
+  else if (sax_event == MXML_SAX_ELEMENT_OPEN && attrs[0])
+  {
+   /*
+    * Copy the attributes...
+    */
+
+    for (num_attrs = 0; attrs[2 * num_attrs]; num_attrs ++);
 
-      if (ch == EOF)
-      {
-        mxml_error("Missing value for attribute '%s' in element %s on line %d.", name, node->value.element.name, *line);
-        goto error;
-      }
+    if ((reader->num_attrs + num_attrs) > reader->alloc_attrs)
+    {
+      int		alloc_attrs = reader->num_attrs + num_attrs + 16;
+					/* New attribute count */
 
-      if (ch == '\'' || ch == '\"')
+      if ((rattr = _mxml_realloc(reader->attrs, (size_t)alloc_attrs * sizeof(_mxml_rattr_t))) == NULL)
       {
-       /*
-        * Read quoted value...
-	*/
-
-        quote = ch;
-	ptr   = value;
+        mxml_error("Unable to allocate memory for pull reader attributes.");
+        reader->error = 1;
+        return;
+      }
 
-        while ((ch = (*getc_cb)(p, encoding)) != EOF)
-        {
-	  if (ch == quote)
-	  {
-	    break;
-	  }
-	  else
-	  {
-	    if (ch == '&')
-	    {
-	      if ((ch = mxml_get_entity(node, p, encoding, getc_cb, line)) == EOF)
-	        goto error;
-	    }
-	    else if (ch == '\n')
-	      (*line)++;
+      reader->attrs       = rattr;
+      reader->alloc_attrs = alloc_attrs;
+    }
 
-	    if (mxml_add_char(ch, &ptr, &value, &valsize))
-	      goto error;
-	  }
-	}
+    for (rattr = reader->attrs + reader->num_attrs; *attrs; attrs += 2, rattr ++)
+    {
+      if ((rattr->name = mxml_reader_string(reader, attrs[0])) == MXML_NO_OFFSET)
+        return;
 
-        *ptr = '\0';
-      }
-      else
-      {
-       /*
-        * Read unquoted value...
-	*/
+      if (!attrs[1])
+        rattr->value = MXML_NO_OFFSET;
+      else if ((rattr->value = mxml_reader_string(reader, attrs[1])) == MXML_NO_OFFSET)
+        return;
+    }
 
-	value[0] = ch;
-	ptr      = value + 1;
+    event->num_attrs  = num_attrs;
+    reader->num_attrs += num_attrs;
+  }
 
-	while ((ch = (*getc_cb)(p, encoding)) != EOF)
-	{
-	  if (mxml_isspace(ch) || ch == '=' || ch == '/' || ch == '>')
-	  {
-	    if (ch == '\n')
-	      (*line)++;
+  reader->num_events ++;
+}
 
-            break;
-          }
-	  else
-	  {
-	    if (ch == '&')
-	    {
-	      if ((ch = mxml_get_entity(node, p, encoding, getc_cb, line)) == EOF)
-	        goto error;
-	    }
 
-	    if (mxml_add_char(ch, &ptr, &value, &valsize))
-	      goto error;
-	  }
-	}
+/*
+ * 'mxml_records_sax_cb()' - Keep the nodes of records and pass on finished ones.
+ *
+ * Every node inside a record is retained so that it survives the release
+ * after the SAX callback.  The record itself gets one extra reference that
+ * is dropped after the record callback, leaving the loader's release to
+ * delete it unless the record callback retained it as well.
+ */
 
-        *ptr = '\0';
-      }
+static void
+mxml_records_sax_cb(
+    mxml_node_t      *node,		/* I - Loaded node */
+    mxml_sax_event_t event,		/* I - SAX event */
+    void             *data)		/* I - Record loading state */
+{
+  _mxml_records_t	*records = (_mxml_records_t *)data;
+					/* Record loading state */
 
-     /*
-      * Set the attribute with the given string value...
-      */
 
-      mxmlElementSetAttr(node, name, value);
-    }
-    else
+  if (event == MXML_SAX_ELEMENT_OPEN)
+  {
+    if (records->depth > 0 || !strcmp(node->value.element.name, records->name))
     {
-      mxml_error("Missing value for attribute '%s' in element %s on line %d.", name, node->value.element.name, *line);
-      goto error;
-    }
+      records->depth ++;
 
+      mxmlRetain(node);
+    }
+  }
+  else if (records->depth == 0)
+    return;
+  else if (event != MXML_SAX_ELEMENT_CLOSE)
+    mxmlRetain(node);
+  else if (-- records->depth == 0)
+  {
    /*
-    * Check the end character...
+    * The record is complete, detach it from its parent and hand it over...
     */
 
-    if (ch == '/' || ch == '?')
-    {
-     /*
-      * Grab the > character and print an error if it isn't there...
-      */
+    mxmlRemove(node);
 
-      quote = (*getc_cb)(p, encoding);
+    records->count ++;
 
-      if (quote != '>')
-      {
-        mxml_error("Expected '>' after '%c' for element %s, but got '%c' on line %d.", ch, node->value.element.name, quote, *line);
-        ch = EOF;
-      }
+    (*records->cb)(node, records->data);
 
-      break;
-    }
-    else if (ch == '>')
-      break;
+    mxmlRelease(node);
   }
+}
+
+
+/*
+ * 'mxml_save_fd()' - Save an XML tree to a file or file descriptor using a
+ *                    buffer, compressing as needed.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_save_fd(mxml_node_t    *node,	/* I - Node to write */
+             int            fd,		/* I - File descriptor to write to */
+             FILE           *fp,	/* I - File to write to or NULL to use the file descriptor */
+             mxml_save_cb_t cb)		/* I - Whitespace callback or @code MXML_NO_CALLBACK@ */
+{
+  int		col;			/* Final column */
+  _mxml_fdbuf_t	buf;			/* File descriptor buffer */
+  _mxml_global_t *global = _mxml_global();
+					/* Global data */
+
 
  /*
-  * Free the name and value buffers and return...
+  * Initialize the file descriptor buffer...
   */
 
-  free(name);
-  free(value);
+  buf.fd      = fd;
+  buf.fp      = fp;
+  buf.z       = NULL;
+  buf.current = buf.buffer;
+  buf.end     = buf.buffer + sizeof(buf.buffer);
 
-  return (ch);
+  if (global->compression != MXML_COMPRESS_NONE && (buf.z = mxml_zstream_new(global->compression, 1)) == NULL)
+    return (-1);
 
  /*
-  * Common error return point...
+  * Write the node...
   */
 
-  error:
+  if ((col = mxml_write_node(node, &buf, cb, 0, mxml_fd_putc, global)) < 0 || (col > 0 && mxml_fd_putc('\n', &buf) < 0))
+  {
+    if (buf.z)
+      mxml_zstream_delete(buf.z);
 
-  free(name);
-  free(value);
+    return (-1);
+  }
 
-  return (EOF);
+ /*
+  * Flush and return...
+  */
+
+  return (mxml_fd_finish(&buf));
 }
 
 
 /*
- * 'mxml_string_getc()' - Get a character from a string.
+ * 'mxml_scan()' - Find the end of a run of plain characters.
+ *
+ * Newlines in the run are added to the line number.  The SSE2 and AVX2
+ * versions are used when the CPU supports them; they look at 16 or 32
+ * bytes at a time and leave the last few bytes to the table lookup below.
  */
 
-static int				/* O  - Character or EOF */
-mxml_string_getc(void *p,		/* I  - Pointer to file */
-                 int  *encoding)	/* IO - Encoding */
+static const unsigned char *		/* O  - First non-plain character or end */
+mxml_scan(const unsigned char *ptr,	/* I  - Start of run */
+          const unsigned char *end,	/* I  - End of buffer */
+          int                 scan,	/* I  - Scanning context (MXML_SCAN_xxx) */
+          int                 *line)	/* IO - Current line number */
 {
-  int		ch;			/* Character */
-  const char	**s;			/* Pointer to string pointer */
+#ifdef HAVE_X86_SIMD
+  const _mxml_simd_t	*simd = mxml_scan_simd + __builtin_ctz(scan);
+					/* Vector scanning parameters */
+
+
+  if (__builtin_cpu_supports("avx2"))
+    ptr = mxml_scan_avx2(ptr, end, simd, line);
+  else
+    ptr = mxml_scan_sse2(ptr, end, simd, line);
+
+  if (ptr < end && !(mxml_scan_chars[*ptr] & scan))
+    return (ptr);
+#endif /* HAVE_X86_SIMD */
+
+  for (; ptr < end && (mxml_scan_chars[*ptr] & scan); ptr ++)
+    if (*ptr == '\n')
+      (*line)++;
+
+  return (ptr);
+}
 
 
-  s = (const char **)p;
+#ifdef HAVE_X86_SIMD
+/*
+ * 'mxml_scan_avx2()' - Find the end of a run of plain characters, 32 bytes at a time.
+ */
 
-  if ((ch = (*s)[0] & 255) != 0 || *encoding == ENCODE_UTF16LE)
+static const unsigned char *		/* O  - First non-plain character or start of remainder */
+mxml_scan_avx2(
+    const unsigned char *ptr,		/* I  - Start of run */
+    const unsigned char *end,		/* I  - End of buffer */
+    const _mxml_simd_t  *simd,		/* I  - Vector scanning parameters */
+    int                 *line)		/* IO - Current line number */
+{
+  __m256i	bytes,			/* Input bytes */
+		plain,			/* Plain characters */
+		stop;			/* Stop characters */
+  unsigned	mask,			/* Non-plain characters */
+		nl;			/* Newlines */
+  const __m256i	lo    = _mm256_set1_epi8(simd->lo - 1),
+		extra0 = _mm256_set1_epi8(simd->extra[0]),
+		extra1 = _mm256_set1_epi8(simd->extra[1]),
+		extra2 = _mm256_set1_epi8(simd->extra[2]),
+		stop0 = _mm256_set1_epi8(simd->stop[0]),
+		stop1 = _mm256_set1_epi8(simd->stop[1]),
+		stop2 = _mm256_set1_epi8(simd->stop[2]),
+		newline = _mm256_set1_epi8('\n');
+					/* Character constants */
+
+
+  for (; (end - ptr) >= 32; ptr += 32)
   {
    /*
-    * Got character; convert UTF-8 to integer and return...
+    * Bytes 0x80 and up compare as negative, so they are never plain...
     */
 
-    (*s)++;
+    bytes = _mm256_loadu_si256((const __m256i *)ptr);
+    plain = _mm256_or_si256(_mm256_cmpgt_epi8(bytes, lo),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, extra0),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, extra1), _mm256_cmpeq_epi8(bytes, extra2))));
+    stop  = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, stop0),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, stop1), _mm256_cmpeq_epi8(bytes, stop2)));
+    mask  = ~(unsigned)_mm256_movemask_epi8(_mm256_andnot_si256(stop, plain));
+    nl    = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline));
 
-    switch (*encoding)
+    if (mask)
     {
-      case ENCODE_UTF8 :
-	  if (!(ch & 0x80))
-	  {
-#if DEBUG > 1
-            printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+      mask   = (unsigned)__builtin_ctz(mask);
+      *line += __builtin_popcount(nl & ((1U << mask) - 1));
 
-	    if (mxml_bad_char(ch))
-	    {
-	      mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        		 ch);
-	      return (EOF);
-	    }
+      return (ptr + mask);
+    }
 
-	    return (ch);
-          }
-	  else if (ch == 0xfe)
-	  {
-	   /*
-	    * UTF-16 big-endian BOM?
-	    */
+    *line += __builtin_popcount(nl);
+  }
 
-            if (((*s)[0] & 255) != 0xff)
-	      return (EOF);
+  return (mxml_scan_sse2(ptr, end, simd, line));
+}
 
-	    *encoding = ENCODE_UTF16BE;
-	    (*s)++;
 
-	    return (mxml_string_getc(p, encoding));
-	  }
-	  else if (ch == 0xff)
-	  {
-	   /*
-	    * UTF-16 little-endian BOM?
-	    */
+/*
+ * 'mxml_scan_sse2()' - Find the end of a run of plain characters, 16 bytes at a time.
+ */
 
-            if (((*s)[0] & 255) != 0xfe)
-	      return (EOF);
+static const unsigned char *		/* O  - First non-plain character or start of remainder */
+mxml_scan_sse2(
+    const unsigned char *ptr,		/* I  - Start of run */
+    const unsigned char *end,		/* I  - End of buffer */
+    const _mxml_simd_t  *simd,		/* I  - Vector scanning parameters */
+    int                 *line)		/* IO - Current line number */
+{
+  __m128i	bytes,			/* Input bytes */
+		plain,			/* Plain characters */
+		stop;			/* Stop characters */
+  unsigned	mask,			/* Non-plain characters */
+		nl;			/* Newlines */
+  const __m128i	lo    = _mm_set1_epi8(simd->lo - 1),
+		extra0 = _mm_set1_epi8(simd->extra[0]),
+		extra1 = _mm_set1_epi8(simd->extra[1]),
+		extra2 = _mm_set1_epi8(simd->extra[2]),
+		stop0 = _mm_set1_epi8(simd->stop[0]),
+		stop1 = _mm_set1_epi8(simd->stop[1]),
+		stop2 = _mm_set1_epi8(simd->stop[2]),
+		newline = _mm_set1_epi8('\n');
+					/* Character constants */
+
+
+  for (; (end - ptr) >= 16; ptr += 16)
+  {
+    bytes = _mm_loadu_si128((const __m128i *)ptr);
+    plain = _mm_or_si128(_mm_cmpgt_epi8(bytes, lo),
+                         _mm_or_si128(_mm_cmpeq_epi8(bytes, extra0),
+                                      _mm_or_si128(_mm_cmpeq_epi8(bytes, extra1), _mm_cmpeq_epi8(bytes, extra2))));
+    stop  = _mm_or_si128(_mm_cmpeq_epi8(bytes, stop0),
+                         _mm_or_si128(_mm_cmpeq_epi8(bytes, stop1), _mm_cmpeq_epi8(bytes, stop2)));
+    mask  = ~(unsigned)_mm_movemask_epi8(_mm_andnot_si128(stop, plain)) & 0xffff;
+    nl    = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+
+    if (mask)
+    {
+      mask   = (unsigned)__builtin_ctz(mask);
+      *line += __builtin_popcount(nl & ((1U << mask) - 1));
 
-	    *encoding = ENCODE_UTF16LE;
-	    (*s)++;
+      return (ptr + mask);
+    }
 
-	    return (mxml_string_getc(p, encoding));
-	  }
-	  else if ((ch & 0xe0) == 0xc0)
-	  {
-	   /*
-	    * Two-byte value...
-	    */
+    *line += __builtin_popcount(nl);
+  }
 
-	    if (((*s)[0] & 0xc0) != 0x80)
-              return (EOF);
+  return (ptr);
+}
+#endif /* HAVE_X86_SIMD */
 
-	    ch = ((ch & 0x1f) << 6) | ((*s)[0] & 0x3f);
 
-	    (*s)++;
+/*
+ * 'mxml_skip_markup()' - Skip markup the same way the loader reads it.
+ */
 
-	    if (ch < 0x80)
-	    {
-	      mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	      return (EOF);
-	    }
+static const unsigned char *		/* O  - Pointer after markup or NULL if incomplete */
+mxml_skip_markup(
+    const unsigned char *ptr,		/* I  - Pointer after "<" */
+    const unsigned char *end,		/* I  - End of buffer */
+    int                 *depth,		/* IO - Element depth */
+    int                 *element)	/* O  - 1 for element tags, 0 otherwise */
+{
+  const unsigned char	*start = ptr;	/* Start of markup */
+  int			quote = 0,	/* Quote character */
+			value = 0;	/* At start of attribute name or value? */
 
-#if DEBUG > 1
-            printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
 
-	    return (ch);
-	  }
-	  else if ((ch & 0xf0) == 0xe0)
-	  {
-	   /*
-	    * Three-byte value...
-	    */
+  *element = 0;
 
-	    if (((*s)[0] & 0xc0) != 0x80 ||
-        	((*s)[1] & 0xc0) != 0x80)
-              return (EOF);
+  if (ptr >= end)
+    return (NULL);
 
-	    ch = ((((ch & 0x0f) << 6) | ((*s)[0] & 0x3f)) << 6) | ((*s)[1] & 0x3f);
+  if (*ptr == '?')
+  {
+   /*
+    * Processing instruction, which ends with "?>"...
+    */
 
-	    (*s) += 2;
+    for (ptr ++; ptr < end; ptr ++)
+      if (*ptr == '>' && ptr[-1] == '?')
+        return (ptr + 1);
+  }
+  else if ((end - ptr) >= 3 && !memcmp(ptr, "!--", 3))
+  {
+   /*
+    * Comment, which ends with "-->" after at least three characters but not
+    * with "--->"...
+    */
 
-	    if (ch < 0x800)
-	    {
-	      mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	      return (EOF);
-	    }
+    for (ptr += 3, start = ptr; ptr < end; ptr ++)
+      if (*ptr == '>' && (ptr - start) >= 3 && ptr[-1] == '-' && ptr[-2] == '-' && ptr[-3] != '-')
+        return (ptr + 1);
+  }
+  else if ((end - ptr) >= 8 && !memcmp(ptr, "![CDATA[", 8))
+  {
+   /*
+    * CDATA, which ends with "]]>"...
+    */
 
-	   /*
-	    * Ignore (strip) Byte Order Mark (BOM)...
-	    */
+    for (ptr += 8, start = ptr; ptr < end; ptr ++)
+      if (*ptr == '>' && (ptr - start) >= 2 && ptr[-1] == ']' && ptr[-2] == ']')
+        return (ptr + 1);
+  }
+  else if (*ptr == '!' || *ptr == '/')
+  {
+   /*
+    * Declaration or close tag, which ends with the first ">"...
+    */
 
-	    if (ch == 0xfeff)
-	      return (mxml_string_getc(p, encoding));
+    if ((ptr = memchr(ptr, '>', (size_t)(end - ptr))) == NULL)
+      return (NULL);
 
-#if DEBUG > 1
-            printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+    if (*start == '/')
+    {
+      *element = 1;
+      (*depth) --;
+    }
 
-	    return (ch);
-	  }
-	  else if ((ch & 0xf8) == 0xf0)
-	  {
-	   /*
-	    * Four-byte value...
-	    */
+    return (ptr + 1);
+  }
+  else
+  {
+   /*
+    * Element, which ends with the first ">" outside of a quoted attribute name
+    * or value, and is empty if that follows a "/"...
+    */
 
-	    if (((*s)[0] & 0xc0) != 0x80 ||
-        	((*s)[1] & 0xc0) != 0x80 ||
-        	((*s)[2] & 0xc0) != 0x80)
-              return (EOF);
+    for (; ptr < end; ptr ++)
+    {
+      if (quote)
+      {
+        if (*ptr == quote)
+          quote = 0, value = 1;
+      }
+      else if (*ptr == '>')
+      {
+        *element = 1;
 
-	    ch = ((((((ch & 0x07) << 6) | ((*s)[0] & 0x3f)) << 6) |
-        	   ((*s)[1] & 0x3f)) << 6) | ((*s)[2] & 0x3f);
+        if (ptr == start || ptr[-1] != '/')
+          (*depth) ++;
+
+        return (ptr + 1);
+      }
+      else if (value && (*ptr == '\"' || *ptr == '\''))
+        quote = *ptr;
+      else
+        value = mxml_isspace(*ptr) || *ptr == '=';
+    }
+  }
 
-	    (*s) += 3;
+  return (NULL);
+}
 
-	    if (ch < 0x10000)
-	    {
-	      mxml_error("Invalid UTF-8 sequence for character 0x%04x!", ch);
-	      return (EOF);
-	    }
 
-#if DEBUG > 1
-            printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+/*
+ * 'mxml_string_putc()' - Write a character to a string.
+ */
+
+static int				/* O - 0 on success, -1 on failure */
+mxml_string_putc(int  ch,		/* I - Character to write */
+                 void *p)		/* I - Pointer to string pointers */
+{
+  char	**pp;				/* Pointer to string pointers */
+
+
+  pp = (char **)p;
+
+  if (pp[0] < pp[1])
+    pp[0][0] = ch;
+
+  pp[0] ++;
+
+  return (0);
+}
+
+
+/*
+ * 'mxml_validate()' - Find the end of a run of valid UTF-8.
+ *
+ * The run stops in front of the first invalid or incomplete sequence,
+ * control character, or byte order mark, which are all left to
+ * mxml_read_char().  The AVX2 version checks 32 bytes at a time using the
+ * lookup table algorithm from Keiser and Lemire, "Validating UTF-8 In Less
+ * Than One Instruction Per Byte"; SSE2 is used to skip runs of ASCII.
+ */
+
+static const unsigned char *		/* O - End of valid UTF-8 */
+mxml_validate(const unsigned char *ptr,	/* I - Start of input */
+              const unsigned char *end)	/* I - End of input */
+{
+  int		ch,			/* Current byte */
+		len;			/* Length of sequence */
+#ifdef HAVE_X86_SIMD
+  __m128i	bytes;			/* Input bytes */
+  const __m128i	lo = _mm_set1_epi8(0x1f),
+		tab = _mm_set1_epi8('\t'),
+		nl = _mm_set1_epi8('\n'),
+		cr = _mm_set1_epi8('\r');
+					/* Character constants */
+
+
+  if (__builtin_cpu_supports("avx2"))
+    ptr = mxml_validate_avx2(ptr, end);
+#endif /* HAVE_X86_SIMD */
+
+  while (ptr < end)
+  {
+    if ((ch = *ptr) < 0x80)
+    {
+#ifdef HAVE_X86_SIMD
+      if ((end - ptr) >= 16)
+      {
+       /*
+        * Bytes 0x80 and up compare as negative, so only printable ASCII and
+        * whitespace get through...
+        */
+
+	bytes = _mm_loadu_si128((const __m128i *)ptr);
 
-	    return (ch);
-	  }
-	  else
-	    return (EOF);
+	if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi8(bytes, lo), _mm_or_si128(_mm_cmpeq_epi8(bytes, tab), _mm_or_si128(_mm_cmpeq_epi8(bytes, nl), _mm_cmpeq_epi8(bytes, cr))))) == 0xffff)
+	{
+	  ptr += 16;
+	  continue;
+	}
+      }
+#endif /* HAVE_X86_SIMD */
 
-      case ENCODE_UTF16BE :
-	 /*
-          * Read UTF-16 big-endian char...
-	  */
+      if (mxml_bad_char(ch))
+        break;
 
-	  ch = (ch << 8) | ((*s)[0] & 255);
-	  (*s) ++;
+      ptr ++;
+      continue;
+    }
+    else if (ch < 0xc2)
+      break;				/* Continuation or overlong lead byte */
+    else if (ch < 0xe0)
+      len = 2;
+    else if (ch < 0xf0)
+      len = 3;
+    else if (ch < 0xf5)
+      len = 4;
+    else
+      break;				/* Beyond U+10FFFF */
 
-          if (mxml_bad_char(ch))
-	  {
-	    mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	       ch);
-	    return (EOF);
-	  }
-          else if (ch >= 0xd800 && ch <= 0xdbff)
-	  {
-	   /*
-	    * Multi-word UTF-16 char...
-	    */
+    if ((end - ptr) < len || (ptr[1] & 0xc0) != 0x80)
+      break;
+    else if ((ch == 0xe0 && ptr[1] < 0xa0) || (ch == 0xf0 && ptr[1] < 0x90))
+      break;				/* Overlong */
+    else if ((ch == 0xed && ptr[1] >= 0xa0) || (ch == 0xf4 && ptr[1] >= 0x90))
+      break;				/* Surrogate or beyond U+10FFFF */
+    else if (len > 2 && (ptr[2] & 0xc0) != 0x80)
+      break;
+    else if (len > 3 && (ptr[3] & 0xc0) != 0x80)
+      break;
+    else if (ch == 0xef && ptr[1] == 0xbb && ptr[2] == 0xbf)
+      break;				/* Byte order mark */
 
-            int lch;			/* Lower word */
+    ptr += len;
+  }
 
+  return (ptr);
+}
 
-            if (!(*s)[0])
-	      return (EOF);
 
-            lch = (((*s)[0] & 255) << 8) | ((*s)[1] & 255);
-	    (*s) += 2;
+#ifdef HAVE_X86_SIMD
+/*
+ * 'mxml_validate_avx2()' - Find the end of a run of valid UTF-8, 32 bytes at a time.
+ *
+ * Each byte is classified using its high nibble and the nibbles of the byte
+ * before it; any error bit that survives the three table lookups marks an
+ * invalid sequence.  The third and fourth bytes of a sequence are checked
+ * against the lead byte two and three positions back.
+ */
 
-            if (lch < 0xdc00 || lch >= 0xdfff)
-	      return (EOF);
+static const unsigned char *		/* O - Start of unchecked input */
+mxml_validate_avx2(
+    const unsigned char *ptr,		/* I - Start of input */
+    const unsigned char *end)		/* I - End of input */
+{
+  const unsigned char *start = ptr;	/* Start of input */
+  int		len;			/* Bytes to back up */
+  __m256i	bytes,			/* Input bytes */
+		last,			/* Previous input bytes */
+		prev1,			/* Input shifted by one byte */
+		prev2,			/* Input shifted by two bytes */
+		prev3,			/* Input shifted by three bytes */
+		error;			/* Error bits */
+  const __m256i	nibble = _mm256_set1_epi8(0x0f),
+		byte1hi = _mm256_setr_epi8(
+		  0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, (char)0x80, (char)0x80, (char)0x80, (char)0x80, 0x21, 0x01, 0x15, 0x49,
+		  0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, (char)0x80, (char)0x80, (char)0x80, (char)0x80, 0x21, 0x01, 0x15, 0x49),
+		byte1lo = _mm256_setr_epi8(
+		  (char)0xe7, (char)0xa3, (char)0x83, (char)0x83, (char)0x8b, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xdb, (char)0xcb, (char)0xcb,
+		  (char)0xe7, (char)0xa3, (char)0x83, (char)0x83, (char)0x8b, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xcb, (char)0xdb, (char)0xcb, (char)0xcb),
+		byte2hi = _mm256_setr_epi8(
+		  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, (char)0xe6, (char)0xae, (char)0xba, (char)0xba, 0x01, 0x01, 0x01, 0x01,
+		  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, (char)0xe6, (char)0xae, (char)0xba, (char)0xba, 0x01, 0x01, 0x01, 0x01),
+		cont = _mm256_set1_epi8((char)0x80),
+		third = _mm256_set1_epi8(0xe0 - 0x80),
+		fourth = _mm256_set1_epi8(0xf0 - 0x80),
+		lo = _mm256_set1_epi8(0x1f),
+		tab = _mm256_set1_epi8('\t'),
+		nl = _mm256_set1_epi8('\n'),
+		cr = _mm256_set1_epi8('\r'),
+		bom1 = _mm256_set1_epi8((char)0xef),
+		bom2 = _mm256_set1_epi8((char)0xbb),
+		bom3 = _mm256_set1_epi8((char)0xbf);
+					/* Constants */
+
+
+  for (last = _mm256_setzero_si256(); (end - ptr) >= 32; ptr += 32, last = bytes)
+  {
+    bytes = _mm256_loadu_si256((const __m256i *)ptr);
+    prev1 = _mm256_alignr_epi8(bytes, _mm256_permute2x128_si256(last, bytes, 0x21), 15);
+    prev2 = _mm256_alignr_epi8(bytes, _mm256_permute2x128_si256(last, bytes, 0x21), 14);
+    prev3 = _mm256_alignr_epi8(bytes, _mm256_permute2x128_si256(last, bytes, 0x21), 13);
 
-            ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	  }
+   /*
+    * Bad sequences...
+    */
 
-#if DEBUG > 1
-          printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
+    error = _mm256_and_si256(_mm256_and_si256(_mm256_shuffle_epi8(byte1hi, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                              _mm256_shuffle_epi8(byte1lo, _mm256_and_si256(prev1, nibble))),
+                             _mm256_shuffle_epi8(byte2hi, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble)));
+    error = _mm256_xor_si256(error, _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(prev2, third), _mm256_subs_epu8(prev3, fourth)), cont));
 
-	  return (ch);
+   /*
+    * Control characters and byte order marks...
+    */
 
-      case ENCODE_UTF16LE :
-	 /*
-          * Read UTF-16 little-endian char...
-	  */
+    error = _mm256_or_si256(error, _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, tab), _mm256_or_si256(_mm256_cmpeq_epi8(bytes, nl), _mm256_cmpeq_epi8(bytes, cr))),
+                                                       _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, lo), bytes)));
+    error = _mm256_or_si256(error, _mm256_and_si256(_mm256_cmpeq_epi8(prev2, bom1), _mm256_and_si256(_mm256_cmpeq_epi8(prev1, bom2), _mm256_cmpeq_epi8(bytes, bom3))));
 
-	  ch = ch | (((*s)[0] & 255) << 8);
+    if (!_mm256_testz_si256(error, error))
+      break;
+  }
 
-	  if (!ch)
-	  {
-	    (*s) --;
-	    return (EOF);
-	  }
+ /*
+  * Back up to the start of any sequence that crosses into the unchecked input
+  * so mxml_validate() can check it byte by byte...
+  */
 
-	  (*s) ++;
+  for (len = 1; len <= 3 && (ptr - len) >= start; len ++)
+  {
+    if (ptr[-len] >= 0xc0)
+    {
+      ptr -= len;
+      break;
+    }
+    else if (ptr[-len] < 0x80)
+      break;
+  }
 
-          if (mxml_bad_char(ch))
-	  {
-	    mxml_error("Bad control character 0x%02x not allowed by XML standard!",
-        	       ch);
-	    return (EOF);
-	  }
-          else if (ch >= 0xd800 && ch <= 0xdbff)
-	  {
-	   /*
-	    * Multi-word UTF-16 char...
-	    */
+  return (ptr);
+}
+#endif /* HAVE_X86_SIMD */
 
-            int lch;			/* Lower word */
 
+/*
+ * 'mxml_views_free()' - Free the SAX view buffers.
+ */
 
-            if (!(*s)[1])
-	      return (EOF);
+static void
+mxml_views_free(_mxml_views_t *views)	/* I - SAX view buffers */
+{
+  mxml_node_t	*node,			/* Current element node */
+		*next;			/* Next element node */
 
-            lch = (((*s)[1] & 255) << 8) | ((*s)[0] & 255);
-	    (*s) += 2;
 
-            if (lch < 0xdc00 || lch >= 0xdfff)
-	      return (EOF);
+  for (node = views->elements; node; node = next)
+  {
+    next = node->child;
+    _mxml_free(node);
+  }
 
-            ch = (((ch & 0x3ff) << 10) | (lch & 0x3ff)) + 0x10000;
-	  }
+  _mxml_free(views->strings);
+  _mxml_free(views->attrs);
+  _mxml_free(views->pairs);
+}
 
-#if DEBUG > 1
-          printf("mxml_string_getc: %c (0x%04x)\n", ch < ' ' ? '.' : ch, ch);
-#endif /* DEBUG > 1 */
 
-	  return (ch);
-    }
-  }
+/*
+ * 'mxml_views_init()' - Initialize the SAX view buffers.
+ */
 
-  return (EOF);
+static void
+mxml_views_init(
+    _mxml_views_t      *views,		/* I - SAX view buffers */
+    mxml_sax_view_cb_t cb,		/* I - SAX view callback */
+    void               *cb_data)	/* I - SAX view callback data */
+{
+  memset(views, 0, sizeof(_mxml_views_t));
+
+  views->cb        = cb;
+  views->data      = cb_data;
+  views->node.type = MXML_ELEMENT;
 }
 
 
 /*
- * 'mxml_string_putc()' - Write a character to a string.
+ * 'mxml_views_reserve()' - Make room in the SAX view string buffer.
+ *
+ * When the buffer moves, the names of the element nodes and the attributes
+ * of the current element are updated to point into the new buffer.
  */
 
-static int				/* O - 0 on success, -1 on failure */
-mxml_string_putc(int  ch,		/* I - Character to write */
-                 void *p)		/* I - Pointer to string pointers */
+static int				/* O - 0 on success, -1 on error */
+mxml_views_reserve(
+    _mxml_views_t *views,		/* I - SAX view buffers */
+    mxml_node_t   *node,		/* I - Element with attributes or NULL */
+    size_t        bytes)		/* I - Bytes needed */
 {
-  char	**pp;				/* Pointer to string pointers */
+  size_t	strsize;		/* New size of string buffer */
+  char		*strings;		/* New string buffer */
+  mxml_node_t	*element;		/* Current element node */
+  int		i;			/* Looping var */
 
 
-  pp = (char **)p;
+  if ((views->strused + bytes) <= views->strsize)
+    return (0);
 
-  if (pp[0] < pp[1])
-    pp[0][0] = ch;
+  strsize = views->strsize ? 2 * views->strsize : 1024;
 
-  pp[0] ++;
+  while (strsize < (views->strused + bytes))
+    strsize *= 2;
+
+  if ((strings = _mxml_malloc(strsize)) == NULL)
+  {
+    mxml_error("Unable to allocate memory for SAX view strings.");
+    return (-1);
+  }
+
+  if (views->strings)
+  {
+    memcpy(strings, views->strings, views->strused);
+
+    for (element = views->elements; element; element = element->child)
+      if (element->value.element.name)
+        element->value.element.name = strings + (element->value.element.name - views->strings);
+
+    if (node)
+    {
+      for (i = 0; i < node->num_attrs; i ++)
+      {
+        node->value.element.attrs[i].name  = strings + (node->value.element.attrs[i].name - views->strings);
+        node->value.element.attrs[i].value = strings + (node->value.element.attrs[i].value - views->strings);
+      }
+    }
+
+    _mxml_free(views->strings);
+  }
+
+  views->strings = strings;
+  views->strsize = strsize;
 
   return (0);
 }
@@ -2813,7 +7616,7 @@ mxml_write_node(mxml_node_t     *node,	/* I - Node to write */
 
 	  col += strlen(current->value.element.name) + 1;
 
-	  for (i = current->value.element.num_attrs, attr = current->value.element.attrs;
+	  for (i = current->num_attrs, attr = current->value.element.attrs;
 	       i > 0;
 	       i --, attr ++)
 	  {
@@ -2913,7 +7716,7 @@ mxml_write_node(mxml_node_t     *node,	/* I - Node to write */
 	      col ++;
 	  }
 
-	  snprintf(s, sizeof(s), "%d", current->value.integer);
+	  snprintf(s, sizeof(s), "%lld", current->value.integer);
 	  if (mxml_write_string(s, p, putc_cb) < 0)
 	    return (-1);
 
@@ -2943,7 +7746,7 @@ mxml_write_node(mxml_node_t     *node,	/* I - Node to write */
 	      col ++;
 	  }
 
-	  snprintf(s, sizeof(s), "%f", current->value.real);
+	  _mxml_dtoa(current->value.real, s, sizeof(s));
 	  if (mxml_write_string(s, p, putc_cb) < 0)
 	    return (-1);
 
@@ -3136,3 +7939,325 @@ mxml_write_ws(mxml_node_t     *node,	/* I - Current node */
 
   return (col);
 }
+
+
+#ifdef HAVE_LIBZ
+/*
+ * 'mxml_zalloc()' - Allocate memory for zlib.
+ */
+
+static voidpf				/* O - Memory or Z_NULL on error */
+mxml_zalloc(voidpf opaque,		/* I - Unused */
+            uInt   items,		/* I - Number of items */
+            uInt   size)		/* I - Size of each item */
+{
+  (void)opaque;
+
+  return (_mxml_calloc(items, size));
+}
+
+
+/*
+ * 'mxml_zfree()' - Free memory for zlib.
+ */
+
+static void
+mxml_zfree(voidpf opaque,		/* I - Unused */
+           voidpf ptr)			/* I - Memory */
+{
+  (void)opaque;
+
+  _mxml_free(ptr);
+}
+#endif /* HAVE_LIBZ */
+
+
+/*
+ * 'mxml_zread()' - Read a buffer of decompressed data.
+ */
+
+static int				/* O - Bytes read, 0 on EOF, -1 on error */
+mxml_zread(void   *p,			/* I - Decompression state */
+           void   *buffer,		/* I - Buffer */
+           size_t bytes)		/* I - Size of buffer */
+{
+  _mxml_zstream_t	*z = (_mxml_zstream_t *)p;
+					/* Decompression state */
+  int			count;		/* Bytes read */
+
+
+  for (;;)
+  {
+   /*
+    * Refill the compressed data buffer as needed...
+    */
+
+    if (z->current >= z->end && !z->eof)
+    {
+      if ((count = (*z->read_cb)(z->read_data, z->buffer, sizeof(z->buffer))) < 0)
+        return (-1);
+      else if (count == 0)
+        z->eof = 1;
+
+      z->current = z->buffer;
+      z->end     = z->buffer + count;
+    }
+
+#ifdef HAVE_LIBZ
+    if (z->format == MXML_COMPRESS_GZIP)
+    {
+      int	status;			/* Decompression status */
+
+      if (z->member_end)
+      {
+       /*
+        * Another gzip member may follow the last one...
+        */
+
+        if (z->current >= z->end)
+          return (0);
+
+        inflateReset(&z->zs);
+        z->member_end = 0;
+      }
+
+      z->zs.next_in   = z->current;
+      z->zs.avail_in  = (uInt)(z->end - z->current);
+      z->zs.next_out  = (Bytef *)buffer;
+      z->zs.avail_out = (uInt)bytes;
+
+      status     = inflate(&z->zs, Z_NO_FLUSH);
+      count      = (int)(bytes - z->zs.avail_out);
+      z->current = z->zs.next_in;
+
+      if (status == Z_STREAM_END)
+        z->member_end = 1;
+      else if (status != Z_OK && status != Z_BUF_ERROR)
+      {
+        mxml_error("Unable to decompress gzip data: %s", z->zs.msg ? z->zs.msg : "Unknown error.");
+        return (-1);
+      }
+
+      if (count > 0)
+        return (count);
+
+      if (z->eof && z->current >= z->end && !z->member_end)
+      {
+        mxml_error("Unable to decompress gzip data: Unexpected end of data.");
+        return (-1);
+      }
+
+      continue;
+    }
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_LIBZSTD
+    if (z->format == MXML_COMPRESS_ZSTD)
+    {
+      ZSTD_inBuffer	zin;		/* Compressed input */
+      ZSTD_outBuffer	zout;		/* Decompressed output */
+
+      if (z->eof && z->current >= z->end && z->zret == 0)
+        return (0);			/* Last frame is complete */
+
+      zin.src   = z->current;
+      zin.size  = (size_t)(z->end - z->current);
+      zin.pos   = 0;
+      zout.dst  = buffer;
+      zout.size = bytes;
+      zout.pos  = 0;
+
+      z->zret = ZSTD_decompressStream(z->dctx, &zout, &zin);
+
+      if (ZSTD_isError(z->zret))
+      {
+        mxml_error("Unable to decompress Zstandard data: %s", ZSTD_getErrorName(z->zret));
+        return (-1);
+      }
+
+      z->current += zin.pos;
+
+      if (zout.pos > 0)
+        return ((int)zout.pos);
+
+      if (z->eof && z->current >= z->end)
+      {
+        if (z->zret == 0)
+          return (0);
+
+        mxml_error("Unable to decompress Zstandard data: Unexpected end of data.");
+        return (-1);
+      }
+
+      continue;
+    }
+#endif /* HAVE_LIBZSTD */
+
+    return (-1);
+  }
+}
+
+
+/*
+ * 'mxml_zstream_delete()' - Free a compressed stream.
+ */
+
+static void
+mxml_zstream_delete(
+    _mxml_zstream_t *z)			/* I - Compressed stream */
+{
+#ifdef HAVE_LIBZ
+  if (z->format == MXML_COMPRESS_GZIP)
+  {
+    if (z->compress)
+      deflateEnd(&z->zs);
+    else
+      inflateEnd(&z->zs);
+  }
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_LIBZSTD
+  ZSTD_freeCCtx(z->cctx);
+  ZSTD_freeDCtx(z->dctx);
+#endif /* HAVE_LIBZSTD */
+
+  _mxml_free(z);
+}
+
+
+/*
+ * 'mxml_zstream_new()' - Create a compressed stream.
+ */
+
+static _mxml_zstream_t *		/* O - Compressed stream or NULL on error */
+mxml_zstream_new(
+    mxml_compress_t format,		/* I - Compression format */
+    int             compress)		/* I - 1 to compress, 0 to decompress */
+{
+  _mxml_zstream_t	*z;		/* Compressed stream */
+
+
+  if ((z = _mxml_calloc(1, sizeof(_mxml_zstream_t))) == NULL)
+  {
+    mxml_error("Unable to allocate memory for compressed stream.");
+    return (NULL);
+  }
+
+  z->format   = format;
+  z->compress = compress;
+
+  switch (format)
+  {
+    case MXML_COMPRESS_GZIP :
+#ifdef HAVE_LIBZ
+        z->zs.zalloc = mxml_zalloc;
+        z->zs.zfree  = mxml_zfree;
+
+        if ((compress ? deflateInit2(&z->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) : inflateInit2(&z->zs, 47)) == Z_OK)
+          return (z);
+
+	mxml_error("Unable to initialize gzip stream.");
+#else
+	mxml_error("gzip compression is not supported.");
+#endif /* HAVE_LIBZ */
+        break;
+
+    case MXML_COMPRESS_ZSTD :
+#ifdef HAVE_LIBZSTD
+        if (compress ? (z->cctx = ZSTD_createCCtx()) != NULL : (z->dctx = ZSTD_createDCtx()) != NULL)
+          return (z);
+
+	mxml_error("Unable to initialize Zstandard stream.");
+#else
+	mxml_error("Zstandard compression is not supported.");
+#endif /* HAVE_LIBZSTD */
+        break;
+
+    default :
+        break;
+  }
+
+  _mxml_free(z);
+
+  return (NULL);
+}
+
+
+/*
+ * 'mxml_zwrite()' - Compress and write data.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+mxml_zwrite(
+    _mxml_fdbuf_t       *buf,		/* I - File descriptor buffer */
+    const unsigned char *data,		/* I - Data to compress */
+    size_t              len,		/* I - Number of bytes */
+    int                 finish)		/* I - 1 to end the compressed stream */
+{
+  _mxml_zstream_t	*z = buf->z;	/* Compressed stream */
+
+
+#ifdef HAVE_LIBZ
+  if (z->format == MXML_COMPRESS_GZIP)
+  {
+    int	status;				/* Compression status */
+
+    z->zs.next_in  = (Bytef *)data;
+    z->zs.avail_in = (uInt)len;
+
+    do
+    {
+      z->zs.next_out  = z->buffer;
+      z->zs.avail_out = sizeof(z->buffer);
+
+      if ((status = deflate(&z->zs, finish ? Z_FINISH : Z_NO_FLUSH)) == Z_STREAM_ERROR)
+        return (-1);
+
+      if (mxml_fd_output(buf, z->buffer, sizeof(z->buffer) - z->zs.avail_out))
+        return (-1);
+    }
+    while (z->zs.avail_out == 0 || (finish && status != Z_STREAM_END));
+
+    return (0);
+  }
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_LIBZSTD
+  if (z->format == MXML_COMPRESS_ZSTD)
+  {
+    ZSTD_inBuffer	zin;		/* Uncompressed input */
+    ZSTD_outBuffer	zout;		/* Compressed output */
+    size_t		remaining;	/* Bytes left to flush */
+
+    zin.src  = data;
+    zin.size = len;
+    zin.pos  = 0;
+
+    do
+    {
+      zout.dst  = z->buffer;
+      zout.size = sizeof(z->buffer);
+      zout.pos  = 0;
+
+      if (ZSTD_isError(remaining = ZSTD_compressStream2(z->cctx, &zout, &zin, finish ? ZSTD_e_end : ZSTD_e_continue)))
+      {
+        mxml_error("Unable to compress Zstandard data: %s", ZSTD_getErrorName(remaining));
+        return (-1);
+      }
+
+      if (mxml_fd_output(buf, z->buffer, zout.pos))
+        return (-1);
+    }
+    while (finish ? remaining > 0 : zin.pos < zin.size);
+
+    return (0);
+  }
+#endif /* HAVE_LIBZSTD */
+
+  (void)z;
+  (void)data;
+  (void)len;
+  (void)finish;
+
+  return (-1);
+}
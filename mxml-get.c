@@ -142,6 +142,22 @@ mxmlGetFirstChild(mxml_node_t *node)	/* I - Node to get */
 
 int					/* O - Integer value or 0 */
 mxmlGetInteger(mxml_node_t *node)	/* I - Node to get */
+{
+  return ((int)mxmlGetInteger64(node));
+}
+
+
+/*
+ * 'mxmlGetInteger64()' - Get the 64-bit integer value from the specified node
+ *                        or its first child.
+ *
+ * 0 is returned if the node (or its first child) is not an integer value node.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+long long				/* O - Integer value or 0 */
+mxmlGetInteger64(mxml_node_t *node)	/* I - Node to get */
 {
  /*
   * Range check input...
@@ -444,5 +460,5 @@ mxmlGetUserData(mxml_node_t *node)	/* I - Node to get */
   * Return the user data pointer...
   */
 
-  return (node->user_data);
+  return (_mxml_get_user_data(node));
 }
@@ -47,12 +47,12 @@ mxmlIndexDelete(mxml_index_t *ind)	/* I - Index to delete */
   */
 
   if (ind->attr)
-    free(ind->attr);
+    _mxml_free(ind->attr);
 
   if (ind->alloc_nodes)
-    free(ind->nodes);
+    _mxml_free(ind->nodes);
 
-  free(ind);
+  _mxml_free(ind);
 }
 
 
@@ -328,7 +328,7 @@ mxmlIndexNew(mxml_node_t *node,		/* I - XML node tree */
   * Create a new index...
   */
 
-  if ((ind = calloc(1, sizeof(mxml_index_t))) == NULL)
+  if ((ind = _mxml_calloc(1, sizeof(mxml_index_t))) == NULL)
   {
     mxml_error("Unable to allocate %d bytes for index - %s",
                sizeof(mxml_index_t), strerror(errno));
@@ -336,7 +336,7 @@ mxmlIndexNew(mxml_node_t *node,		/* I - XML node tree */
   }
 
   if (attr)
-    ind->attr = strdup(attr);
+    ind->attr = _mxml_strdup(attr);
 
   if (!element && !attr)
     current = node;
@@ -348,9 +348,9 @@ mxmlIndexNew(mxml_node_t *node,		/* I - XML node tree */
     if (ind->num_nodes >= ind->alloc_nodes)
     {
       if (!ind->alloc_nodes)
-        temp = malloc(64 * sizeof(mxml_node_t *));
+        temp = _mxml_malloc(64 * sizeof(mxml_node_t *));
       else
-        temp = realloc(ind->nodes, (ind->alloc_nodes + 64) * sizeof(mxml_node_t *));
+        temp = _mxml_realloc(ind->nodes, (ind->alloc_nodes + 64) * sizeof(mxml_node_t *));
 
       if (!temp)
       {
@@ -504,10 +504,11 @@ index_compare(mxml_index_t *ind,	/* I - Index */
 
 
  /*
-  * Check the element name...
+  * Check the element name, which is often the same (interned) string...
   */
 
-  if ((diff = strcmp(first->value.element.name,
+  if (first->value.element.name != second->value.element.name &&
+      (diff = strcmp(first->value.element.name,
                      second->value.element.name)) != 0)
     return (diff);
 
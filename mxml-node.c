@@ -15,14 +15,63 @@
 
 #include "config.h"
 #include "mxml-private.h"
+#ifdef MXML_COMPACT_NODES
+#  ifdef HAVE_PTHREAD_H
+#    include <pthread.h>
+#  elif defined(_WIN32)
+#    include <windows.h>
+#  endif /* HAVE_PTHREAD_H */
+
+
+/*
+ * Side table for node reference counts other than 1 and user data pointers,
+ * so that compact nodes do not need room for them.  Nodes with an entry have
+ * the _MXML_NODE_EXTRA flag set.  The table is shared by all threads, so it
+ * does not use the allocation functions set with mxmlSetAllocator...
+ */
+
+typedef struct _mxml_extra_s		/**** Node use count and user data ****/
+{
+  mxml_node_t		*node;		/* Node or NULL if unused */
+  int			ref_count;	/* Use count */
+  void			*user_data;	/* User data */
+} _mxml_extra_t;
+
+static _mxml_extra_t	*mxml_extras = NULL;
+					/* Hash table of entries */
+static size_t		mxml_num_extras = 0,
+					/* Number of entries */
+			mxml_alloc_extras = 0;
+					/* Size of hash table */
+#  ifdef HAVE_PTHREAD_H
+static pthread_mutex_t	mxml_extras_mutex = PTHREAD_MUTEX_INITIALIZER;
+					/* Mutex for side table */
+#  elif defined(_WIN32)
+static SRWLOCK		mxml_extras_lock = SRWLOCK_INIT;
+					/* Lock for side table */
+#  endif /* HAVE_PTHREAD_H */
+#endif /* MXML_COMPACT_NODES */
 
 
 /*
  * Local functions...
  */
 
+static _mxml_name_t	*mxml_arena_find(_mxml_arena_t *arena, const char *s, unsigned hash);
+static void		mxml_arena_release(_mxml_arena_t *arena);
+#ifdef MXML_COMPACT_NODES
+static _mxml_extra_t	*mxml_extra_find(mxml_node_t *node, int create);
+static inline size_t	mxml_extra_hash(mxml_node_t *node)
+			{
+			  return (((size_t)node >> 3) * 2654435761U);
+			}
+static void		mxml_extra_lock(void);
+static void		mxml_extra_remove(_mxml_extra_t *extra);
+static void		mxml_extra_unlock(void);
+#endif /* MXML_COMPACT_NODES */
 static void		mxml_free(mxml_node_t *node);
-static mxml_node_t	*mxml_new(mxml_node_t *parent, mxml_type_t type);
+static mxml_node_t	*mxml_new(mxml_node_t *parent, mxml_type_t type, size_t extra);
+static int		mxml_ref_add(mxml_node_t *node, int delta);
 
 
 /*
@@ -252,6 +301,12 @@ mxmlDelete(mxml_node_t *node)		/* I - Node to delete */
 int					/* O - Reference count */
 mxmlGetRefCount(mxml_node_t *node)	/* I - Node */
 {
+#ifdef MXML_COMPACT_NODES
+  _mxml_extra_t	*extra;			/* Side table entry */
+  int		ref_count = 1;		/* Reference count */
+#endif /* MXML_COMPACT_NODES */
+
+
  /*
   * Range check input...
   */
@@ -263,7 +318,22 @@ mxmlGetRefCount(mxml_node_t *node)	/* I - Node */
   * Return the reference count...
   */
 
+#ifdef MXML_COMPACT_NODES
+  if (node->flags & _MXML_NODE_EXTRA)
+  {
+    mxml_extra_lock();
+
+    if ((extra = mxml_extra_find(node, 0)) != NULL)
+      ref_count = extra->ref_count;
+
+    mxml_extra_unlock();
+  }
+
+  return (ref_count);
+
+#else
   return (node->ref_count);
+#endif /* MXML_COMPACT_NODES */
 }
 
 
@@ -302,8 +372,8 @@ mxmlNewCDATA(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
   * Create the node and set the name value...
   */
 
-  if ((node = mxml_new(parent, MXML_ELEMENT)) != NULL)
-    node->value.element.name = _mxml_strdupf("![CDATA[%s", data);
+  if ((node = _mxml_new(parent, MXML_ELEMENT)) != NULL)
+    _mxml_replace_value(node, &node->value.element.name, _mxml_strdupf("![CDATA[%s", data));
 
   return (node);
 }
@@ -338,7 +408,7 @@ mxmlNewCustom(
   * Create the node and set the value...
   */
 
-  if ((node = mxml_new(parent, MXML_CUSTOM)) != NULL)
+  if ((node = _mxml_new(parent, MXML_CUSTOM)) != NULL)
   {
     node->value.custom.data    = data;
     node->value.custom.destroy = destroy;
@@ -360,9 +430,6 @@ mxml_node_t *				/* O - New node */
 mxmlNewElement(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
                const char  *name)	/* I - Name of element */
 {
-  mxml_node_t	*node;			/* New node */
-
-
 #ifdef DEBUG
   fprintf(stderr, "mxmlNewElement(parent=%p, name=\"%s\")\n", parent,
           name ? name : "(null)");
@@ -379,10 +446,7 @@ mxmlNewElement(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@
   * Create the node and set the element name...
   */
 
-  if ((node = mxml_new(parent, MXML_ELEMENT)) != NULL)
-    node->value.element.name = strdup(name);
-
-  return (node);
+  return (_mxml_new_value(parent, MXML_ELEMENT, name));
 }
 
 
@@ -409,7 +473,39 @@ mxmlNewInteger(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@
   * Create the node and set the element name...
   */
 
-  if ((node = mxml_new(parent, MXML_INTEGER)) != NULL)
+  if ((node = _mxml_new(parent, MXML_INTEGER)) != NULL)
+    node->value.integer = integer;
+
+  return (node);
+}
+
+
+/*
+ * 'mxmlNewInteger64()' - Create a new 64-bit integer node.
+ *
+ * The new integer node is added to the end of the specified parent's child
+ * list. The constant @code MXML_NO_PARENT@ can be used to specify that the new
+ * integer node has no parent.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_node_t *				/* O - New node */
+mxmlNewInteger64(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
+                 long long   integer)	/* I - Integer value */
+{
+  mxml_node_t	*node;			/* New node */
+
+
+#ifdef DEBUG
+  fprintf(stderr, "mxmlNewInteger64(parent=%p, integer=%lld)\n", parent, integer);
+#endif /* DEBUG */
+
+ /*
+  * Create the node and set the integer value...
+  */
+
+  if ((node = _mxml_new(parent, MXML_INTEGER)) != NULL)
     node->value.integer = integer;
 
   return (node);
@@ -429,9 +525,6 @@ mxml_node_t *				/* O - New node */
 mxmlNewOpaque(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
               const char  *opaque)	/* I - Opaque string */
 {
-  mxml_node_t	*node;			/* New node */
-
-
 #ifdef DEBUG
   fprintf(stderr, "mxmlNewOpaque(parent=%p, opaque=\"%s\")\n", parent,
           opaque ? opaque : "(null)");
@@ -448,10 +541,7 @@ mxmlNewOpaque(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ *
   * Create the node and set the element name...
   */
 
-  if ((node = mxml_new(parent, MXML_OPAQUE)) != NULL)
-    node->value.opaque = strdup(opaque);
-
-  return (node);
+  return (_mxml_new_value(parent, MXML_OPAQUE, opaque));
 }
 
 
@@ -488,11 +578,11 @@ mxmlNewOpaquef(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@
   * Create the node and set the text value...
   */
 
-  if ((node = mxml_new(parent, MXML_OPAQUE)) != NULL)
+  if ((node = _mxml_new(parent, MXML_OPAQUE)) != NULL)
   {
     va_start(ap, format);
 
-    node->value.opaque = _mxml_vstrdupf(format, ap);
+    _mxml_replace_value(node, &node->value.opaque, _mxml_vstrdupf(format, ap));
 
     va_end(ap);
   }
@@ -524,7 +614,7 @@ mxmlNewReal(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
   * Create the node and set the element name...
   */
 
-  if ((node = mxml_new(parent, MXML_REAL)) != NULL)
+  if ((node = _mxml_new(parent, MXML_REAL)) != NULL)
     node->value.real = real;
 
   return (node);
@@ -565,11 +655,8 @@ mxmlNewText(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
   * Create the node and set the text value...
   */
 
-  if ((node = mxml_new(parent, MXML_TEXT)) != NULL)
-  {
+  if ((node = _mxml_new_value(parent, MXML_TEXT, string)) != NULL)
     node->value.text.whitespace = whitespace;
-    node->value.text.string     = strdup(string);
-  }
 
   return (node);
 }
@@ -611,12 +698,12 @@ mxmlNewTextf(mxml_node_t *parent,	/* I - Parent node or @code MXML_NO_PARENT@ */
   * Create the node and set the text value...
   */
 
-  if ((node = mxml_new(parent, MXML_TEXT)) != NULL)
+  if ((node = _mxml_new(parent, MXML_TEXT)) != NULL)
   {
     va_start(ap, format);
 
     node->value.text.whitespace = whitespace;
-    node->value.text.string     = _mxml_vstrdupf(format, ap);
+    _mxml_replace_value(node, &node->value.text.string, _mxml_vstrdupf(format, ap));
 
     va_end(ap);
   }
@@ -714,6 +801,40 @@ mxmlNewXML(const char *version)		/* I - Version number to use */
 }
 
 
+/*
+ * 'mxmlNewXMLArena()' - Create a new XML document tree that uses an arena.
+ *
+ * This function works like @link mxmlNewXML@, except that the ?xml node and
+ * all nodes later created under it, including loaded nodes, are allocated
+ * together with their names, attributes, and strings from large blocks of
+ * memory owned by the document.  The blocks are freed at once when the last
+ * node in the arena is deleted, normally by deleting the ?xml node.
+ *
+ * Nodes that are removed from the tree keep the arena's memory in use until
+ * they are deleted as well.  Values that are changed after a node is created
+ * are also copied into the arena, and the memory used by the old value is not
+ * reused until the arena is freed.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+mxml_node_t *				/* O - New ?xml node */
+mxmlNewXMLArena(const char *version)	/* I - Version number to use */
+{
+  char		element[1024];		/* Element text */
+  mxml_node_t	*node;			/* New node */
+
+
+  snprintf(element, sizeof(element), "?xml version=\"%s\" encoding=\"utf-8\"?",
+           version ? version : "1.0");
+
+  if ((node = _mxml_new_arena(MXML_ELEMENT)) != NULL)
+    node->value.element.name = _mxml_strdup_value(node, element);
+
+  return (node);
+}
+
+
 /*
  * 'mxmlRelease()' - Release a node.
  *
@@ -726,15 +847,18 @@ mxmlNewXML(const char *version)		/* I - Version number to use */
 int					/* O - New reference count */
 mxmlRelease(mxml_node_t *node)		/* I - Node */
 {
+  int	ref_count;			/* New reference count */
+
+
   if (node)
   {
-    if ((-- node->ref_count) <= 0)
+    if ((ref_count = mxml_ref_add(node, -1)) == 0)
     {
       mxmlDelete(node);
       return (0);
     }
     else
-      return (node->ref_count);
+      return (ref_count);
   }
   else
     return (-1);
@@ -751,12 +875,356 @@ int					/* O - New reference count */
 mxmlRetain(mxml_node_t *node)		/* I - Node */
 {
   if (node)
-    return (++ node->ref_count);
+    return (mxml_ref_add(node, 1));
   else
     return (-1);
 }
 
 
+/*
+ * '_mxml_arena_alloc()' - Allocate memory from an arena.
+ *
+ * Requests larger than a quarter of a slab get a slab of their own, so that
+ * the rest of the current slab is not wasted.
+ */
+
+void *					/* O - Memory or @code NULL@ on error */
+_mxml_arena_alloc(_mxml_arena_t *arena,	/* I - Arena */
+                  size_t        size,	/* I - Number of bytes */
+                  size_t        align)	/* I - Alignment, 1 for strings */
+{
+  char		*ptr;			/* Allocated memory */
+  size_t	pad;			/* Bytes needed for alignment */
+  _mxml_slab_t	*slab;			/* New slab */
+
+
+  pad = (align - (size_t)arena->current % align) % align;
+
+  if (size + pad <= (size_t)(arena->end - arena->current))
+  {
+    ptr            = arena->current + pad;
+    arena->current = ptr + size;
+
+    return (ptr);
+  }
+
+  if (size > arena->slab_size / 4)
+  {
+   /*
+    * Insert a dedicated slab after the current one...
+    */
+
+    if ((slab = _mxml_malloc(sizeof(_mxml_slab_t) + size)) == NULL)
+      return (NULL);
+
+    slab->next         = arena->slabs->next;
+    arena->slabs->next = slab;
+
+    return (slab + 1);
+  }
+
+  if ((slab = _mxml_malloc(arena->slab_size)) == NULL)
+    return (NULL);
+
+  slab->next     = arena->slabs;
+  arena->slabs   = slab;
+  arena->current = (char *)(slab + 1) + size;
+  arena->end     = (char *)slab + arena->slab_size;
+
+  if (arena->slab_size < _MXML_ARENA_MAX)
+    arena->slab_size *= 2;
+
+  return (slab + 1);
+}
+
+
+/*
+ * '_mxml_arena_intern()' - Intern a name in an arena.
+ *
+ * Every copy of a name in the arena shares the same string, so interned names
+ * can be compared by pointer.
+ */
+
+char *					/* O - Interned name or @code NULL@ on error */
+_mxml_arena_intern(_mxml_arena_t *arena,/* I - Arena */
+                   const char    *s)	/* I - Name */
+{
+  unsigned	hash = _mxml_strhash(s);/* Hash of name */
+  _mxml_name_t	*name,			/* Table entry */
+		*names;			/* New table */
+  size_t	i,			/* Looping var */
+		j,			/* Index in new table */
+		alloc_names;		/* New size of table */
+
+
+  if ((name = mxml_arena_find(arena, s, hash)) != NULL && name->name)
+    return (name->name);
+
+  if (2 * (arena->num_names + 1) > arena->alloc_names)
+  {
+   /*
+    * Double the size of the table, keeping it at most half full...
+    */
+
+    alloc_names = arena->alloc_names ? 2 * arena->alloc_names : 64;
+
+    if ((names = _mxml_calloc(alloc_names, sizeof(_mxml_name_t))) == NULL)
+      return (NULL);
+
+    for (i = 0; i < arena->alloc_names; i ++)
+    {
+      if (!arena->names[i].name)
+        continue;
+
+      for (j = arena->names[i].hash & (alloc_names - 1); names[j].name; j = (j + 1) & (alloc_names - 1));
+
+      names[j] = arena->names[i];
+    }
+
+    _mxml_free(arena->names);
+
+    arena->names       = names;
+    arena->alloc_names = alloc_names;
+
+    name = mxml_arena_find(arena, s, hash);
+  }
+
+  if ((name->name = _mxml_arena_strdup(arena, s)) == NULL)
+    return (NULL);
+
+  name->hash = hash;
+  arena->num_names ++;
+
+  return (name->name);
+}
+
+
+/*
+ * '_mxml_arena_lookup()' - Find an interned name without adding it.
+ */
+
+const char *				/* O - Interned name or @code NULL@ if not interned */
+_mxml_arena_lookup(_mxml_arena_t *arena,/* I - Arena */
+                   const char    *s)	/* I - Name */
+{
+  _mxml_name_t	*name;			/* Table entry */
+
+
+  if ((name = mxml_arena_find(arena, s, _mxml_strhash(s))) != NULL)
+    return (name->name);
+  else
+    return (NULL);
+}
+
+
+/*
+ * '_mxml_arena_strdup()' - Copy a string into an arena.
+ */
+
+char *					/* O - Copy of string or @code NULL@ on error */
+_mxml_arena_strdup(_mxml_arena_t *arena,/* I - Arena */
+                   const char    *s)	/* I - String */
+{
+  size_t	len = strlen(s) + 1;	/* Length of string */
+  char		*copy;			/* Copy of string */
+
+
+  if ((copy = _mxml_arena_alloc(arena, len, 1)) != NULL)
+    memcpy(copy, s, len);
+
+  return (copy);
+}
+
+
+/*
+ * 'mxml_arena_find()' - Find the hash table entry for a name.
+ */
+
+static _mxml_name_t *			/* O - Matching or unused entry, @code NULL@ if there is no table */
+mxml_arena_find(_mxml_arena_t *arena,	/* I - Arena */
+                const char    *s,	/* I - Name */
+                unsigned      hash)	/* I - Hash of name */
+{
+  size_t	i,			/* Current entry */
+		mask;			/* Mask for table size */
+
+
+  if (!arena->alloc_names)
+    return (NULL);
+
+  for (mask = arena->alloc_names - 1, i = hash & mask; arena->names[i].name; i = (i + 1) & mask)
+    if (arena->names[i].hash == hash && !strcmp(arena->names[i].name, s))
+      break;
+
+  return (arena->names + i);
+}
+
+
+/*
+ * 'mxml_arena_release()' - Release a node's use of an arena.
+ *
+ * The slabs are freed when no nodes are left.  The arena itself lives in the
+ * oldest slab, which is freed last.
+ */
+
+static void
+mxml_arena_release(_mxml_arena_t *arena)/* I - Arena */
+{
+  _mxml_slab_t	*slab,			/* Current slab */
+		*next;			/* Next slab */
+
+
+  if (-- arena->num_nodes > 0)
+    return;
+
+  _mxml_free(arena->names);
+
+  for (slab = arena->slabs; slab; slab = next)
+  {
+    next = slab->next;
+    _mxml_free(slab);
+  }
+}
+
+
+#ifdef MXML_COMPACT_NODES
+/*
+ * 'mxml_extra_find()' - Find a node's side table entry.
+ *
+ * The caller must hold the side table lock.
+ */
+
+static _mxml_extra_t *			/* O - Entry or @code NULL@ if not found */
+mxml_extra_find(mxml_node_t *node,	/* I - Node */
+                int         create)	/* I - 1 to add an entry with the defaults */
+{
+  size_t	i,			/* Current entry */
+		j,			/* Entry in new table */
+		mask,			/* Mask for table size */
+		alloc_extras;		/* New size of table */
+  _mxml_extra_t	*extras;		/* New table */
+
+
+  if (create && 2 * (mxml_num_extras + 1) > mxml_alloc_extras)
+  {
+   /*
+    * Double the size of the table, keeping it at most half full...
+    */
+
+    alloc_extras = mxml_alloc_extras ? 2 * mxml_alloc_extras : 64;
+
+    if ((extras = calloc(alloc_extras, sizeof(_mxml_extra_t))) == NULL)
+    {
+      mxml_error("Unable to allocate memory for node data.");
+      return (NULL);
+    }
+
+    for (i = 0; i < mxml_alloc_extras; i ++)
+    {
+      if (!mxml_extras[i].node)
+        continue;
+
+      for (j = mxml_extra_hash(mxml_extras[i].node) & (alloc_extras - 1); extras[j].node; j = (j + 1) & (alloc_extras - 1));
+
+      extras[j] = mxml_extras[i];
+    }
+
+    free(mxml_extras);
+
+    mxml_extras       = extras;
+    mxml_alloc_extras = alloc_extras;
+  }
+
+  if (!mxml_alloc_extras)
+    return (NULL);
+
+  for (mask = mxml_alloc_extras - 1, i = mxml_extra_hash(node) & mask; mxml_extras[i].node; i = (i + 1) & mask)
+    if (mxml_extras[i].node == node)
+      return (mxml_extras + i);
+
+  if (!create)
+    return (NULL);
+
+  mxml_extras[i].node      = node;
+  mxml_extras[i].ref_count = 1;
+  mxml_extras[i].user_data = NULL;
+
+  mxml_num_extras ++;
+
+  return (mxml_extras + i);
+}
+
+
+/*
+ * 'mxml_extra_lock()' - Lock the side table.
+ */
+
+static void
+mxml_extra_lock(void)
+{
+#  ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&mxml_extras_mutex);
+#  elif defined(_WIN32)
+  AcquireSRWLockExclusive(&mxml_extras_lock);
+#  endif /* HAVE_PTHREAD_H */
+}
+
+
+/*
+ * 'mxml_extra_remove()' - Remove a side table entry.
+ *
+ * Later entries in the same run are moved back so that lookups do not need
+ * tombstones.  The caller must hold the side table lock.
+ */
+
+static void
+mxml_extra_remove(_mxml_extra_t *extra)	/* I - Entry */
+{
+  size_t	i,			/* Empty entry */
+		j,			/* Current entry */
+		k,			/* Home of current entry */
+		mask;			/* Mask for table size */
+
+
+  mask = mxml_alloc_extras - 1;
+
+  for (i = j = (size_t)(extra - mxml_extras);;)
+  {
+    j = (j + 1) & mask;
+
+    if (!mxml_extras[j].node)
+      break;
+
+    k = mxml_extra_hash(mxml_extras[j].node) & mask;
+
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;				/* Entry is still reachable */
+
+    mxml_extras[i] = mxml_extras[j];
+    i              = j;
+  }
+
+  mxml_extras[i].node = NULL;
+  mxml_num_extras --;
+}
+
+
+/*
+ * 'mxml_extra_unlock()' - Unlock the side table.
+ */
+
+static void
+mxml_extra_unlock(void)
+{
+#  ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&mxml_extras_mutex);
+#  elif defined(_WIN32)
+  ReleaseSRWLockExclusive(&mxml_extras_lock);
+#  endif /* HAVE_PTHREAD_H */
+}
+#endif /* MXML_COMPACT_NODES */
+
+
 /*
  * 'mxml_free()' - Free the memory used by a node.
  *
@@ -772,35 +1240,35 @@ mxml_free(mxml_node_t *node)		/* I - Node */
   switch (node->type)
   {
     case MXML_ELEMENT :
-        if (node->value.element.name)
-	  free(node->value.element.name);
+        if (node->value.element.name && !(node->flags & _MXML_NODE_REF_VALUE))
+	  _mxml_free(node->value.element.name);
 
-	if (node->value.element.num_attrs)
+	if (node->num_attrs)
 	{
-	  for (i = 0; i < node->value.element.num_attrs; i ++)
+	  if (!(node->flags & _MXML_NODE_REF_ATTRS))
 	  {
-	    if (node->value.element.attrs[i].name)
-	      free(node->value.element.attrs[i].name);
-	    if (node->value.element.attrs[i].value)
-	      free(node->value.element.attrs[i].value);
-	  }
+	    for (i = 0; i < node->num_attrs; i ++)
+	      _mxml_free_attr(node->value.element.attrs + i);
 
-          free(node->value.element.attrs);
+	    _mxml_free(node->value.element.attrs);
+	  }
+	  else if (!node->arena)
+	    _mxml_free(node->value.element.attrs);
 	}
         break;
     case MXML_INTEGER :
        /* Nothing to do */
         break;
     case MXML_OPAQUE :
-        if (node->value.opaque)
-	  free(node->value.opaque);
+        if (node->value.opaque && !(node->flags & _MXML_NODE_REF_VALUE))
+	  _mxml_free(node->value.opaque);
         break;
     case MXML_REAL :
        /* Nothing to do */
         break;
     case MXML_TEXT :
-        if (node->value.text.string)
-	  free(node->value.text.string);
+        if (node->value.text.string && !(node->flags & _MXML_NODE_REF_VALUE))
+	  _mxml_free(node->value.text.string);
         break;
     case MXML_CUSTOM :
         if (node->value.custom.data &&
@@ -815,30 +1283,60 @@ mxml_free(mxml_node_t *node)		/* I - Node */
   * Free this node...
   */
 
-  free(node);
+#ifdef MXML_COMPACT_NODES
+  if (node->flags & _MXML_NODE_EXTRA)
+  {
+    _mxml_extra_t *extra;		/* Side table entry */
+
+    mxml_extra_lock();
+
+    if ((extra = mxml_extra_find(node, 0)) != NULL)
+      mxml_extra_remove(extra);
+
+    mxml_extra_unlock();
+  }
+#endif /* MXML_COMPACT_NODES */
+
+  if (node->arena)
+    mxml_arena_release(node->arena);
+  else
+    _mxml_free(node);
 }
 
 
 /*
- * 'mxml_new()' - Create a new node.
+ * 'mxml_new()' - Create a new node with extra bytes after it.
+ *
+ * The extra bytes are not available for nodes in an arena.
  */
 
 static mxml_node_t *			/* O - New node */
 mxml_new(mxml_node_t *parent,		/* I - Parent node */
-         mxml_type_t type)		/* I - Node type */
+         mxml_type_t type,		/* I - Node type */
+         size_t      extra)		/* I - Number of extra bytes */
 {
   mxml_node_t	*node;			/* New node */
 
 
 #if DEBUG > 1
-  fprintf(stderr, "mxml_new(parent=%p, type=%d)\n", parent, type);
+  fprintf(stderr, "mxml_new(parent=%p, type=%d, extra=%u)\n", parent, type, (unsigned)extra);
 #endif /* DEBUG > 1 */
 
  /*
-  * Allocate memory for the node...
+  * Allocate memory for the node, from the parent's arena if it has one...
   */
 
-  if ((node = calloc(1, sizeof(mxml_node_t))) == NULL)
+  if (parent && parent->arena)
+  {
+    if ((node = _mxml_arena_alloc(parent->arena, sizeof(mxml_node_t), sizeof(double))) == NULL)
+      return (NULL);
+
+    memset(node, 0, sizeof(mxml_node_t));
+
+    node->arena = parent->arena;
+    node->arena->num_nodes ++;
+  }
+  else if ((node = _mxml_calloc(1, sizeof(mxml_node_t) + extra)) == NULL)
   {
 #if DEBUG > 1
     fputs("    returning NULL\n", stderr);
@@ -855,8 +1353,10 @@ mxml_new(mxml_node_t *parent,		/* I - Parent node */
   * Set the node type...
   */
 
-  node->type      = type;
+  node->type = type;
+#ifndef MXML_COMPACT_NODES
   node->ref_count = 1;
+#endif /* !MXML_COMPACT_NODES */
 
  /*
   * Add to the parent if present...
@@ -871,3 +1371,280 @@ mxml_new(mxml_node_t *parent,		/* I - Parent node */
 
   return (node);
 }
+
+
+/*
+ * 'mxml_ref_add()' - Add to a node's reference count.
+ *
+ * Compact nodes without a side table entry have a reference count of 1, so an
+ * entry is only kept while the count is something else or there is user data.
+ */
+
+static int				/* O - New reference count or -1 on error */
+mxml_ref_add(mxml_node_t *node,		/* I - Node */
+             int         delta)		/* I - Amount to add */
+{
+#ifdef MXML_COMPACT_NODES
+  _mxml_extra_t	*extra;			/* Side table entry */
+  int		ref_count;		/* New reference count */
+
+
+  if (!(node->flags & _MXML_NODE_EXTRA) && delta < 0)
+    return (1 + delta);
+
+  mxml_extra_lock();
+
+  if ((extra = mxml_extra_find(node, 1)) == NULL)
+  {
+    ref_count = -1;
+  }
+  else if ((ref_count = extra->ref_count += delta) == 1 && !extra->user_data)
+  {
+    mxml_extra_remove(extra);
+    node->flags &= ~_MXML_NODE_EXTRA;
+  }
+  else
+    node->flags |= _MXML_NODE_EXTRA;
+
+  mxml_extra_unlock();
+
+  return (ref_count);
+
+#else
+  return (node->ref_count += delta);
+#endif /* MXML_COMPACT_NODES */
+}
+
+
+/*
+ * '_mxml_new()' - Create a new node.
+ */
+
+mxml_node_t *				/* O - New node */
+_mxml_new(mxml_node_t *parent,		/* I - Parent node */
+          mxml_type_t type)		/* I - Node type */
+{
+  return (mxml_new(parent, type, 0));
+}
+
+
+/*
+ * '_mxml_new_arena()' - Create a new node in a new arena.
+ *
+ * The arena is stored at the start of its first slab.
+ */
+
+mxml_node_t *				/* O - New node */
+_mxml_new_arena(mxml_type_t type)	/* I - Node type */
+{
+  _mxml_slab_t	*slab;			/* First slab */
+  _mxml_arena_t	*arena;			/* New arena */
+  mxml_node_t	*node;			/* New node */
+
+
+  if ((slab = _mxml_malloc(_MXML_ARENA_FIRST)) == NULL)
+    return (NULL);
+
+  arena = (_mxml_arena_t *)(slab + 1);
+
+  slab->next       = NULL;
+  arena->slabs       = slab;
+  arena->current     = (char *)(arena + 1);
+  arena->end         = (char *)slab + _MXML_ARENA_FIRST;
+  arena->slab_size   = 2 * _MXML_ARENA_FIRST;
+  arena->num_nodes   = 1;
+  arena->names       = NULL;
+  arena->num_names   = 0;
+  arena->alloc_names = 0;
+
+  node = _mxml_arena_alloc(arena, sizeof(mxml_node_t), sizeof(double));
+
+  memset(node, 0, sizeof(mxml_node_t));
+
+  node->type  = type;
+  node->arena = arena;
+#ifndef MXML_COMPACT_NODES
+  node->ref_count = 1;
+#endif /* !MXML_COMPACT_NODES */
+
+  return (node);
+}
+
+
+/*
+ * '_mxml_new_value()' - Create a new element, opaque, or text node with a
+ *                       copy of a string.
+ *
+ * Short strings are stored after the node in the same allocation, where they
+ * are borrowed like the strings of a document loaded in place.
+ */
+
+mxml_node_t *				/* O - New node */
+_mxml_new_value(mxml_node_t *parent,	/* I - Parent node */
+                mxml_type_t type,	/* I - Node type */
+                const char  *s)		/* I - Name or value string */
+{
+  mxml_node_t	*node;			/* New node */
+  char		*value;			/* Copy of string */
+  size_t	len = strlen(s) + 1;	/* Length of string with nul */
+
+
+  if (len <= _MXML_INLINE_SIZE && !(parent && parent->arena))
+  {
+    if ((node = mxml_new(parent, type, len)) == NULL)
+      return (NULL);
+
+    value       = memcpy(node + 1, s, len);
+    node->flags |= _MXML_NODE_REF_VALUE;
+  }
+  else if ((node = mxml_new(parent, type, 0)) == NULL)
+  {
+    return (NULL);
+  }
+  else if ((value = _mxml_strdup_value(node, s)) == NULL)
+  {
+    mxmlDelete(node);
+    return (NULL);
+  }
+
+  if (type == MXML_ELEMENT)
+    node->value.element.name = value;
+  else if (type == MXML_OPAQUE)
+    node->value.opaque = value;
+  else
+    node->value.text.string = value;
+
+  return (node);
+}
+
+
+/*
+ * '_mxml_replace_value()' - Replace a node's name or string value.
+ *
+ * The new string is allocated with the current allocation functions.  Nodes
+ * in an arena use a copy in the arena instead, so that deleting an arena
+ * document only frees memory that the arena allocated.
+ */
+
+void
+_mxml_replace_value(mxml_node_t *node,	/* I - Node */
+                    char        **value,/* I - Name or value to replace */
+                    char        *s)	/* I - New string or @code NULL@ */
+{
+  char	*copy;				/* Copy of string in arena */
+
+
+  if (*value && !(node->flags & _MXML_NODE_REF_VALUE))
+    _mxml_free(*value);
+
+  node->flags &= ~(_MXML_NODE_REF_VALUE | _MXML_NODE_NAME_INTERNED);
+
+  if (s && node->arena && (copy = _mxml_strdup_value(node, s)) != NULL)
+  {
+    _mxml_free(s);
+    s = copy;
+  }
+
+  *value = s;
+}
+
+
+/*
+ * '_mxml_strdup_value()' - Copy a string for a node's name or value.
+ *
+ * Nodes in an arena borrow the copy from the arena, with element names
+ * (but not comments, directives, or CDATA) interned.
+ */
+
+char *					/* O - Copy of string or @code NULL@ on error */
+_mxml_strdup_value(mxml_node_t *node,	/* I - Node */
+                   const char  *s)	/* I - String */
+{
+  char	*copy;				/* Copy of string */
+
+
+  if (!node->arena)
+    return (_mxml_strdup(s));
+
+  if (node->type == MXML_ELEMENT && *s != '!' && *s != '?')
+  {
+    if ((copy = _mxml_arena_intern(node->arena, s)) != NULL)
+      node->flags |= _MXML_NODE_REF_VALUE | _MXML_NODE_NAME_INTERNED;
+  }
+  else if ((copy = _mxml_arena_strdup(node->arena, s)) != NULL)
+    node->flags |= _MXML_NODE_REF_VALUE;
+
+  return (copy);
+}
+
+
+/*
+ * '_mxml_get_user_data()' - Get a node's user data.
+ */
+
+void *					/* O - User data or @code NULL@ */
+_mxml_get_user_data(mxml_node_t *node)	/* I - Node */
+{
+#ifdef MXML_COMPACT_NODES
+  _mxml_extra_t	*extra;			/* Side table entry */
+  void		*data = NULL;		/* User data */
+
+
+  if (node->flags & _MXML_NODE_EXTRA)
+  {
+    mxml_extra_lock();
+
+    if ((extra = mxml_extra_find(node, 0)) != NULL)
+      data = extra->user_data;
+
+    mxml_extra_unlock();
+  }
+
+  return (data);
+
+#else
+  return (node->user_data);
+#endif /* MXML_COMPACT_NODES */
+}
+
+
+/*
+ * '_mxml_set_user_data()' - Set a node's user data.
+ */
+
+int					/* O - 0 on success, -1 on error */
+_mxml_set_user_data(mxml_node_t *node,	/* I - Node */
+                    void        *data)	/* I - User data */
+{
+#ifdef MXML_COMPACT_NODES
+  _mxml_extra_t	*extra;			/* Side table entry */
+
+
+  if (!data && !(node->flags & _MXML_NODE_EXTRA))
+    return (0);
+
+  mxml_extra_lock();
+
+  if ((extra = mxml_extra_find(node, 1)) != NULL)
+  {
+    extra->user_data = data;
+
+    if (!data && extra->ref_count == 1)
+    {
+      mxml_extra_remove(extra);
+      node->flags &= ~_MXML_NODE_EXTRA;
+    }
+    else
+      node->flags |= _MXML_NODE_EXTRA;
+  }
+
+  mxml_extra_unlock();
+
+  return (extra ? 0 : -1);
+
+#else
+  node->user_data = data;
+
+  return (0);
+#endif /* MXML_COMPACT_NODES */
+}
@@ -43,6 +43,67 @@
 #endif /* __sun */
 
 
+/*
+ * Allocation functions.  They are shared by all threads and can only be set
+ * before Mini-XML allocates any memory, so that all memory is freed with the
+ * functions that allocated it.  The state is checked with an atomic load...
+ */
+
+#define _MXML_ALLOC_OPEN	0	/* Functions can still be set */
+#define _MXML_ALLOC_FIXED	1	/* Memory has been allocated */
+#define _MXML_ALLOC_SETTING	2	/* mxmlSetAllocator is setting them */
+
+#ifdef HAVE_STDATOMIC_H
+#  include <stdatomic.h>
+
+static atomic_int	mxml_alloc_state = _MXML_ALLOC_OPEN;
+					/* Allocation state */
+
+#  define mxml_alloc_get()	atomic_load_explicit(&mxml_alloc_state, memory_order_acquire)
+#  define mxml_alloc_put(s)	atomic_store_explicit(&mxml_alloc_state, (s), memory_order_release)
+
+static int
+mxml_alloc_cas(int from, int to)
+{
+  return (atomic_compare_exchange_strong(&mxml_alloc_state, &from, to));
+}
+
+#elif defined(_WIN32)
+#  include <windows.h>
+
+static volatile LONG	mxml_alloc_state = _MXML_ALLOC_OPEN;
+					/* Allocation state */
+
+#  define mxml_alloc_get()	InterlockedCompareExchange(&mxml_alloc_state, 0, 0)
+#  define mxml_alloc_put(s)	InterlockedExchange(&mxml_alloc_state, (s))
+#  define mxml_alloc_cas(from,to) (InterlockedCompareExchange(&mxml_alloc_state, (to), (from)) == (from))
+
+#else
+static int		mxml_alloc_state = _MXML_ALLOC_OPEN;
+					/* Allocation state (no atomics) */
+
+#  define mxml_alloc_get()	mxml_alloc_state
+#  define mxml_alloc_put(s)	mxml_alloc_state = (s)
+#  define mxml_alloc_cas(from,to) (mxml_alloc_state == (from) ? (mxml_alloc_state = (to), 1) : 0)
+#endif /* HAVE_STDATOMIC_H */
+
+static mxml_malloc_cb_t	mxml_malloc_cb = NULL;
+					/* Allocation function or NULL */
+static mxml_realloc_cb_t mxml_realloc_cb = NULL;
+					/* Reallocation function or NULL */
+static mxml_free_cb_t	mxml_free_cb = NULL;
+					/* Free function or NULL */
+static void		*mxml_alloc_ctx = NULL;
+					/* Context for allocation functions */
+
+
+/*
+ * Local functions...
+ */
+
+static void		mxml_alloc_fix(void);
+
+
 /*
  * 'mxml_error()' - Display an error message.
  */
@@ -137,6 +198,174 @@ mxml_real_cb(mxml_node_t *node)		/* I - Current node */
 }
 
 
+/*
+ * 'mxmlSetAllocator()' - Set the memory allocation functions.
+ *
+ * The functions are used by all threads for nodes, strings, and other memory
+ * that Mini-XML allocates and frees.  Each function receives the "ctx"
+ * pointer as its first argument.  Pass @code NULL@ for any function to use
+ * the standard malloc, realloc, and free functions.
+ *
+ * The functions can only be set before Mini-XML allocates any memory, for
+ * example at the start of the program, so that all memory is freed with the
+ * functions that allocated it.  Once Mini-XML has allocated memory this
+ * function does nothing and returns -1.
+ *
+ * Strings returned to the caller, such as the result of
+ * @link mxmlSaveAllocString@, are still allocated with malloc.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 if memory has already been allocated */
+mxmlSetAllocator(
+    mxml_malloc_cb_t  malloc_cb,	/* I - Allocation function or @code NULL@ */
+    mxml_realloc_cb_t realloc_cb,	/* I - Reallocation function or @code NULL@ */
+    mxml_free_cb_t    free_cb,		/* I - Free function or @code NULL@ */
+    void              *ctx)		/* I - Context pointer for functions */
+{
+  if (!mxml_alloc_cas(_MXML_ALLOC_OPEN, _MXML_ALLOC_SETTING))
+    return (-1);
+
+  if (malloc_cb && realloc_cb && free_cb)
+  {
+    mxml_malloc_cb  = malloc_cb;
+    mxml_realloc_cb = realloc_cb;
+    mxml_free_cb    = free_cb;
+    mxml_alloc_ctx  = ctx;
+  }
+  else
+  {
+    mxml_malloc_cb  = NULL;
+    mxml_realloc_cb = NULL;
+    mxml_free_cb    = NULL;
+    mxml_alloc_ctx  = NULL;
+  }
+
+  mxml_alloc_put(_MXML_ALLOC_OPEN);
+
+  return (0);
+}
+
+
+/*
+ * '_mxml_calloc()' - Allocate zeroed memory.
+ */
+
+void *					/* O - Memory or @code NULL@ on error */
+_mxml_calloc(size_t num,		/* I - Number of objects */
+             size_t size)		/* I - Size of each object */
+{
+  void	*ptr;				/* Allocated memory */
+
+
+  if (mxml_alloc_get() != _MXML_ALLOC_FIXED)
+    mxml_alloc_fix();
+
+  if (!mxml_malloc_cb)
+    return (calloc(num, size));
+
+  if (size && num > (size_t)-1 / size)
+    return (NULL);
+
+  if ((ptr = (*mxml_malloc_cb)(mxml_alloc_ctx, num * size)) != NULL)
+    memset(ptr, 0, num * size);
+
+  return (ptr);
+}
+
+
+/*
+ * '_mxml_free()' - Free memory.
+ */
+
+void
+_mxml_free(void *ptr)			/* I - Memory or @code NULL@ */
+{
+  if (!ptr)
+    return;
+
+  if (mxml_alloc_get() != _MXML_ALLOC_FIXED)
+    mxml_alloc_fix();
+
+  if (mxml_free_cb)
+    (*mxml_free_cb)(mxml_alloc_ctx, ptr);
+  else
+    free(ptr);
+}
+
+
+/*
+ * '_mxml_malloc()' - Allocate memory.
+ */
+
+void *					/* O - Memory or @code NULL@ on error */
+_mxml_malloc(size_t size)		/* I - Number of bytes */
+{
+  if (mxml_alloc_get() != _MXML_ALLOC_FIXED)
+    mxml_alloc_fix();
+
+  if (mxml_malloc_cb)
+    return ((*mxml_malloc_cb)(mxml_alloc_ctx, size));
+  else
+    return (malloc(size));
+}
+
+
+/*
+ * '_mxml_realloc()' - Reallocate memory.
+ */
+
+void *					/* O - Memory or @code NULL@ on error */
+_mxml_realloc(void   *ptr,		/* I - Memory or @code NULL@ */
+              size_t size)		/* I - New number of bytes */
+{
+  if (mxml_alloc_get() != _MXML_ALLOC_FIXED)
+    mxml_alloc_fix();
+
+  if (mxml_realloc_cb)
+    return ((*mxml_realloc_cb)(mxml_alloc_ctx, ptr, size));
+  else
+    return (realloc(ptr, size));
+}
+
+
+/*
+ * '_mxml_strdup()' - Duplicate a string.
+ */
+
+char *					/* O - New string or @code NULL@ on error */
+_mxml_strdup(const char *s)		/* I - String to duplicate */
+{
+  size_t	len = strlen(s) + 1;	/* Length of string with nul */
+  char		*t;			/* New string */
+
+
+  if ((t = _mxml_malloc(len)) != NULL)
+    memcpy(t, s, len);
+
+  return (t);
+}
+
+
+/*
+ * 'mxml_alloc_fix()' - Stop the allocation functions from being changed.
+ *
+ * Waits if another thread is setting the functions, so that the first
+ * allocation uses the functions that will later free it.
+ */
+
+static void
+mxml_alloc_fix(void)
+{
+  while (!mxml_alloc_cas(_MXML_ALLOC_OPEN, _MXML_ALLOC_FIXED))
+  {
+    if (mxml_alloc_get() == _MXML_ALLOC_FIXED)
+      break;
+  }
+}
+
+
 #ifdef HAVE_PTHREAD_H			/**** POSIX threading ****/
 #  include <pthread.h>
 
@@ -17,21 +17,70 @@
 #include "mxml.h"
 
 
+/*
+ * Node flags...
+ */
+
+#define _MXML_NODE_REF_VALUE	1	/* Name/string value is borrowed, not allocated */
+#define _MXML_NODE_REF_ATTRS	2	/* Attribute names and values are borrowed */
+#define _MXML_NODE_NAME_INTERNED 4	/* Element name is interned in the arena */
+#define _MXML_NODE_ATTRS_INTERNED 8	/* Attribute names are interned in the arena */
+#define _MXML_NODE_EXTRA	16	/* Reference count or user data is in the side table (compact nodes) */
+
+
+/*
+ * Size of the first and largest arena slabs...
+ */
+
+#define _MXML_ARENA_FIRST	16384
+#define _MXML_ARENA_MAX		1048576
+
+
+/*
+ * Size of short strings that are stored with the node or attribute name
+ * instead of being allocated separately, including the nul...
+ */
+
+#define _MXML_INLINE_SIZE	16
+
+
 /*
  * Private structures...
  */
 
+typedef struct _mxml_slab_s		/**** A block of arena memory ****/
+{
+  struct _mxml_slab_s	*next;		/* Next (older) slab */
+} _mxml_slab_t;
+
+typedef struct _mxml_name_s		/**** An interned name ****/
+{
+  char			*name;		/* Name in arena or NULL if unused */
+  unsigned		hash;		/* Hash of name */
+} _mxml_name_t;
+
+typedef struct _mxml_arena_s		/**** A document arena ****/
+{
+  _mxml_slab_t		*slabs;		/* Slabs, newest first */
+  char			*current,	/* Free space in newest slab */
+			*end;		/* End of newest slab */
+  size_t		slab_size;	/* Size of next slab */
+  size_t		num_nodes;	/* Number of nodes using the arena */
+  _mxml_name_t		*names;		/* Interned names (hash table) */
+  size_t		num_names,	/* Number of interned names */
+			alloc_names;	/* Size of hash table */
+} _mxml_arena_t;
+
 typedef struct _mxml_attr_s		/**** An XML element attribute value. ****/
 {
   char			*name;		/* Attribute name */
-  char			*value;		/* Attribute value */
+  char			*value;		/* Attribute value, after the name if short */
 } _mxml_attr_t;
 
 typedef struct _mxml_element_s		/**** An XML element value. ****/
 {
   char			*name;		/* Name of element */
-  int			num_attrs;	/* Number of attributes */
-  _mxml_attr_t		*attrs;		/* Attributes */
+  _mxml_attr_t		*attrs;		/* Attributes (number is in the node) */
 } _mxml_element_t;
 
 typedef struct _mxml_text_s		/**** An XML text value. ****/
@@ -49,7 +98,7 @@ typedef struct _mxml_custom_s		/**** An XML custom value. ****/
 typedef union _mxml_value_u		/**** An XML node value. ****/
 {
   _mxml_element_t	element;	/* Element */
-  int			integer;	/* Integer number */
+  long long		integer;	/* Integer number */
   char			*opaque;	/* Opaque string */
   double		real;		/* Real number */
   _mxml_text_t		text;		/* Text fragment */
@@ -58,15 +107,20 @@ typedef union _mxml_value_u		/**** An XML node value. ****/
 
 struct _mxml_node_s			/**** An XML node. ****/
 {
-  mxml_type_t		type;		/* Node type */
+  signed char		type;		/* Node type (mxml_type_t) */
+  unsigned char		flags;		/* Node flags (_MXML_NODE_xxx) */
+  int			num_attrs;	/* Number of attributes for elements */
   struct _mxml_node_s	*next;		/* Next node under same parent */
   struct _mxml_node_s	*prev;		/* Previous node under same parent */
   struct _mxml_node_s	*parent;	/* Parent node */
   struct _mxml_node_s	*child;		/* First child node */
   struct _mxml_node_s	*last_child;	/* Last child node */
   _mxml_value_t		value;		/* Node value */
+#ifndef MXML_COMPACT_NODES
   int			ref_count;	/* Use count */
   void			*user_data;	/* User data */
+#endif /* !MXML_COMPACT_NODES */
+  _mxml_arena_t		*arena;		/* Arena holding the node or NULL */
 };
 
 struct _mxml_index_s			 /**** An XML node index. ****/
@@ -87,6 +141,8 @@ typedef struct _mxml_global_s		/**** Global, per-thread data ****/
   int	wrap;
   mxml_custom_load_cb_t	custom_load_cb;
   mxml_custom_save_cb_t	custom_save_cb;
+  char	*error;
+  mxml_compress_t	compression;
 } _mxml_global_t;
 
 
@@ -94,5 +150,24 @@ typedef struct _mxml_global_s		/**** Global, per-thread data ****/
  * Functions...
  */
 
+extern int		_mxml_add_attr(mxml_node_t *node, char *name, char *value);
+extern void		*_mxml_arena_alloc(_mxml_arena_t *arena, size_t size, size_t align);
+extern char		*_mxml_arena_intern(_mxml_arena_t *arena, const char *s);
+extern const char	*_mxml_arena_lookup(_mxml_arena_t *arena, const char *s);
+extern char		*_mxml_arena_strdup(_mxml_arena_t *arena, const char *s);
+extern void		*_mxml_calloc(size_t num, size_t size);
+extern void		_mxml_free(void *ptr);
+extern void		_mxml_free_attr(_mxml_attr_t *attr);
 extern _mxml_global_t	*_mxml_global(void);
+extern void		*_mxml_get_user_data(mxml_node_t *node);
 extern int		_mxml_entity_cb(const char *name);
+extern void		*_mxml_malloc(size_t size);
+extern mxml_node_t	*_mxml_new(mxml_node_t *parent, mxml_type_t type);
+extern mxml_node_t	*_mxml_new_arena(mxml_type_t type);
+extern mxml_node_t	*_mxml_new_value(mxml_node_t *parent, mxml_type_t type, const char *s);
+extern int		_mxml_own_attrs(mxml_node_t *node);
+extern void		*_mxml_realloc(void *ptr, size_t size);
+extern void		_mxml_replace_value(mxml_node_t *node, char **value, char *s);
+extern int		_mxml_set_user_data(mxml_node_t *node, void *data);
+extern char		*_mxml_strdup(const char *s);
+extern char		*_mxml_strdup_value(mxml_node_t *node, const char *s);
@@ -39,6 +39,9 @@ mxmlFindElement(mxml_node_t *node,	/* I - Current node */
 		int         descend)	/* I - Descend into tree - @code MXML_DESCEND@, @code MXML_NO_DESCEND@, or @code MXML_DESCEND_FIRST@ */
 {
   const char	*temp;			/* Current attribute value */
+  _mxml_arena_t	*arena = NULL;		/* Arena of interned names */
+  const char	*ielement = NULL,	/* Interned element name */
+		*iattr = NULL;		/* Interned attribute name */
 
 
  /*
@@ -60,13 +63,25 @@ mxmlFindElement(mxml_node_t *node,	/* I - Current node */
 
   while (node != NULL)
   {
+   /*
+    * Look up the names once in each arena, so that interned names can be
+    * compared by pointer.  A name that is not in the arena cannot match...
+    */
+
+    if ((node->flags & (_MXML_NODE_NAME_INTERNED | _MXML_NODE_ATTRS_INTERNED)) && node->arena != arena)
+    {
+      arena    = node->arena;
+      ielement = element ? _mxml_arena_lookup(arena, element) : NULL;
+      iattr    = attr ? _mxml_arena_lookup(arena, attr) : NULL;
+    }
+
    /*
     * See if this node matches...
     */
 
     if (node->type == MXML_ELEMENT &&
         node->value.element.name &&
-	(!element || !strcmp(node->value.element.name, element)))
+	(!element || ((node->flags & _MXML_NODE_NAME_INTERNED) ? node->value.element.name == ielement : !strcmp(node->value.element.name, element))))
     {
      /*
       * See if we need to check for an attribute...
@@ -79,7 +94,12 @@ mxmlFindElement(mxml_node_t *node,	/* I - Current node */
       * Check for the attribute...
       */
 
-      if ((temp = mxmlElementGetAttr(node, attr)) != NULL)
+      if (node->flags & _MXML_NODE_ATTRS_INTERNED)
+        temp = iattr ? mxmlElementGetAttr(node, iattr) : NULL;
+      else
+        temp = mxmlElementGetAttr(node, attr);
+
+      if (temp != NULL)
       {
        /*
         * OK, we have the attribute, does it match?
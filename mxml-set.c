@@ -55,10 +55,7 @@ mxmlSetCDATA(mxml_node_t *node,		/* I - Node to set */
 
   s = _mxml_strdupf("![CDATA[%s", data);
 
-  if (node->value.element.name)
-    free(node->value.element.name);
-
-  node->value.element.name = s;
+  _mxml_replace_value(node, &node->value.element.name, s);
 
   return (0);
 }
@@ -119,6 +116,9 @@ int					/* O - 0 on success, -1 on failure */
 mxmlSetElement(mxml_node_t *node,	/* I - Node to set */
                const char  *name)	/* I - New name string */
 {
+  char	*s;				/* New name string */
+
+
  /*
   * Range check input...
   */
@@ -133,10 +133,9 @@ mxmlSetElement(mxml_node_t *node,	/* I - Node to set */
   * Free any old element value and set the new value...
   */
 
-  if (node->value.element.name)
-    free(node->value.element.name);
+  s = _mxml_strdup(name);
 
-  node->value.element.name = strdup(name);
+  _mxml_replace_value(node, &node->value.element.name, s);
 
   return (0);
 }
@@ -151,6 +150,22 @@ mxmlSetElement(mxml_node_t *node,	/* I - Node to set */
 int					/* O - 0 on success, -1 on failure */
 mxmlSetInteger(mxml_node_t *node,	/* I - Node to set */
                int         integer)	/* I - Integer value */
+{
+  return (mxmlSetInteger64(node, integer));
+}
+
+
+/*
+ * 'mxmlSetInteger64()' - Set the value of an integer node to a 64-bit integer.
+ *
+ * The node is not changed if it (or its first child) is not an integer node.
+ *
+ * @since Mini-XML 3.1@
+ */
+
+int					/* O - 0 on success, -1 on failure */
+mxmlSetInteger64(mxml_node_t *node,	/* I - Node to set */
+                 long long   integer)	/* I - Integer value */
 {
  /*
   * Range check input...
@@ -183,6 +198,9 @@ int					/* O - 0 on success, -1 on failure */
 mxmlSetOpaque(mxml_node_t *node,	/* I - Node to set */
               const char  *opaque)	/* I - Opaque string */
 {
+  char	*s;				/* New opaque string */
+
+
  /*
   * Range check input...
   */
@@ -201,10 +219,9 @@ mxmlSetOpaque(mxml_node_t *node,	/* I - Node to set */
   * Free any old opaque value and set the new value...
   */
 
-  if (node->value.opaque)
-    free(node->value.opaque);
+  s = _mxml_strdup(opaque);
 
-  node->value.opaque = strdup(opaque);
+  _mxml_replace_value(node, &node->value.opaque, s);
 
   return (0);
 }
@@ -246,10 +263,7 @@ mxmlSetOpaquef(mxml_node_t *node,	/* I - Node to set */
   s = _mxml_vstrdupf(format, ap);
   va_end(ap);
 
-  if (node->value.opaque)
-    free(node->value.opaque);
-
-  node->value.opaque = s;
+  _mxml_replace_value(node, &node->value.opaque, s);
 
   return (0);
 }
@@ -297,6 +311,9 @@ mxmlSetText(mxml_node_t *node,		/* I - Node to set */
             int         whitespace,	/* I - 1 = leading whitespace, 0 = no whitespace */
 	    const char  *string)	/* I - String */
 {
+  char	*s;				/* New string */
+
+
  /*
   * Range check input...
   */
@@ -318,11 +335,11 @@ mxmlSetText(mxml_node_t *node,		/* I - Node to set */
   * Free any old string value and set the new value...
   */
 
-  if (node->value.text.string)
-    free(node->value.text.string);
+  s = _mxml_strdup(string);
 
   node->value.text.whitespace = whitespace;
-  node->value.text.string     = strdup(string);
+
+  _mxml_replace_value(node, &node->value.text.string, s);
 
   return (0);
 }
@@ -363,11 +380,9 @@ mxmlSetTextf(mxml_node_t *node,		/* I - Node to set */
   s = _mxml_vstrdupf(format, ap);
   va_end(ap);
 
-  if (node->value.text.string)
-    free(node->value.text.string);
-
   node->value.text.whitespace = whitespace;
-  node->value.text.string     = s;
+
+  _mxml_replace_value(node, &node->value.text.string, s);
 
   return (0);
 }
@@ -394,6 +409,5 @@ mxmlSetUserData(mxml_node_t *node,	/* I - Node to set */
   * Set the user data pointer and return...
   */
 
-  node->user_data = data;
-  return (0);
+  return (_mxml_set_user_data(node, data));
 }
@@ -13,7 +13,11 @@
  * Include necessary headers...
  */
 
-#include "config.h"
+#include "mxml-private.h"
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
 
 
 /*
@@ -30,6 +34,126 @@
 #endif /* va_copy */
 
 
+/*
+ * Powers of 10 that are exactly representable as doubles...
+ */
+
+static const double	mxml_pow10[23] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/*
+ * Local functions...
+ */
+
+static void		mxml_decimal(char *s, size_t slen, const char *from, const char *to);
+
+
+/*
+ * '_mxml_dtoa()' - Format a real number using the shortest string that reads
+ *                  back as the same value.
+ *
+ * Numbers that are a small integer divided by a power of 10, like most
+ * measurements, are formatted directly with the fewest digits after the
+ * decimal point that read back as the same value.  Dividing an integer below
+ * 2^53 by an exact power of 10 is correctly rounded, just like reading the
+ * decimal string, so the division tells us whether the string reads back.
+ *
+ * Other numbers use the first of 15, 16, or 17 significant digits that reads
+ * back as the same value.  "%.15g" drops trailing zeros, so it already gives
+ * the shortest string of a normal number that needs 15 or fewer digits.
+ * Subnormal numbers have less precision and start at 1 digit.  A period is
+ * always used as the decimal point.
+ */
+
+char *					/* O - Buffer */
+_mxml_dtoa(double d,			/* I - Number */
+           char   *buffer,		/* I - Buffer (at least 32 bytes) */
+           size_t bufsize)		/* I - Size of buffer */
+{
+  int			digits;		/* Number of digits after the decimal point */
+  double		a,		/* Absolute value of number */
+			m;		/* Scaled number */
+  unsigned long long	integer;	/* Scaled number as an integer */
+  char			temp[32],	/* Digits in reverse order */
+			*tptr,		/* Pointer into temp */
+			*bufptr;	/* Pointer into buffer */
+
+
+  a = d < 0.0 ? -d : d;
+
+  if (d == d && (d - d) == 0.0)
+  {
+    for (digits = 0; digits < 23; digits ++)
+    {
+      if ((m = a * mxml_pow10[digits]) >= 9007199254740992.0)
+        break;
+
+      integer = (unsigned long long)(m + 0.5);
+
+      if ((double)integer / mxml_pow10[digits] == a)
+      {
+       /*
+        * Drop any trailing zeros, then format the integer, adding the decimal
+        * point...
+        */
+
+        while (digits > 0 && integer % 10 == 0)
+        {
+          integer /= 10;
+          digits --;
+        }
+
+        tptr = temp;
+
+        do
+        {
+          *tptr++ = (char)('0' + integer % 10);
+          integer /= 10;
+        }
+        while (integer > 0 || (tptr - temp) <= digits);
+
+        bufptr = buffer;
+
+        if (signbit(d))
+          *bufptr++ = '-';
+
+        while (tptr > temp)
+        {
+          *bufptr++ = *--tptr;
+
+          if ((tptr - temp) == digits && digits > 0)
+            *bufptr++ = '.';
+        }
+
+        *bufptr = '\0';
+
+        return (buffer);
+      }
+    }
+
+  }
+
+ /*
+  * Use the fewest significant digits that read back as the same value...
+  */
+
+  for (digits = a < DBL_MIN ? 1 : 15; digits <= 17; digits ++)
+  {
+    snprintf(buffer, bufsize, "%.*g", digits, d);
+    mxml_decimal(buffer, bufsize, localeconv()->decimal_point, ".");
+
+    if (d != d || _mxml_strtod(buffer, NULL) == d)
+      break;
+  }
+
+  return (buffer);
+}
+
+
 #ifndef HAVE_SNPRINTF
 /*
  * '_mxml_snprintf()' - Format a string.
@@ -54,28 +178,6 @@ _mxml_snprintf(char       *buffer,	/* I - Output buffer */
 #endif /* !HAVE_SNPRINTF */
 
 
-/*
- * '_mxml_strdup()' - Duplicate a string.
- */
-
-#ifndef HAVE_STRDUP
-char *					/* O - New string pointer */
-_mxml_strdup(const char *s)		/* I - String to duplicate */
-{
-  char	*t;				/* New string pointer */
-
-
-  if (s == NULL)
-    return (NULL);
-
-  if ((t = malloc(strlen(s) + 1)) == NULL)
-    return (NULL);
-
-  return (strcpy(t, s));
-}
-#endif /* !HAVE_STRDUP */
-
-
 /*
  * '_mxml_strdupf()' - Format and duplicate a string.
  */
@@ -94,18 +196,30 @@ _mxml_strdupf(const char *format,	/* I - Printf-style format string */
   */
 
   va_start(ap, format);
-#ifdef HAVE_VASPRINTF
-  if (vasprintf(&s, format, ap) < 0)
-    s = NULL;
-#else
   s = _mxml_vstrdupf(format, ap);
-#endif /* HAVE_VASPRINTF */
   va_end(ap);
 
   return (s);
 }
 
 
+/*
+ * '_mxml_strhash()' - Compute the FNV-1a hash of a string.
+ */
+
+unsigned				/* O - Hash value */
+_mxml_strhash(const char *s)		/* I - String */
+{
+  unsigned	hash = 2166136261U;	/* Hash value */
+
+
+  while (*s)
+    hash = (hash ^ (unsigned char)*s++) * 16777619U;
+
+  return (hash);
+}
+
+
 #ifndef HAVE_STRLCAT
 /*
  * '_mxml_strlcat()' - Safely concatenate a string.
@@ -188,6 +302,249 @@ _mxml_strlcpy(char       *dst,		/* I - Destination buffer */
 #endif /* !HAVE_STRLCPY */
 
 
+/*
+ * '_mxml_strtod()' - Convert a string to a real number.
+ *
+ * Unlike strtod, a period is always used as the decimal point regardless of
+ * the current locale.  Numbers with no more than 19 significant digits and a
+ * small exponent are converted directly without rounding error; all others
+ * use a copy of the number with the locale decimal point passed to strtod.
+ */
+
+double					/* O - Number */
+_mxml_strtod(const char *s,		/* I - String */
+             char       **end)		/* O - Pointer to end of number or @code NULL@ */
+{
+  const char		*start,		/* Start of number */
+			*ptr;		/* Pointer into string */
+  unsigned long long	mantissa = 0;	/* Significant digits */
+  int			digits = 0,	/* Number of significant digits */
+			exponent = 0,	/* Decimal exponent */
+			exp10,		/* Explicit exponent */
+			expsign,	/* Sign of explicit exponent */
+			found = 0;	/* Found any digits? */
+  double		d;		/* Number */
+  char			temp[256],	/* Copy of number */
+			*copy;		/* Pointer to copy */
+  size_t		len;		/* Length of number */
+
+
+  for (start = s; isspace(*start & 255); start ++);
+
+  ptr = start;
+
+  if (*ptr == '-' || *ptr == '+')
+    ptr ++;
+
+  if (!isdigit(*ptr & 255) && (*ptr != '.' || !isdigit(ptr[1] & 255)))
+  {
+   /*
+    * "inf" and "nan" contain no decimal point...
+    */
+
+    return (strtod(s, end));
+  }
+  else if (ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X'))
+  {
+   /*
+    * Hexadecimal numbers are exact...
+    */
+
+    return (strtod(s, end));
+  }
+
+ /*
+  * Collect the significant digits and exponent...
+  */
+
+  for (; isdigit(*ptr & 255); ptr ++, found = 1)
+  {
+    if (digits < 19)
+    {
+      if ((mantissa = mantissa * 10 + (unsigned)(*ptr - '0')) > 0)
+        digits ++;
+    }
+    else
+    {
+      exponent ++;
+
+      if (*ptr != '0')
+        digits ++;
+    }
+  }
+
+  if (*ptr == '.')
+  {
+    for (ptr ++; isdigit(*ptr & 255); ptr ++, found = 1)
+    {
+      if (digits < 19)
+      {
+        if ((mantissa = mantissa * 10 + (unsigned)(*ptr - '0')) > 0)
+          digits ++;
+
+        exponent --;
+      }
+      else if (*ptr != '0')
+        digits ++;
+    }
+  }
+
+  if (!found)
+  {
+    if (end)
+      *end = (char *)s;
+
+    return (0.0);
+  }
+
+  if ((*ptr == 'e' || *ptr == 'E') && (isdigit(ptr[1] & 255) || ((ptr[1] == '-' || ptr[1] == '+') && isdigit(ptr[2] & 255))))
+  {
+    ptr ++;
+
+    if (*ptr == '-')
+    {
+      expsign = -1;
+      ptr ++;
+    }
+    else
+    {
+      expsign = 1;
+
+      if (*ptr == '+')
+        ptr ++;
+    }
+
+    for (exp10 = 0; isdigit(*ptr & 255); ptr ++)
+    {
+      if (exp10 < 100000)
+        exp10 = exp10 * 10 + *ptr - '0';
+    }
+
+    exponent += expsign * exp10;
+  }
+
+  if (end)
+    *end = (char *)ptr;
+
+  if (digits <= 19 && mantissa <= 9007199254740992ULL && exponent >= -22 && exponent <= 22)
+  {
+   /*
+    * Both the mantissa and power of 10 are exact, so a single multiply or
+    * divide gives a correctly rounded result...
+    */
+
+    d = (double)mantissa;
+
+    if (exponent < 0)
+      d /= mxml_pow10[-exponent];
+    else
+      d *= mxml_pow10[exponent];
+
+    return (*start == '-' ? -d : d);
+  }
+
+ /*
+  * Let strtod do the rounding using the locale decimal point...
+  */
+
+  len = (size_t)(ptr - start);
+
+  if (len < (sizeof(temp) - 8))
+    copy = temp;
+  else if ((copy = _mxml_malloc(len + 8)) == NULL)
+    return (strtod(start, NULL));
+
+  memcpy(copy, start, len);
+  copy[len] = '\0';
+
+  mxml_decimal(copy, len + 8, ".", localeconv()->decimal_point);
+
+  d = strtod(copy, NULL);
+
+  if (copy != temp)
+    _mxml_free(copy);
+
+  return (d);
+}
+
+
+/*
+ * '_mxml_strtoll()' - Convert a string to a 64-bit integer.
+ *
+ * Like strtoll with a base of 0, a leading "0x" selects hexadecimal and a
+ * leading "0" selects octal.  Values that do not fit are clamped.
+ */
+
+long long				/* O - Number */
+_mxml_strtoll(const char *s,		/* I - String */
+              char       **end)		/* O - Pointer to end of number or @code NULL@ */
+{
+  const char		*ptr;		/* Pointer into string */
+  int			negative = 0,	/* Negative number? */
+			overflow = 0,	/* Number too large? */
+			base = 10,	/* Number base */
+			digit;		/* Current digit */
+  unsigned long long	number = 0,	/* Number */
+			limit;		/* Largest magnitude */
+
+
+  for (ptr = s; isspace(*ptr & 255); ptr ++);
+
+  if (*ptr == '-')
+  {
+    negative = 1;
+    ptr ++;
+  }
+  else if (*ptr == '+')
+    ptr ++;
+
+  if (ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X') && isxdigit(ptr[2] & 255))
+  {
+    base = 16;
+    ptr  += 2;
+  }
+  else if (ptr[0] == '0')
+    base = 8;
+  else if (!isdigit(*ptr & 255))
+  {
+    if (end)
+      *end = (char *)s;
+
+    return (0);
+  }
+
+  limit = negative ? (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+
+  for (;; ptr ++)
+  {
+    if (isdigit(*ptr & 255))
+      digit = *ptr - '0';
+    else if (isxdigit(*ptr & 255))
+      digit = tolower(*ptr & 255) - 'a' + 10;
+    else
+      break;
+
+    if (digit >= base)
+      break;
+
+    if (number > (limit - (unsigned)digit) / (unsigned)base)
+      overflow = 1;
+    else
+      number = number * (unsigned)base + (unsigned)digit;
+  }
+
+  if (end)
+    *end = (char *)ptr;
+
+  if (overflow)
+    return (negative ? LLONG_MIN : LLONG_MAX);
+  else if (negative)
+    return ((long long)(0 - number));
+  else
+    return ((long long)number);
+}
+
+
 #ifndef HAVE_VSNPRINTF
 /*
  * '_mxml_vsnprintf()' - Format a string into a fixed size buffer.
@@ -507,15 +864,6 @@ char *					/* O - New string pointer */
 _mxml_vstrdupf(const char *format,	/* I - Printf-style format string */
                va_list    ap)		/* I - Pointer to additional arguments */
 {
-#ifdef HAVE_VASPRINTF
-  char		*s;			/* String */
-
-  if (vasprintf(&s, format, ap) < 0)
-    s = NULL;
-
-  return (s);
-
-#else
   int		bytes;			/* Number of bytes required */
   char		*buffer,		/* String buffer */
 		temp[256];		/* Small buffer for first vsnprintf */
@@ -533,13 +881,18 @@ _mxml_vstrdupf(const char *format,	/* I - Printf-style format string */
   va_list	apcopy;			/* Copy of argument list */
 
   va_copy(apcopy, ap);
-  if ((bytes = vsnprintf(temp, sizeof(temp), format, apcopy)) < sizeof(temp))
+  bytes = vsnprintf(temp, sizeof(temp), format, apcopy);
+  va_end(apcopy);
+
+  if (bytes < 0)
+    return (NULL);
+  else if ((size_t)bytes < sizeof(temp))
   {
    /*
     * Hey, the formatted string fits in the tiny buffer, so just dup that...
     */
 
-    return (strdup(temp));
+    return (_mxml_strdup(temp));
   }
 #  endif /* _WIN32 */
 
@@ -547,7 +900,7 @@ _mxml_vstrdupf(const char *format,	/* I - Printf-style format string */
   * Allocate memory for the whole thing and reformat to the new buffer...
   */
 
-  if ((buffer = calloc(1, bytes + 1)) != NULL)
+  if ((buffer = _mxml_calloc(1, bytes + 1)) != NULL)
     vsnprintf(buffer, bytes + 1, format, ap);
 
  /*
@@ -555,5 +908,33 @@ _mxml_vstrdupf(const char *format,	/* I - Printf-style format string */
   */
 
   return (buffer);
-#endif /* HAVE_VASPRINTF */
+}
+
+
+/*
+ * 'mxml_decimal()' - Replace the decimal point in a formatted number.
+ */
+
+static void
+mxml_decimal(char       *s,		/* I - Number string */
+             size_t     slen,		/* I - Size of string buffer */
+             const char *from,		/* I - Decimal point to replace */
+             const char *to)		/* I - New decimal point */
+{
+  char		*ptr;			/* Decimal point in string */
+  size_t	fromlen,		/* Length of old decimal point */
+		tolen;			/* Length of new decimal point */
+
+
+  if (!strcmp(from, to) || (ptr = strstr(s, from)) == NULL)
+    return;
+
+  fromlen = strlen(from);
+  tolen   = strlen(to);
+
+  if (tolen > fromlen && (strlen(s) + tolen - fromlen) >= slen)
+    return;
+
+  memmove(ptr + tolen, ptr + fromlen, strlen(ptr + fromlen) + 1);
+  memcpy(ptr, to, tolen);
 }
@@ -67,6 +67,13 @@
  * Data types...
  */
 
+typedef enum mxml_compress_e		/**** Compression for saved files. @since Mini-XML 3.1@ ****/
+{
+  MXML_COMPRESS_NONE,			/* No compression */
+  MXML_COMPRESS_GZIP,			/* gzip compression */
+  MXML_COMPRESS_ZSTD			/* Zstandard compression */
+} mxml_compress_t;
+
 typedef enum mxml_sax_event_e		/**** SAX event type. ****/
 {
   MXML_SAX_CDATA,			/* CDATA node */
@@ -94,11 +101,44 @@ typedef void (*mxml_custom_destroy_cb_t)(void *);
 typedef void (*mxml_error_cb_t)(const char *);
 					/**** Error callback function ****/
 
+typedef void *(*mxml_malloc_cb_t)(void *, size_t);
+					/**** Memory allocation callback function @since Mini-XML 3.1@ ****/
+
+typedef void *(*mxml_realloc_cb_t)(void *, void *, size_t);
+					/**** Memory reallocation callback function @since Mini-XML 3.1@ ****/
+
+typedef void (*mxml_free_cb_t)(void *, void *);
+					/**** Memory free callback function @since Mini-XML 3.1@ ****/
+
 typedef struct _mxml_node_s mxml_node_t;	/**** An XML node. ****/
 
 typedef struct _mxml_index_s mxml_index_t;
 					/**** An XML node index. ****/
 
+typedef struct _mxml_loader_s mxml_loader_t;
+					/**** A reusable XML loader. @since Mini-XML 3.1@ ****/
+
+typedef struct _mxml_parser_s mxml_parser_t;
+					/**** An XML push parser. @since Mini-XML 3.1@ ****/
+
+typedef enum mxml_reader_event_e	/**** Pull reader event type. @since Mini-XML 3.1@ ****/
+{
+  MXML_READER_ERROR = -1,		/* Error in document */
+  MXML_READER_EOF,			/* End of document */
+  MXML_READER_CDATA,			/* CDATA node */
+  MXML_READER_COMMENT,			/* Comment node */
+  MXML_READER_DATA,			/* Data node */
+  MXML_READER_DIRECTIVE,		/* Processing directive node */
+  MXML_READER_ELEMENT_CLOSE,		/* Element closed */
+  MXML_READER_ELEMENT_OPEN		/* Element opened */
+} mxml_reader_event_t;
+
+typedef struct _mxml_reader_s mxml_reader_t;
+					/**** An XML pull reader. @since Mini-XML 3.1@ ****/
+
+typedef struct _mxml_typemap_s mxml_typemap_t;
+					/**** An element type map for loading. @since Mini-XML 3.1@ ****/
+
 typedef int (*mxml_custom_load_cb_t)(mxml_node_t *, const char *);
 					/**** Custom data load callback function ****/
 
@@ -114,9 +154,15 @@ typedef mxml_type_t (*mxml_load_cb_t)(mxml_node_t *);
 typedef const char *(*mxml_save_cb_t)(mxml_node_t *, int);
 					/**** Save callback function ****/
 
+typedef void (*mxml_record_cb_t)(mxml_node_t *, void *);
+					/**** Record callback function @since Mini-XML 3.1@ ****/
+
 typedef void (*mxml_sax_cb_t)(mxml_node_t *, mxml_sax_event_t, void *);
 					/**** SAX callback function ****/
 
+typedef void (*mxml_sax_view_cb_t)(mxml_sax_event_t, const char *, const char * const *, const char *, size_t, void *);
+					/**** SAX view callback function @since Mini-XML 3.1@ ****/
+
 
 /*
  * C++ support...
@@ -146,6 +192,8 @@ extern void		mxmlElementSetAttrf(mxml_node_t *node, const char *name,
 __attribute__ ((__format__ (__printf__, 3, 4)))
 #    endif /* __GNUC__ */
 ;
+extern int		mxmlElementSetAttrs(mxml_node_t *node, const char * const *names,
+			                    const char * const *values, int num_attrs);
 extern int		mxmlEntityAddCallback(mxml_entity_cb_t cb);
 extern const char	*mxmlEntityGetName(int val);
 extern int		mxmlEntityGetValue(const char *name);
@@ -159,6 +207,7 @@ extern const void	*mxmlGetCustom(mxml_node_t *node);
 extern const char	*mxmlGetElement(mxml_node_t *node);
 extern mxml_node_t	*mxmlGetFirstChild(mxml_node_t *node);
 extern int		mxmlGetInteger(mxml_node_t *node);
+extern long long	mxmlGetInteger64(mxml_node_t *node);
 extern mxml_node_t	*mxmlGetLastChild(mxml_node_t *node);
 extern mxml_node_t	*mxmlGetNextSibling(mxml_node_t *node);
 extern const char	*mxmlGetOpaque(mxml_node_t *node);
@@ -178,17 +227,67 @@ extern int		mxmlIndexGetCount(mxml_index_t *ind);
 extern mxml_index_t	*mxmlIndexNew(mxml_node_t *node, const char *element,
 			              const char *attr);
 extern mxml_node_t	*mxmlIndexReset(mxml_index_t *ind);
+extern int		mxmlLoadBatch(const char * const *filenames,
+			              int num_files,
+			              mxml_type_t (*cb)(mxml_node_t *),
+			              int threads, mxml_node_t **trees,
+			              char **errors);
+extern mxml_node_t	*mxmlLoadBuffer(mxml_node_t *top, const void *data,
+			                size_t len, mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoadBufferParallel(mxml_node_t *top, const void *data,
+			                        size_t len,
+			                        mxml_type_t (*cb)(mxml_node_t *),
+			                        int threads);
 extern mxml_node_t	*mxmlLoadFd(mxml_node_t *top, int fd,
 			            mxml_type_t (*cb)(mxml_node_t *));
 extern mxml_node_t	*mxmlLoadFile(mxml_node_t *top, FILE *fp,
 			              mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoadPath(mxml_node_t *top, const char *filename,
+			              mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoadPathParallel(mxml_node_t *top, const char *filename,
+			                      mxml_type_t (*cb)(mxml_node_t *),
+			                      int threads);
+extern int		mxmlLoadRecordsBuffer(const void *data, size_t len,
+			                      const char *name,
+			                      mxml_type_t (*cb)(mxml_node_t *),
+			                      mxml_record_cb_t record_cb,
+			                      void *record_data);
+extern int		mxmlLoadRecordsFd(int fd, const char *name,
+			                  mxml_type_t (*cb)(mxml_node_t *),
+			                  mxml_record_cb_t record_cb,
+			                  void *record_data);
+extern int		mxmlLoadRecordsFile(FILE *fp, const char *name,
+			                    mxml_type_t (*cb)(mxml_node_t *),
+			                    mxml_record_cb_t record_cb,
+			                    void *record_data);
+extern int		mxmlLoadRecordsString(const char *s, const char *name,
+			                      mxml_type_t (*cb)(mxml_node_t *),
+			                      mxml_record_cb_t record_cb,
+			                      void *record_data);
 extern mxml_node_t	*mxmlLoadString(mxml_node_t *top, const char *s,
 			                mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoadStringInPlace(mxml_node_t *top, char *s,
+			                       mxml_type_t (*cb)(mxml_node_t *));
+extern void		mxmlLoaderDelete(mxml_loader_t *loader);
+extern mxml_node_t	*mxmlLoaderLoadBuffer(mxml_loader_t *loader, mxml_node_t *top,
+			                      const void *data, size_t len,
+			                      mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoaderLoadFd(mxml_loader_t *loader, mxml_node_t *top,
+			                  int fd, mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoaderLoadFile(mxml_loader_t *loader, mxml_node_t *top,
+			                    FILE *fp, mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoaderLoadString(mxml_loader_t *loader, mxml_node_t *top,
+			                      const char *s,
+			                      mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_loader_t	*mxmlLoaderNew(void);
+extern void		mxmlLoaderSetArena(mxml_loader_t *loader, int arena);
+extern void		mxmlLoaderSetTypeMap(mxml_loader_t *loader, mxml_typemap_t *map);
 extern mxml_node_t	*mxmlNewCDATA(mxml_node_t *parent, const char *string);
 extern mxml_node_t	*mxmlNewCustom(mxml_node_t *parent, void *data,
 			               mxml_custom_destroy_cb_t destroy);
 extern mxml_node_t	*mxmlNewElement(mxml_node_t *parent, const char *name);
 extern mxml_node_t	*mxmlNewInteger(mxml_node_t *parent, int integer);
+extern mxml_node_t	*mxmlNewInteger64(mxml_node_t *parent, long long integer);
 extern mxml_node_t	*mxmlNewOpaque(mxml_node_t *parent, const char *opaque);
 extern mxml_node_t	*mxmlNewOpaquef(mxml_node_t *parent, const char *format, ...)
 #    ifdef __GNUC__
@@ -203,6 +302,27 @@ __attribute__ ((__format__ (__printf__, 3, 4)))
 #    endif /* __GNUC__ */
 ;
 extern mxml_node_t	*mxmlNewXML(const char *version);
+extern mxml_node_t	*mxmlNewXMLArena(const char *version);
+extern void		mxmlParserDelete(mxml_parser_t *parser);
+extern int		mxmlParserFeed(mxml_parser_t *parser, const void *data,
+			               size_t bytes);
+extern mxml_node_t	*mxmlParserFinish(mxml_parser_t *parser);
+extern mxml_parser_t	*mxmlParserNew(mxml_node_t *top,
+			               mxml_type_t (*cb)(mxml_node_t *));
+extern void		mxmlReaderDelete(mxml_reader_t *reader);
+extern const char	*mxmlReaderGetAttr(mxml_reader_t *reader, const char *name);
+extern const char	*mxmlReaderGetAttrByIndex(mxml_reader_t *reader, int idx,
+			                          const char **name);
+extern int		mxmlReaderGetAttrCount(mxml_reader_t *reader);
+extern int		mxmlReaderGetDepth(mxml_reader_t *reader);
+extern const char	*mxmlReaderGetName(mxml_reader_t *reader);
+extern const char	*mxmlReaderGetText(mxml_reader_t *reader);
+extern mxml_reader_t	*mxmlReaderNewBuffer(const void *data, size_t len);
+extern mxml_reader_t	*mxmlReaderNewFd(int fd);
+extern mxml_reader_t	*mxmlReaderNewFile(FILE *fp);
+extern mxml_reader_t	*mxmlReaderNewString(const char *s);
+extern mxml_reader_event_t mxmlReaderNext(mxml_reader_t *reader);
+extern mxml_reader_event_t mxmlReaderSkip(mxml_reader_t *reader);
 extern int		mxmlRelease(mxml_node_t *node);
 extern void		mxmlRemove(mxml_node_t *node);
 extern int		mxmlRetain(mxml_node_t *node);
@@ -214,16 +334,37 @@ extern int		mxmlSaveFile(mxml_node_t *node, FILE *fp,
 			             mxml_save_cb_t cb);
 extern int		mxmlSaveString(mxml_node_t *node, char *buffer,
 			               int bufsize, mxml_save_cb_t cb);
+extern mxml_node_t	*mxmlSAXLoadBuffer(mxml_node_t *top, const void *data,
+			                   size_t len, mxml_type_t (*cb)(mxml_node_t *),
+			                   mxml_sax_cb_t sax, void *sax_data);
 extern mxml_node_t	*mxmlSAXLoadFd(mxml_node_t *top, int fd,
 			               mxml_type_t (*cb)(mxml_node_t *),
 			               mxml_sax_cb_t sax, void *sax_data);
 extern mxml_node_t	*mxmlSAXLoadFile(mxml_node_t *top, FILE *fp,
 			                 mxml_type_t (*cb)(mxml_node_t *),
 			                 mxml_sax_cb_t sax, void *sax_data);
+extern mxml_node_t	*mxmlSAXLoadPath(mxml_node_t *top, const char *filename,
+			                 mxml_type_t (*cb)(mxml_node_t *),
+			                 mxml_sax_cb_t sax, void *sax_data);
 extern mxml_node_t	*mxmlSAXLoadString(mxml_node_t *top, const char *s,
 			                   mxml_type_t (*cb)(mxml_node_t *),
 			                   mxml_sax_cb_t sax, void *sax_data);
+extern mxml_parser_t	*mxmlSAXParserNew(mxml_node_t *top,
+			                  mxml_type_t (*cb)(mxml_node_t *),
+			                  mxml_sax_cb_t sax, void *sax_data);
+extern int		mxmlSAXViewLoadBuffer(const void *data, size_t len,
+			                      mxml_sax_view_cb_t cb, void *cb_data);
+extern int		mxmlSAXViewLoadFd(int fd, mxml_sax_view_cb_t cb,
+			                  void *cb_data);
+extern int		mxmlSAXViewLoadFile(FILE *fp, mxml_sax_view_cb_t cb,
+			                    void *cb_data);
+extern int		mxmlSAXViewLoadString(const char *s, mxml_sax_view_cb_t cb,
+			                      void *cb_data);
+extern int		mxmlSetAllocator(mxml_malloc_cb_t malloc_cb,
+			                 mxml_realloc_cb_t realloc_cb,
+			                 mxml_free_cb_t free_cb, void *ctx);
 extern int		mxmlSetCDATA(mxml_node_t *node, const char *data);
+extern int		mxmlSetCompression(mxml_compress_t compression);
 extern int		mxmlSetCustom(mxml_node_t *node, void *data,
 			              mxml_custom_destroy_cb_t destroy);
 extern void		mxmlSetCustomHandlers(mxml_custom_load_cb_t load,
@@ -231,6 +372,7 @@ extern void		mxmlSetCustomHandlers(mxml_custom_load_cb_t load,
 extern int		mxmlSetElement(mxml_node_t *node, const char *name);
 extern void		mxmlSetErrorCallback(mxml_error_cb_t cb);
 extern int		mxmlSetInteger(mxml_node_t *node, int integer);
+extern int		mxmlSetInteger64(mxml_node_t *node, long long integer);
 extern int		mxmlSetOpaque(mxml_node_t *node, const char *opaque);
 extern int		mxmlSetOpaquef(mxml_node_t *node, const char *format, ...)
 #    ifdef __GNUC__
@@ -248,6 +390,9 @@ __attribute__ ((__format__ (__printf__, 3, 4)))
 ;
 extern int		mxmlSetUserData(mxml_node_t *node, void *data);
 extern void		mxmlSetWrapMargin(int column);
+extern int		mxmlTypeMapAdd(mxml_typemap_t *map, const char *name, mxml_type_t type);
+extern void		mxmlTypeMapDelete(mxml_typemap_t *map);
+extern mxml_typemap_t	*mxmlTypeMapNew(const char *attr);
 extern mxml_node_t	*mxmlWalkNext(mxml_node_t *node, mxml_node_t *top,
 			              int descend);
 extern mxml_node_t	*mxmlWalkPrev(mxml_node_t *node, mxml_node_t *top,
@@ -24,6 +24,10 @@
 #  include <unistd.h>
 #endif /* !_WIN32 */
 #include <fcntl.h>
+#include <float.h>
+#ifdef HAVE_PTHREAD_H
+#  include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
 #ifndef O_BINARY
 #  define O_BINARY 0
 #endif /* !O_BINARY */
@@ -34,13 +38,29 @@
  */
 
 int		event_counts[6];
+int		view_counts[6],
+		view_attrs;
+mxml_node_t	*kept_record;
+int		alloc_inuse = 0;	/* Blocks allocated by Mini-XML */
+char		last_error[1024];	/* Last error message */
+#ifdef HAVE_PTHREAD_H
+pthread_mutex_t	alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+					/* Lock for blocks in use */
+#endif /* HAVE_PTHREAD_H */
 
 
 /*
  * Local functions...
  */
 
+void		alloc_count(int *inuse, int delta);
+void		alloc_free_cb(void *ctx, void *ptr);
+void		error_cb(const char *message);
+void		*alloc_malloc_cb(void *ctx, size_t size);
+void		*alloc_realloc_cb(void *ctx, void *ptr, size_t size);
 void		sax_cb(mxml_node_t *node, mxml_sax_event_t event, void *data);
+void		record_cb(mxml_node_t *node, void *data);
+void		sax_view_cb(mxml_sax_event_t event, const char *name, const char * const *attrs, const char *text, size_t textlen, void *data);
 mxml_type_t	type_cb(mxml_node_t *node);
 const char	*whitespace_cb(mxml_node_t *node, int where);
 
@@ -59,7 +79,10 @@ main(int  argc,				/* I - Number of command-line args */
   mxml_node_t		*tree,		/* XML tree */
 			*node;		/* Node which should be in test.xml */
   mxml_index_t		*ind;		/* XML index */
+  mxml_parser_t		*parser;	/* Push parser */
   char			buffer[16384];	/* Save string */
+  const char		*value,		/* Attribute value */
+			*name;		/* Attribute name */
   static const char	*types[] =	/* Strings for node types */
 			{
 			  "MXML_ELEMENT",
@@ -80,6 +103,17 @@ main(int  argc,				/* I - Number of command-line args */
     return (1);
   }
 
+ /*
+  * Count the blocks that Mini-XML allocates.  The allocation functions can
+  * only be set before Mini-XML allocates any memory...
+  */
+
+  if (mxmlSetAllocator(alloc_malloc_cb, alloc_realloc_cb, alloc_free_cb, &alloc_inuse))
+  {
+    fputs("mxmlSetAllocator failed before any memory was allocated.\n", stderr);
+    return (1);
+  }
+
  /*
   * Test the basic functionality...
   */
@@ -114,6 +148,150 @@ main(int  argc,				/* I - Number of command-line args */
   mxmlNewReal(tree, 123.4f);
   mxmlNewText(tree, 1, "text");
 
+ /*
+  * Test reference counts and user data, which are kept outside the node...
+  */
+
+  mxmlSetUserData(tree->child, tree);
+  mxmlRetain(tree->last_child);
+
+  if (mxmlGetUserData(tree->child) != tree || mxmlGetUserData(tree->last_child) || mxmlGetRefCount(tree->child) != 1 || mxmlGetRefCount(tree->last_child) != 2)
+  {
+    fputs("ERROR: Bad user data or reference count for new nodes.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlSetUserData(tree->child, NULL);
+
+  if (mxmlRelease(tree->last_child) != 1 || (tree->child->flags | tree->last_child->flags) & _MXML_NODE_EXTRA)
+  {
+    fputs("ERROR: Side table entries not removed for new nodes.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+ /*
+  * Test short attribute values, which are stored in the attribute...
+  */
+
+  mxmlElementSetAttr(tree, "a", "short");
+  mxmlElementSetAttr(tree, "b", "a value that is too long to store in the attribute");
+  mxmlElementSetAttr(tree, "c", "c");
+  mxmlElementDeleteAttr(tree, "a");
+  mxmlElementSetAttr(tree, "c", mxmlElementGetAttr(tree, "c"));
+  mxmlElementSetAttrf(tree, "d", "%d", 42);
+
+  if ((value = mxmlElementGetAttr(tree, "c")) == NULL || strcmp(value, "c") || (value = mxmlElementGetAttr(tree, "d")) == NULL || strcmp(value, "42") || mxmlElementGetAttrCount(tree) != 3)
+  {
+    fputs("ERROR: Bad short attribute values after changes.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlElementDeleteAttr(tree, "b");
+  mxmlElementDeleteAttr(tree, "c");
+  mxmlElementDeleteAttr(tree, "d");
+
+ /*
+  * Test that attribute values stay in place when other attributes are added,
+  * both when copying a value to a new attribute and when keeping a pointer...
+  */
+
+  mxmlElementSetAttr(tree, "a", "x");
+  mxmlElementSetAttr(tree, "b", mxmlElementGetAttr(tree, "a"));
+
+  value = mxmlElementGetAttr(tree, "b");
+  mxmlElementSetAttr(tree, "c", "c");
+  mxmlElementSetAttr(tree, "d", "d");
+  mxmlElementSetAttr(tree, "e", "e");
+  mxmlElementDeleteAttr(tree, "a");
+
+  if (!value || strcmp(value, "x") || (value = mxmlElementGetAttrByIndex(tree, 0, &name)) == NULL || strcmp(name, "b") || strcmp(value, "x"))
+  {
+    fputs("ERROR: Bad attribute value after adding other attributes.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  {
+    const char	*names[4],		/* Attribute names */
+		*values[4];		/* Attribute values */
+
+    mxmlElementSetAttr(tree, "f", "a value that is too long to store with the name");
+
+    value     = mxmlElementGetAttr(tree, "c");
+    names[0]  = "g";
+    values[0] = value;
+    names[1]  = "h";
+    values[1] = "h";
+    names[2]  = "i";
+    values[2] = mxmlElementGetAttr(tree, "f");
+    names[3]  = "j";
+    values[3] = "j";
+
+    mxmlElementSetAttrs(tree, names, values, 4);
+
+    if (strcmp(value, "c") || (value = mxmlElementGetAttr(tree, "g")) == NULL || strcmp(value, "c") || (value = mxmlElementGetAttr(tree, "i")) == NULL || strcmp(value, values[2]) || mxmlElementGetAttrCount(tree) != 9)
+    {
+      fputs("ERROR: Bad attribute value after setting several attributes.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+  }
+
+  while (mxmlElementGetAttrCount(tree) > 0)
+  {
+    mxmlElementGetAttrByIndex(tree, 0, &name);
+    mxmlElementDeleteAttr(tree, name);
+  }
+
+ /*
+  * Test setting several attributes at once and loading an element with many
+  * attributes...
+  */
+
+  {
+    static const char * const names[] = { "a", "b", "a", "c" };
+    static const char * const values[] = { "1", "two", "3", "a value that is too long to store in the attribute" };
+
+    mxmlElementSetAttr(tree, "c", "old");
+
+    if (mxmlElementSetAttrs(tree, names, values, 4) || mxmlElementGetAttrCount(tree) != 3 || strcmp(mxmlElementGetAttrByIndex(tree, 0, &value), "a value that is too long to store in the attribute") || strcmp(value, "c") || strcmp(mxmlElementGetAttr(tree, "a"), "3") || strcmp(mxmlElementGetAttr(tree, "b"), "two") || !mxmlElementSetAttrs(tree, names, NULL, -1))
+    {
+      fputs("ERROR: Bad attributes from mxmlElementSetAttrs.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    mxmlElementDeleteAttr(tree, "a");
+    mxmlElementDeleteAttr(tree, "b");
+    mxmlElementDeleteAttr(tree, "c");
+  }
+
+  node = mxmlLoadString(NULL, "<many a0='0' a1='1' a2='2' a3='3' a4='4' a5='5' a6='6' a7='7' a8='8' a9='9' a10='10' a11='11' a12='12' a13='13' a14='14' a15='15' a16='16' a17='17' a18='18' a19='19'/>", MXML_NO_CALLBACK);
+
+  for (i = 0; i < 20; i ++)
+  {
+    char	aname[8];		/* Expected attribute name */
+
+    snprintf(aname, sizeof(aname), "a%d", i);
+    if (!node || (value = mxmlElementGetAttrByIndex(node, i, &name)) == NULL || strcmp(name, aname) || atoi(value) != i)
+      break;
+  }
+
+  mxmlElementSetAttr(node, "a20", "20");
+
+  if (i < 20 || mxmlElementGetAttrCount(node) != 21)
+  {
+    fputs("ERROR: Bad attributes for element with many attributes.\n", stderr);
+    mxmlDelete(node);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlDelete(node);
+
   mxmlLoadString(tree, "<group type='string'>string string string</group>",
                  MXML_NO_CALLBACK);
   mxmlLoadString(tree, "<group type='integer'>1 2 3</group>",
@@ -161,7 +339,7 @@ main(int  argc,				/* I - Number of command-line args */
 
   if (node->value.integer != 123)
   {
-    fprintf(stderr, "ERROR: First child value is %d, expected 123.\n",
+    fprintf(stderr, "ERROR: First child value is %lld, expected 123.\n",
             node->value.integer);
     mxmlDelete(tree);
     return (1);
@@ -462,261 +640,1531 @@ main(int  argc,				/* I - Number of command-line args */
   mxmlDelete(tree);
 
  /*
-  * Open the file/string using the default (MXML_NO_CALLBACK) callback...
+  * Test decoding predefined, HTML, and numeric entities...
   */
 
-  if (argv[1][0] == '<')
-    tree = mxmlLoadString(NULL, argv[1], MXML_NO_CALLBACK);
-  else if ((fp = fopen(argv[1], "rb")) == NULL)
+  if ((tree = mxmlLoadString(NULL, "<e a=\"&apos;&quot;&lt;&gt;&amp;&AElig;&zwnj;&eacute;&#233;&#xe9;\"/>", MXML_OPAQUE_CALLBACK)) == NULL)
   {
-    perror(argv[1]);
+    fputs("ERROR: Unable to load string with entities.\n", stderr);
     return (1);
   }
-  else
+
+  if (strcmp(mxmlElementGetAttr(tree, "a"), "'\"<>&\303\206\342\200\214\303\251\303\251\303\251"))
   {
-   /*
-    * Read the file...
-    */
+    fprintf(stderr, "ERROR: Bad entity values \"%s\".\n", mxmlElementGetAttr(tree, "a"));
+    mxmlDelete(tree);
+    return (1);
+  }
 
-    tree = mxmlLoadFile(NULL, fp, MXML_NO_CALLBACK);
+  mxmlDelete(tree);
 
-    fclose(fp);
+ /*
+  * Test loading long runs of non-ASCII characters, which are checked for
+  * valid UTF-8 in blocks...
+  */
+
+  if ((tree = mxmlLoadString(NULL, "<\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277 a=\"\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\360\235\204\236\">\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254 x</\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277>", MXML_OPAQUE_CALLBACK)) == NULL)
+  {
+    fputs("ERROR: Unable to load string with non-ASCII characters.\n", stderr);
+    return (1);
   }
 
-  if (!tree)
+  if (strcmp(mxmlGetElement(tree), "\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277\316\272\316\265\316\257\316\274\316\265\316\275\316\277") ||
+      strcmp(mxmlElementGetAttr(tree, "a"), "\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\303\274\360\235\204\236") ||
+      strcmp(mxmlGetOpaque(mxmlGetFirstChild(tree)), "\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254 x"))
   {
-    fputs("Unable to read XML file with default callback.\n", stderr);
+    fputs("ERROR: Bad non-ASCII name or values.\n", stderr);
+    mxmlDelete(tree);
     return (1);
   }
 
-  if (!strcmp(argv[1], "test.xml"))
+  mxmlDelete(tree);
+
+  if ((tree = mxmlLoadString(NULL, "<a>\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\342\202\254\001</a>", MXML_OPAQUE_CALLBACK)) != NULL)
   {
-    const char	*text;			/* Text value */
+    fputs("ERROR: Control character after non-ASCII text not rejected.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
 
-   /*
-    * Verify that mxmlFindElement() and indirectly mxmlWalkNext() work
-    * properly...
-    */
+ /*
+  * Test that invalid UTF-8 is reported with its line number, both when
+  * loading a tree and when reading events...
+  */
 
-    if ((node = mxmlFindPath(tree, "group/option/keyword")) == NULL)
-    {
-      fputs("Unable to find group/option/keyword element in XML tree.\n", stderr);
-      mxmlDelete(tree);
-      return (1);
-    }
+  {
+    mxml_reader_t	*reader;	/* Pull reader */
+    mxml_reader_event_t	event;		/* Reader event */
 
-    if (node->type != MXML_TEXT)
+    mxmlSetErrorCallback(error_cb);
+
+    last_error[0] = '\0';
+    tree          = mxmlLoadString(NULL, "<r>\nab\377<x/>cd</r>", MXML_OPAQUE_CALLBACK);
+
+    if (tree || !strstr(last_error, "Invalid UTF-8 sequence") || !strstr(last_error, "on line 2"))
     {
-      fputs("No child node of group/option/keyword.\n", stderr);
-      mxmlSaveFile(tree, stderr, MXML_NO_CALLBACK);
+      fprintf(stderr, "ERROR: Invalid UTF-8 text not reported (got \"%s\").\n", last_error);
       mxmlDelete(tree);
       return (1);
     }
 
-    if ((text = mxmlGetText(node, NULL)) == NULL || strcmp(text, "InputSlot"))
+    last_error[0] = '\0';
+
+    if ((reader = mxmlReaderNewString("<r>ab\377<x/>cd</r>")) != NULL)
     {
-      fprintf(stderr, "Child node of group/option/value has value \"%s\" instead of \"InputSlot\".\n", text ? text : "(null)");
-      mxmlDelete(tree);
-      return (1);
-    }
-  }
+      while ((event = mxmlReaderNext(reader)) != MXML_READER_EOF && event != MXML_READER_ERROR);
 
-  mxmlDelete(tree);
+      mxmlReaderDelete(reader);
 
- /*
-  * Open the file...
-  */
+      if (event != MXML_READER_ERROR || !strstr(last_error, "Invalid UTF-8 sequence"))
+      {
+        fprintf(stderr, "ERROR: Invalid UTF-8 text not reported by reader (got \"%s\").\n", last_error);
+        return (1);
+      }
+    }
 
-  if (argv[1][0] == '<')
-    tree = mxmlLoadString(NULL, argv[1], type_cb);
-  else if ((fp = fopen(argv[1], "rb")) == NULL)
-  {
-    perror(argv[1]);
-    return (1);
-  }
-  else
-  {
    /*
-    * Read the file...
+    * A bad sequence inside a quoted attribute value must fail the load
+    * rather than end the value...
     */
 
-    tree = mxmlLoadFile(NULL, fp, type_cb);
-
-    fclose(fp);
-  }
+    if ((tree = mxmlLoadString(NULL, "<r><a k='x\303'/><b/></r>", MXML_OPAQUE_CALLBACK)) != NULL ||
+        (tree = mxmlLoadString(NULL, "<r a=\"\377\"/>", MXML_OPAQUE_CALLBACK)) != NULL)
+    {
+      fputs("ERROR: Invalid UTF-8 attribute value not reported.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
 
-  if (!tree)
-  {
-    fputs("Unable to read XML file.\n", stderr);
-    return (1);
-  }
+    if ((reader = mxmlReaderNewString("<r><a k='x\303'/><b/></r>")) != NULL)
+    {
+      while ((event = mxmlReaderNext(reader)) != MXML_READER_EOF && event != MXML_READER_ERROR)
+      {
+        if (event == MXML_READER_ELEMENT_OPEN && !strcmp(mxmlReaderGetName(reader), "a"))
+          break;
+      }
+
+      mxmlReaderDelete(reader);
+
+      if (event != MXML_READER_ERROR)
+      {
+        fputs("ERROR: Invalid UTF-8 attribute value not reported by reader.\n", stderr);
+        return (1);
+      }
+    }
 
-  if (!strcmp(argv[1], "test.xml"))
-  {
    /*
-    * Verify that mxmlFindElement() and indirectly mxmlWalkNext() work
-    * properly...
+    * A nul byte in a buffer is reported like other loader errors, and a bad
+    * character after the root element ends the input without failing the
+    * load...
     */
 
-    if ((node = mxmlFindElement(tree, tree, "choice", NULL, NULL,
-                                MXML_DESCEND)) == NULL)
+    last_error[0] = '\0';
+
+    if ((tree = mxmlLoadBuffer(NULL, "<r>\na\0b</r>", 10, MXML_OPAQUE_CALLBACK)) != NULL || !strstr(last_error, "under parent <r> on line 2"))
     {
-      fputs("Unable to find first <choice> element in XML tree.\n", stderr);
+      fprintf(stderr, "ERROR: Nul byte in buffer not reported (got \"%s\").\n", last_error);
       mxmlDelete(tree);
       return (1);
     }
 
-    if (!mxmlFindElement(node, tree, "choice", NULL, NULL, MXML_NO_DESCEND))
+    if ((tree = mxmlLoadString(NULL, "<r>a</r>\n\377", MXML_OPAQUE_CALLBACK)) == NULL)
     {
-      fputs("Unable to find second <choice> element in XML tree.\n", stderr);
-      mxmlDelete(tree);
+      fputs("ERROR: Bad character after root element failed the load.\n", stderr);
       return (1);
     }
-  }
 
- /*
-  * Print the XML tree...
-  */
+    mxmlDelete(tree);
 
-  mxmlSaveFile(tree, stdout, whitespace_cb);
+    mxmlSetErrorCallback(NULL);
+  }
 
  /*
-  * Save the XML tree to a string and print it...
+  * Test a UTF-16 string with an odd number of bytes, which must not be read
+  * past its nul byte...
   */
 
-  if (mxmlSaveString(tree, buffer, sizeof(buffer), whitespace_cb) > 0)
   {
-    if (argc == 3)
+    char	*odd;			/* Odd-length UTF-16 string */
+
+    if ((odd = malloc(4)) != NULL)
     {
-      fp = fopen(argv[2], "w");
-      fputs(buffer, fp);
-      fclose(fp);
+      memcpy(odd, "\377\376<", 4);
+      tree = mxmlLoadString(NULL, odd, MXML_OPAQUE_CALLBACK);
+      free(odd);
+
+      if (tree)
+      {
+        fputs("ERROR: Odd-length UTF-16 string not rejected.\n", stderr);
+        mxmlDelete(tree);
+        return (1);
+      }
     }
   }
 
  /*
-  * Delete the tree...
+  * Test 64-bit integers and saving real numbers with the shortest string that
+  * reads back as the same value...
   */
 
-  mxmlDelete(tree);
+  if ((tree = mxmlLoadString(NULL, "<i>9007199254740993 -9223372036854775808 0x7fffffffffffffff 99999999999999999999</i>", MXML_INTEGER_CALLBACK)) == NULL)
+  {
+    fputs("ERROR: Unable to load string with 64-bit integers.\n", stderr);
+    return (1);
+  }
 
- /*
-  * Read from/write to file descriptors...
-  */
+  node = mxmlGetFirstChild(tree);
 
-  if (argv[1][0] != '<')
+  if (mxmlGetInteger64(node) != 9007199254740993LL ||
+      mxmlGetInteger64(mxmlGetNextSibling(node)) != (-9223372036854775807LL - 1) ||
+      mxmlGetInteger64(mxmlGetNextSibling(mxmlGetNextSibling(node))) != 9223372036854775807LL ||
+      mxmlGetInteger64(mxmlGetLastChild(tree)) != 9223372036854775807LL)
   {
-   /*
-    * Open the file again...
-    */
+    fputs("ERROR: Bad 64-bit integer values.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
 
-    if ((fd = open(argv[1], O_RDONLY | O_BINARY)) < 0)
-    {
-      perror(argv[1]);
-      return (1);
-    }
+  mxmlSaveString(tree, buffer, sizeof(buffer), MXML_NO_CALLBACK);
+  mxmlDelete(tree);
 
-   /*
-    * Read the file...
-    */
+  if (strcmp(buffer, "<i>9007199254740993 -9223372036854775808 9223372036854775807 9223372036854775807</i>\n"))
+  {
+    fprintf(stderr, "ERROR: Bad saved 64-bit integers \"%s\".\n", buffer);
+    return (1);
+  }
 
-    tree = mxmlLoadFd(NULL, fd, type_cb);
+  {
+    static const double	reals[] =	/* Real numbers to save */
+    {
+      0.1, 123.4f, 1e300, -2.5, 1.0 / 3.0, 1e23, 5e-324, 155173.8416,
+      1.039491034, -0.0, 100.0, 0.1 + 0.2, 1.0 + DBL_EPSILON,
+      123456789012345678.0
+    };
 
-    close(fd);
+    tree = mxmlNewElement(MXML_NO_PARENT, "r");
 
-   /*
-    * Create filename.xmlfd...
-    */
+    for (i = 0; i < (int)(sizeof(reals) / sizeof(reals[0])); i ++)
+      mxmlNewReal(tree, reals[i]);
 
-    snprintf(buffer, sizeof(buffer), "%sfd", argv[1]);
+    mxmlSaveString(tree, buffer, sizeof(buffer), MXML_NO_CALLBACK);
+    mxmlDelete(tree);
 
-    if ((fd = open(buffer, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666)) < 0)
+    if (strcmp(buffer, "<r>0.1 123.4000015258789 1e+300 -2.5 0.3333333333333333 1e+23 5e-324 155173.8416\n1.039491034 -0 100 0.30000000000000004 1.0000000000000002 1.2345678901234568e+17</r>\n"))
     {
-      perror(buffer);
-      mxmlDelete(tree);
+      fprintf(stderr, "ERROR: Bad saved real numbers \"%s\".\n", buffer);
       return (1);
     }
 
-   /*
-    * Write the file...
-    */
-
-    mxmlSaveFd(tree, fd, whitespace_cb);
-
-    close(fd);
+    if ((tree = mxmlLoadString(NULL, buffer, MXML_REAL_CALLBACK)) == NULL)
+    {
+      fputs("ERROR: Unable to load saved real numbers.\n", stderr);
+      return (1);
+    }
 
-   /*
-    * Delete the tree...
-    */
+    for (i = 0, node = mxmlGetFirstChild(tree); node; i ++, node = mxmlGetNextSibling(node))
+    {
+      if (i >= (int)(sizeof(reals) / sizeof(reals[0])) || mxmlGetReal(node) != reals[i])
+      {
+        fprintf(stderr, "ERROR: Real number %d read back as %.17g.\n", i + 1, mxmlGetReal(node));
+        mxmlDelete(tree);
+        return (1);
+      }
+    }
 
     mxmlDelete(tree);
   }
 
  /*
-  * Test SAX methods...
+  * Test loading a string in place...
   */
 
-  memset(event_counts, 0, sizeof(event_counts));
+  strlcpy(buffer, "<?xml version=\"1.0\"?><group a=\"1&amp;2\" b=\"three\">"
+                  "<value>x &lt; y</value><empty/></group>", sizeof(buffer));
 
-  if (argv[1][0] == '<')
-    mxmlSAXLoadString(NULL, argv[1], type_cb, sax_cb, NULL);
-  else if ((fp = fopen(argv[1], "rb")) == NULL)
+  if ((tree = mxmlLoadStringInPlace(NULL, buffer, MXML_OPAQUE_CALLBACK)) == NULL)
   {
-    perror(argv[1]);
+    fputs("ERROR: Unable to load string in place.\n", stderr);
     return (1);
   }
-  else
+
+  if ((node = mxmlFindElement(tree, tree, "group", NULL, NULL, MXML_DESCEND)) == NULL)
   {
-   /*
-    * Read the file...
+    fputs("ERROR: No group element in string loaded in place.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  if (strcmp(mxmlElementGetAttr(node, "a"), "1&2") || strcmp(mxmlElementGetAttr(node, "b"), "three"))
+  {
+    fprintf(stderr, "ERROR: Bad attributes a=\"%s\" b=\"%s\" in string loaded in place.\n", mxmlElementGetAttr(node, "a"), mxmlElementGetAttr(node, "b"));
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlElementSetAttr(node, "b", "four");
+  mxmlElementDeleteAttr(node, "a");
+
+  if (mxmlElementGetAttrCount(node) != 1 || strcmp(mxmlElementGetAttr(node, "b"), "four"))
+  {
+    fputs("ERROR: Unable to change attributes in string loaded in place.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  if ((node = mxmlFindPath(tree, "group/value")) == NULL || mxmlGetType(node) != MXML_OPAQUE || strcmp(mxmlGetOpaque(node), "x < y"))
+  {
+    fputs("ERROR: Bad value in string loaded in place.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlSetOpaque(node, "x > y");
+
+  if (strcmp(mxmlGetOpaque(node), "x > y"))
+  {
+    fputs("ERROR: Unable to change value in string loaded in place.\n", stderr);
+    mxmlDelete(tree);
+    return (1);
+  }
+
+  mxmlDelete(tree);
+
+ /*
+  * Test loading length-bounded buffers...
+  */
+
+  {
+    static const char utf8data[] = "<group><value>123</value></group>garbage";
+    static const unsigned char utf16data[] =
+    {
+      0xff, 0xfe, '<', 0, 'a', 0, '>', 0, 0xb5, 0x03, '<', 0, '/', 0, 'a', 0, '>', 0
+    };
+
+    if ((tree = mxmlLoadBuffer(NULL, utf8data, 33, MXML_INTEGER_CALLBACK)) == NULL)
+    {
+      fputs("ERROR: Unable to load UTF-8 buffer.\n", stderr);
+      return (1);
+    }
+
+    if ((node = mxmlFindPath(tree, "value")) == NULL || mxmlGetInteger(node) != 123)
+    {
+      fputs("ERROR: Bad value in UTF-8 buffer.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    mxmlDelete(tree);
+
+    if ((tree = mxmlLoadBuffer(NULL, utf16data, sizeof(utf16data), MXML_OPAQUE_CALLBACK)) == NULL)
+    {
+      fputs("ERROR: Unable to load UTF-16 buffer.\n", stderr);
+      return (1);
+    }
+
+    if ((node = mxmlGetFirstChild(tree)) == NULL || mxmlGetType(node) != MXML_OPAQUE || strcmp(mxmlGetOpaque(node), "\xce\xb5"))
+    {
+      fputs("ERROR: Bad value in UTF-16 buffer.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    mxmlDelete(tree);
+
+   /*
+    * Same thing with a push parser, splitting the BOM and characters...
+    */
+
+    if ((parser = mxmlParserNew(NULL, MXML_OPAQUE_CALLBACK)) == NULL)
+    {
+      fputs("ERROR: Unable to create push parser.\n", stderr);
+      return (1);
+    }
+
+    for (i = 0; i < (int)sizeof(utf16data); i ++)
+      mxmlParserFeed(parser, utf16data + i, 1);
+
+    tree = mxmlParserFinish(parser);
+
+    mxmlParserDelete(parser);
+
+    if (!tree || (node = mxmlGetFirstChild(tree)) == NULL || mxmlGetType(node) != MXML_OPAQUE || strcmp(mxmlGetOpaque(node), "\xce\xb5"))
+    {
+      fputs("ERROR: Bad value in UTF-16 push parser data.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    mxmlDelete(tree);
+  }
+
+ /*
+  * Open the file/string using the default (MXML_NO_CALLBACK) callback...
+  */
+
+  if (argv[1][0] == '<')
+    tree = mxmlLoadString(NULL, argv[1], MXML_NO_CALLBACK);
+  else if ((fp = fopen(argv[1], "rb")) == NULL)
+  {
+    perror(argv[1]);
+    return (1);
+  }
+  else
+  {
+   /*
+    * Read the file...
+    */
+
+    tree = mxmlLoadFile(NULL, fp, MXML_NO_CALLBACK);
+
+    fclose(fp);
+  }
+
+  if (!tree)
+  {
+    fputs("Unable to read XML file with default callback.\n", stderr);
+    return (1);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+    const char	*text;			/* Text value */
+
+   /*
+    * Verify that mxmlFindElement() and indirectly mxmlWalkNext() work
+    * properly...
+    */
+
+    if ((node = mxmlFindPath(tree, "group/option/keyword")) == NULL)
+    {
+      fputs("Unable to find group/option/keyword element in XML tree.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    if (node->type != MXML_TEXT)
+    {
+      fputs("No child node of group/option/keyword.\n", stderr);
+      mxmlSaveFile(tree, stderr, MXML_NO_CALLBACK);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    if ((text = mxmlGetText(node, NULL)) == NULL || strcmp(text, "InputSlot"))
+    {
+      fprintf(stderr, "Child node of group/option/value has value \"%s\" instead of \"InputSlot\".\n", text ? text : "(null)");
+      mxmlDelete(tree);
+      return (1);
+    }
+  }
+
+  mxmlDelete(tree);
+
+ /*
+  * Open the file...
+  */
+
+  if (argv[1][0] == '<')
+    tree = mxmlLoadString(NULL, argv[1], type_cb);
+  else if ((fp = fopen(argv[1], "rb")) == NULL)
+  {
+    perror(argv[1]);
+    return (1);
+  }
+  else
+  {
+   /*
+    * Read the file...
+    */
+
+    tree = mxmlLoadFile(NULL, fp, type_cb);
+
+    fclose(fp);
+  }
+
+  if (!tree)
+  {
+    fputs("Unable to read XML file.\n", stderr);
+    return (1);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Verify that mxmlFindElement() and indirectly mxmlWalkNext() work
+    * properly...
+    */
+
+    if ((node = mxmlFindElement(tree, tree, "choice", NULL, NULL,
+                                MXML_DESCEND)) == NULL)
+    {
+      fputs("Unable to find first <choice> element in XML tree.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    if (!mxmlFindElement(node, tree, "choice", NULL, NULL, MXML_NO_DESCEND))
+    {
+      fputs("Unable to find second <choice> element in XML tree.\n", stderr);
+      mxmlDelete(tree);
+      return (1);
+    }
+  }
+
+ /*
+  * Print the XML tree...
+  */
+
+  mxmlSaveFile(tree, stdout, whitespace_cb);
+
+ /*
+  * Save the XML tree to a string and print it...
+  */
+
+  if (mxmlSaveString(tree, buffer, sizeof(buffer), whitespace_cb) > 0)
+  {
+    if (argc == 3)
+    {
+      fp = fopen(argv[2], "w");
+      fputs(buffer, fp);
+      fclose(fp);
+    }
+  }
+
+ /*
+  * Load the file by name and make sure we get the same tree...
+  */
+
+  if (argv[1][0] != '<')
+  {
+    mxml_node_t	*ptree;			/* Tree loaded by name */
+    char	*tstring,		/* Original tree as a string */
+		*pstring;		/* Tree loaded by name as a string */
+
+    if ((ptree = mxmlLoadPath(NULL, argv[1], type_cb)) == NULL)
+    {
+      fprintf(stderr, "Unable to load \"%s\" with mxmlLoadPath.\n", argv[1]);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    tstring = mxmlSaveAllocString(tree, whitespace_cb);
+    pstring = mxmlSaveAllocString(ptree, whitespace_cb);
+
+    mxmlDelete(ptree);
+
+    if (!tstring || !pstring || strcmp(tstring, pstring))
+    {
+      fputs("mxmlLoadPath and mxmlLoadFile trees differ.\n", stderr);
+      free(tstring);
+      free(pstring);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    free(pstring);
+
+   /*
+    * Feed the file to a push parser one byte at a time and make sure we get
+    * the same tree again...
+    */
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      free(tstring);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    if ((parser = mxmlParserNew(NULL, type_cb)) == NULL)
+    {
+      fputs("Unable to create push parser.\n", stderr);
+      fclose(fp);
+      free(tstring);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    while ((i = getc(fp)) != EOF)
+    {
+      buffer[0] = (char)i;
+
+      if (mxmlParserFeed(parser, buffer, 1))
+        break;
+    }
+
+    fclose(fp);
+
+    ptree   = mxmlParserFinish(parser);
+    pstring = ptree ? mxmlSaveAllocString(ptree, whitespace_cb) : NULL;
+
+    mxmlParserDelete(parser);
+    mxmlDelete(ptree);
+
+    if (!pstring || strcmp(tstring, pstring))
+    {
+      fputs("mxmlParserFeed and mxmlLoadFile trees differ.\n", stderr);
+      free(tstring);
+      free(pstring);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+    free(tstring);
+    free(pstring);
+  }
+
+ /*
+  * Delete the tree...
+  */
+
+  mxmlDelete(tree);
+
+ /*
+  * Read from/write to file descriptors...
+  */
+
+  if (argv[1][0] != '<')
+  {
+   /*
+    * Open the file again...
+    */
+
+    if ((fd = open(argv[1], O_RDONLY | O_BINARY)) < 0)
+    {
+      perror(argv[1]);
+      return (1);
+    }
+
+   /*
+    * Read the file...
+    */
+
+    tree = mxmlLoadFd(NULL, fd, type_cb);
+
+    close(fd);
+
+   /*
+    * Create filename.xmlfd...
+    */
+
+    snprintf(buffer, sizeof(buffer), "%sfd", argv[1]);
+
+    if ((fd = open(buffer, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666)) < 0)
+    {
+      perror(buffer);
+      mxmlDelete(tree);
+      return (1);
+    }
+
+   /*
+    * Write the file...
+    */
+
+    mxmlSaveFd(tree, fd, whitespace_cb);
+
+    close(fd);
+
+   /*
+    * Delete the tree...
+    */
+
+    mxmlDelete(tree);
+  }
+
+ /*
+  * Test SAX methods...
+  */
+
+  memset(event_counts, 0, sizeof(event_counts));
+
+  if (argv[1][0] == '<')
+    mxmlSAXLoadString(NULL, argv[1], type_cb, sax_cb, NULL);
+  else if ((fp = fopen(argv[1], "rb")) == NULL)
+  {
+    perror(argv[1]);
+    return (1);
+  }
+  else
+  {
+   /*
+    * Read the file...
+    */
+
+    mxmlSAXLoadFile(NULL, fp, type_cb, sax_cb, NULL);
+
+    fclose(fp);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+    if (event_counts[MXML_SAX_CDATA] != 1)
+    {
+      fprintf(stderr, "MXML_SAX_CDATA seen %d times, expected 1 times.\n",
+              event_counts[MXML_SAX_CDATA]);
+      return (1);
+    }
+
+    if (event_counts[MXML_SAX_COMMENT] != 1)
+    {
+      fprintf(stderr, "MXML_SAX_COMMENT seen %d times, expected 1 times.\n",
+              event_counts[MXML_SAX_COMMENT]);
+      return (1);
+    }
+
+    if (event_counts[MXML_SAX_DATA] != 60)
+    {
+      fprintf(stderr, "MXML_SAX_DATA seen %d times, expected 60 times.\n",
+              event_counts[MXML_SAX_DATA]);
+      return (1);
+    }
+
+    if (event_counts[MXML_SAX_DIRECTIVE] != 1)
+    {
+      fprintf(stderr, "MXML_SAX_DIRECTIVE seen %d times, expected 1 times.\n",
+              event_counts[MXML_SAX_DIRECTIVE]);
+      return (1);
+    }
+
+    if (event_counts[MXML_SAX_ELEMENT_CLOSE] != 20)
+    {
+      fprintf(stderr, "MXML_SAX_ELEMENT_CLOSE seen %d times, expected 20 times.\n",
+              event_counts[MXML_SAX_ELEMENT_CLOSE]);
+      return (1);
+    }
+
+    if (event_counts[MXML_SAX_ELEMENT_OPEN] != 20)
+    {
+      fprintf(stderr, "MXML_SAX_ELEMENT_OPEN seen %d times, expected 20 times.\n",
+              event_counts[MXML_SAX_ELEMENT_OPEN]);
+      return (1);
+    }
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test the SAX view callback...
+    */
+
+    memset(view_counts, 0, sizeof(view_counts));
+    view_attrs = 0;
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      return (1);
+    }
+
+    i = mxmlSAXViewLoadFile(fp, sax_view_cb, NULL);
+
+    fclose(fp);
+
+    if (i)
+    {
+      fputs("mxmlSAXViewLoadFile failed.\n", stderr);
+      return (1);
+    }
+
+    if (view_counts[MXML_SAX_CDATA] != 1 ||
+        view_counts[MXML_SAX_COMMENT] != 1 ||
+        view_counts[MXML_SAX_DATA] != 40 ||
+        view_counts[MXML_SAX_DIRECTIVE] != 1 ||
+        view_counts[MXML_SAX_ELEMENT_CLOSE] != 20 ||
+        view_counts[MXML_SAX_ELEMENT_OPEN] != 20 ||
+        view_attrs != 9)
+    {
+      fprintf(stderr, "SAX view events %d/%d/%d/%d/%d/%d with %d attributes, expected 1/1/40/1/20/20 with 9 attributes.\n",
+              view_counts[MXML_SAX_CDATA], view_counts[MXML_SAX_COMMENT],
+              view_counts[MXML_SAX_DATA], view_counts[MXML_SAX_DIRECTIVE],
+              view_counts[MXML_SAX_ELEMENT_CLOSE],
+              view_counts[MXML_SAX_ELEMENT_OPEN], view_attrs);
+      return (1);
+    }
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test batch loading, including a missing file...
+    */
+
+    static const char * const files[3] = { "test.xml", "no-such-file.xml", "test.xml" };
+					/* Files to load */
+    mxml_node_t	*trees[3];		/* Loaded trees */
+    char	*errors[3],		/* Error messages */
+		*bstring[2];		/* Loaded trees as strings */
+    const char	*many[20];		/* More files than are read ahead */
+    mxml_node_t	*mtrees[20];		/* Trees for many files */
+    int		j;			/* Looping var */
+
+    i = mxmlLoadBatch(files, 3, type_cb, 2, trees, errors);
+
+    bstring[0] = trees[0] ? mxmlSaveAllocString(trees[0], whitespace_cb) : NULL;
+    bstring[1] = trees[2] ? mxmlSaveAllocString(trees[2], whitespace_cb) : NULL;
+
+    mxmlDelete(trees[0]);
+    mxmlDelete(trees[1]);
+    mxmlDelete(trees[2]);
+
+    if (i != 2 || trees[1] || errors[0] || !errors[1] || errors[2] || !bstring[0] || !bstring[1] || strcmp(bstring[0], bstring[1]))
+    {
+      fprintf(stderr, "mxmlLoadBatch returned %d, expected 2 loaded files and an error for \"%s\" (got \"%s\").\n", i, files[1], errors[1] ? errors[1] : "(null)");
+      free(errors[0]);
+      free(errors[1]);
+      free(errors[2]);
+      free(bstring[0]);
+      free(bstring[1]);
+      return (1);
+    }
+
+   /*
+    * Load more files with one thread than are read ahead at a time...
+    */
+
+    for (j = 0; j < 20; j ++)
+      many[j] = "test.xml";
+
+    i = mxmlLoadBatch(many, 20, type_cb, 1, mtrees, NULL);
+
+    free(bstring[1]);
+    bstring[1] = mtrees[19] ? mxmlSaveAllocString(mtrees[19], whitespace_cb) : NULL;
+
+    for (j = 0; j < 20; j ++)
+      mxmlDelete(mtrees[j]);
+
+    if (i != 20 || !bstring[1] || strcmp(bstring[0], bstring[1]))
+    {
+      fprintf(stderr, "mxmlLoadBatch returned %d, expected 20 loaded files.\n", i);
+      free(errors[1]);
+      free(bstring[0]);
+      free(bstring[1]);
+      return (1);
+    }
+
+    free(errors[1]);
+    free(bstring[0]);
+    free(bstring[1]);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test loading documents with a loader, including one with long text that
+    * grows the buffers and one with an error...
+    */
+
+    mxml_loader_t	*loader;	/* Loader */
+    char		*sstring,	/* mxmlLoadFile tree as a string */
+			*lstring;	/* Loader tree as a string */
+    static const char	*docs[] =	/* Documents to load */
+    {
+      "<a x=\"1\" y=\"2\">text</a>",
+      "<a><b/></c>",
+      NULL
+    };
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      return (1);
+    }
+
+    tree    = mxmlLoadFile(NULL, fp, type_cb);
+    sstring = tree ? mxmlSaveAllocString(tree, whitespace_cb) : NULL;
+
+    fclose(fp);
+    mxmlDelete(tree);
+
+    if ((loader = mxmlLoaderNew()) == NULL)
+    {
+      fputs("mxmlLoaderNew failed.\n", stderr);
+      free(sstring);
+      return (1);
+    }
+
+    memset(buffer, 'x', sizeof(buffer) - 1);
+    memcpy(buffer, "<a>", 3);
+    memcpy(buffer + sizeof(buffer) - 5, "</a>", 5);
+
+    for (i = 0; i < 3; i ++)
+    {
+      if ((fp = fopen(argv[1], "rb")) == NULL)
+      {
+        perror(argv[1]);
+        break;
+      }
+
+      tree    = mxmlLoaderLoadFile(loader, NULL, fp, type_cb);
+      lstring = tree ? mxmlSaveAllocString(tree, whitespace_cb) : NULL;
+
+      fclose(fp);
+      mxmlDelete(tree);
+
+      if (!sstring || !lstring || strcmp(sstring, lstring))
+      {
+        fprintf(stderr, "mxmlLoaderLoadFile and mxmlLoadFile trees differ for load %d.\n", i + 1);
+        free(lstring);
+        break;
+      }
+
+      free(lstring);
+
+      if ((tree = mxmlLoaderLoadString(loader, NULL, docs[i] ? docs[i] : buffer, MXML_OPAQUE_CALLBACK)) == NULL)
+      {
+        if (i != 1)
+        {
+          fprintf(stderr, "mxmlLoaderLoadString failed for load %d.\n", i + 1);
+          break;
+        }
+      }
+      else if (i == 1 || (docs[i] && strcmp(mxmlGetOpaque(mxmlGetFirstChild(tree)), "text")) || (!docs[i] && strlen(mxmlGetOpaque(mxmlGetFirstChild(tree))) != sizeof(buffer) - 8))
+      {
+        fprintf(stderr, "mxmlLoaderLoadString returned a bad tree for load %d.\n", i + 1);
+        mxmlDelete(tree);
+        break;
+      }
+
+      mxmlDelete(tree);
+    }
+
+    if (i == 3)
+    {
+     /*
+      * Test a type map that does the same thing as type_cb()...
+      */
+
+      mxml_typemap_t	*map;		/* Type map */
+      int		mapok = 1;	/* Did the type map tests pass? */
+
+      map = mxmlTypeMapNew("type");
+
+      mxmlTypeMapAdd(map, "integer", MXML_INTEGER);
+      mxmlTypeMapAdd(map, "opaque", MXML_OPAQUE);
+      mxmlTypeMapAdd(map, "pre", MXML_OPAQUE);
+      mxmlTypeMapAdd(map, "real", MXML_REAL);
+
+      mxmlLoaderSetTypeMap(loader, map);
+
+      if ((fp = fopen(argv[1], "rb")) == NULL)
+      {
+        perror(argv[1]);
+        mapok = 0;
+      }
+      else
+      {
+        tree    = mxmlLoaderLoadFile(loader, NULL, fp, MXML_TEXT_CALLBACK);
+        lstring = tree ? mxmlSaveAllocString(tree, whitespace_cb) : NULL;
+        node    = tree ? mxmlFindElement(tree, tree, "order", NULL, NULL, MXML_DESCEND) : NULL;
+
+        fclose(fp);
+
+        if (!sstring || !lstring || strcmp(sstring, lstring) || mxmlGetType(mxmlGetFirstChild(node)) != MXML_REAL)
+        {
+          fputs("mxmlLoaderLoadFile with a type map and mxmlLoadFile trees differ.\n", stderr);
+          mapok = 0;
+        }
+
+        mxmlDelete(tree);
+        free(lstring);
+      }
+
+      mxmlTypeMapDelete(map);
+
+     /*
+      * Test a type map keyed on element names, using the callback for other
+      * elements...
+      */
+
+      map = mxmlTypeMapNew(NULL);
+
+      for (i = 0; i < 100; i ++)
+      {
+        snprintf(buffer, sizeof(buffer), "e%d", i);
+        mxmlTypeMapAdd(map, buffer, MXML_TEXT);
+      }
+
+      mxmlTypeMapAdd(map, "order", MXML_TEXT);
+      mxmlTypeMapAdd(map, "order", MXML_REAL);
+
+      mxmlLoaderSetTypeMap(loader, map);
+
+      if ((tree = mxmlLoaderLoadString(loader, NULL, "<r><order>10.5</order><n>1 2</n><e42>a b</e42></r>", MXML_OPAQUE_CALLBACK)) == NULL ||
+          mxmlGetReal(mxmlFindElement(tree, tree, "order", NULL, NULL, MXML_DESCEND)) != 10.5 ||
+          !mxmlGetOpaque(mxmlFindElement(tree, tree, "n", NULL, NULL, MXML_DESCEND)) ||
+          strcmp(mxmlGetOpaque(mxmlFindElement(tree, tree, "n", NULL, NULL, MXML_DESCEND)), "1 2") ||
+          !mxmlGetText(mxmlFindElement(tree, tree, "e42", NULL, NULL, MXML_DESCEND), NULL))
+      {
+        fputs("mxmlLoaderLoadString with a type map returned a bad tree.\n", stderr);
+        mapok = 0;
+      }
+
+      mxmlDelete(tree);
+      mxmlLoaderSetTypeMap(loader, NULL);
+      mxmlTypeMapDelete(map);
+
+      i = mapok ? 3 : 0;
+    }
+
+    if (i == 3)
+    {
+     /*
+      * Test loading into an arena, and building and changing an arena tree
+      * whose nodes outlive the document...
+      */
+
+      mxml_node_t	*arena;		/* Arena document */
+      char		*big;		/* String larger than an arena slab */
+      int		count;		/* Number of elements found */
+
+      mxmlLoaderSetArena(loader, 1);
+
+      if ((fp = fopen(argv[1], "rb")) == NULL)
+      {
+        perror(argv[1]);
+        i = 0;
+      }
+      else
+      {
+        tree    = mxmlLoaderLoadFile(loader, NULL, fp, type_cb);
+        lstring = tree ? mxmlSaveAllocString(tree, whitespace_cb) : NULL;
+
+        fclose(fp);
+
+       /*
+        * Element and attribute names in the arena are interned; check that
+        * finding them, and names that are not in the arena, still works...
+        */
+
+        for (count = 0, node = tree; (node = mxmlFindElement(node, tree, "keyword", "type", "opaque", MXML_DESCEND)) != NULL; count ++);
+
+        mxmlElementSetAttr(mxmlNewElement(tree, "extra"), "id", "42");
+
+        if (count != 4 || mxmlFindElement(tree, tree, "keyword", "id", NULL, MXML_DESCEND) || mxmlFindElement(tree, tree, "nosuchname", NULL, NULL, MXML_DESCEND) || !mxmlFindElement(tree, tree, "extra", "id", "42", MXML_DESCEND))
+        {
+          fprintf(stderr, "mxmlFindElement in an arena tree found %d keywords, expected 4.\n", count);
+          i = 0;
+        }
+
+        mxmlDelete(tree);
+
+        if (!sstring || !lstring || strcmp(sstring, lstring))
+        {
+          fputs("mxmlLoaderLoadFile with an arena and mxmlLoadFile trees differ.\n", stderr);
+          i = 0;
+        }
+
+        free(lstring);
+      }
+
+      mxmlLoaderSetArena(loader, 0);
+
+      if ((big = malloc(300000)) != NULL)
+      {
+        memset(big, 'x', 299999);
+        big[299999] = '\0';
+      }
+
+      arena = mxmlNewXMLArena("1.0");
+      node  = mxmlNewElement(arena, "a");
+
+      mxmlElementSetAttr(node, "x", "1");
+      mxmlElementSetAttr(node, "y", "2");
+      mxmlElementSetAttr(node, "x", "3");
+      mxmlElementSetAttrf(node, "z", "%d", 4);
+      mxmlSetText(mxmlNewText(node, 0, "hello"), 0, "bye");
+      mxmlNewOpaque(mxmlNewElement(arena, "big"), big ? big : "");
+
+      mxmlRemove(node);
+
+      lstring = mxmlSaveAllocString(arena, MXML_NO_CALLBACK);
+
+      mxmlDelete(arena);
+      mxmlSaveString(node, buffer, sizeof(buffer), MXML_NO_CALLBACK);
+      mxmlDelete(node);
+
+      if (!big || !lstring || strlen(lstring) < 300000 || strcmp(buffer, "<a x=\"3\" y=\"2\" z=\"4\">bye</a>\n"))
+      {
+        fprintf(stderr, "Arena tree saved as \"%s\", expected \"<a x=\"3\" y=\"2\" z=\"4\">bye</a>\".\n", buffer);
+        i = 0;
+      }
+
+      free(big);
+      free(lstring);
+    }
+
+    mxmlLoaderDelete(loader);
+    free(sstring);
+
+    if (i < 3)
+      return (1);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test that loading and deleting trees frees every block that was
+    * allocated, and that the allocation functions can no longer be changed...
     */
 
-    mxmlSAXLoadFile(NULL, fp, type_cb, sax_cb, NULL);
+    int		inuse = alloc_inuse;	/* Blocks in use before */
+    mxml_node_t	*arena;			/* Arena document */
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      return (1);
+    }
 
+    tree = mxmlLoadFile(NULL, fp, type_cb);
     fclose(fp);
+
+    i = alloc_inuse - inuse;
+    mxmlElementSetAttrf(tree, "count", "%d", i);
+    mxmlDelete(tree);
+
+    arena = mxmlNewXMLArena("1.0");
+    mxmlElementSetAttr(mxmlNewElement(arena, "a"), "b", "c");
+    mxmlSetOpaquef(mxmlNewOpaque(arena, "value"), "changed %d", 42);
+    mxmlDelete(arena);
+
+    if (i <= 0 || alloc_inuse != inuse)
+    {
+      fprintf(stderr, "ERROR: Allocation functions used for %d blocks, %d still in use.\n", i, alloc_inuse - inuse);
+      return (1);
+    }
+
+    if (mxmlSetAllocator(NULL, NULL, NULL, NULL) != -1)
+    {
+      fputs("ERROR: mxmlSetAllocator changed the functions after memory was allocated.\n", stderr);
+      return (1);
+    }
   }
 
+#if defined(HAVE_LIBZ) || defined(HAVE_LIBZSTD)
   if (!strcmp(argv[1], "test.xml"))
   {
-    if (event_counts[MXML_SAX_CDATA] != 1)
+   /*
+    * Test saving and loading compressed files...
+    */
+
+    char			*sstring,	/* Original tree as a string */
+				*cstring;	/* Compressed tree as a string */
+    unsigned char		magic[4];	/* Start of compressed file */
+    static const mxml_compress_t formats[] =
+    {					/* Compression formats to test */
+#  ifdef HAVE_LIBZ
+      MXML_COMPRESS_GZIP,
+#  endif /* HAVE_LIBZ */
+#  ifdef HAVE_LIBZSTD
+      MXML_COMPRESS_ZSTD,
+#  endif /* HAVE_LIBZSTD */
+      MXML_COMPRESS_NONE
+    };
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
     {
-      fprintf(stderr, "MXML_SAX_CDATA seen %d times, expected 1 times.\n",
-              event_counts[MXML_SAX_CDATA]);
+      perror(argv[1]);
       return (1);
     }
 
-    if (event_counts[MXML_SAX_COMMENT] != 1)
+    tree    = mxmlLoadFile(NULL, fp, type_cb);
+    sstring = tree ? mxmlSaveAllocString(tree, whitespace_cb) : NULL;
+
+    fclose(fp);
+
+    for (i = 0; formats[i] != MXML_COMPRESS_NONE; i ++)
     {
-      fprintf(stderr, "MXML_SAX_COMMENT seen %d times, expected 1 times.\n",
-              event_counts[MXML_SAX_COMMENT]);
+      if (mxmlSetCompression(formats[i]))
+        break;
+
+      if ((fp = fopen("tempz.xml", "wb")) == NULL)
+      {
+        perror("tempz.xml");
+        break;
+      }
+
+      if (mxmlSaveFile(tree, fp, whitespace_cb))
+      {
+        fputs("mxmlSaveFile failed for compressed file.\n", stderr);
+        fclose(fp);
+        break;
+      }
+
+      fclose(fp);
+
+      if ((fd = open("tempz.xml", O_RDONLY | O_BINARY)) < 0 || read(fd, magic, sizeof(magic)) != sizeof(magic) || (magic[0] != 0x1f && magic[0] != 0x28))
+      {
+        fputs("Compressed file does not start with a gzip or Zstandard header.\n", stderr);
+
+        if (fd >= 0)
+          close(fd);
+        break;
+      }
+
+      close(fd);
+
+      mxmlDelete(tree);
+
+      if ((tree = mxmlLoadPath(NULL, "tempz.xml", type_cb)) == NULL)
+      {
+        fputs("mxmlLoadPath failed for compressed file.\n", stderr);
+        break;
+      }
+
+      cstring = mxmlSaveAllocString(tree, whitespace_cb);
+
+      if (!sstring || !cstring || strcmp(sstring, cstring))
+      {
+        fprintf(stderr, "Compressed file %d does not match.\n", i + 1);
+        free(cstring);
+        break;
+      }
+
+      free(cstring);
+    }
+
+    mxmlSetCompression(MXML_COMPRESS_NONE);
+    mxmlDelete(tree);
+    free(sstring);
+    unlink("tempz.xml");
+
+    if (formats[i] != MXML_COMPRESS_NONE)
+      return (1);
+  }
+#endif /* HAVE_LIBZ || HAVE_LIBZSTD */
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test parallel loading of a large document against sequential loading...
+    */
+
+    char	*large,			/* Large document */
+		*lptr,			/* Pointer into document */
+		*sstring,		/* Sequential tree as a string */
+		*pstring;		/* Parallel tree as a string */
+    mxml_node_t	*stree,			/* Sequentially loaded tree */
+		*ptree;			/* Parallel loaded tree */
+    size_t	lsize = 1048576;	/* Size of document buffer */
+
+    if ((large = malloc(lsize)) == NULL)
+    {
+      perror("malloc");
       return (1);
     }
 
-    if (event_counts[MXML_SAX_DATA] != 60)
+    strlcpy(large, "<?xml version=\"1.0\"?>\n<!-- prolog -->\n<records version=\"2\">\n", lsize);
+
+    for (i = 0, lptr = large + strlen(large); i < 5000; i ++, lptr += strlen(lptr))
+      snprintf(lptr, lsize - (size_t)(lptr - large), "  <record id=\"%d\" note='a > b'>word %d <b>bold</b> &amp; more<record/></record>\n  <!-- c > d -->\n  <![CDATA[<x>]]><?pi > ?>\n  <empty x=\"/\"/>\n", i, i);
+
+    strlcpy(lptr, "</records>\n<!-- epilog -->\n", lsize - (size_t)(lptr - large));
+
+    stree   = mxmlLoadString(NULL, large, type_cb);
+    ptree   = mxmlLoadBufferParallel(NULL, large, strlen(large), type_cb, 4);
+    sstring = stree ? mxmlSaveAllocString(stree, whitespace_cb) : NULL;
+    pstring = ptree ? mxmlSaveAllocString(ptree, whitespace_cb) : NULL;
+
+    mxmlDelete(stree);
+    mxmlDelete(ptree);
+
+    if (!sstring || !pstring || strcmp(sstring, pstring))
     {
-      fprintf(stderr, "MXML_SAX_DATA seen %d times, expected 60 times.\n",
-              event_counts[MXML_SAX_DATA]);
+      fputs("mxmlLoadBufferParallel and mxmlLoadString trees differ.\n", stderr);
+      free(large);
+      free(sstring);
+      free(pstring);
       return (1);
     }
 
-    if (event_counts[MXML_SAX_DIRECTIVE] != 1)
+    free(sstring);
+    free(pstring);
+
+   /*
+    * Errors in a segment must still fail the load...
+    */
+
+    if ((lptr = strstr(large + strlen(large) / 2, "</b>")) != NULL)
+      lptr[2] = 'i';
+
+    if ((ptree = mxmlLoadBufferParallel(NULL, large, strlen(large), type_cb, 4)) != NULL)
     {
-      fprintf(stderr, "MXML_SAX_DIRECTIVE seen %d times, expected 1 times.\n",
-              event_counts[MXML_SAX_DIRECTIVE]);
+      fputs("mxmlLoadBufferParallel did not fail for a mismatched close tag.\n", stderr);
+      mxmlDelete(ptree);
+      free(large);
       return (1);
     }
 
-    if (event_counts[MXML_SAX_ELEMENT_CLOSE] != 20)
+    free(large);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test loading a large UTF-16 document in both byte orders from a
+    * buffer and a file, against the same document in UTF-8...
+    */
+
+    static const int chars[] =		/* Characters in each record */
     {
-      fprintf(stderr, "MXML_SAX_ELEMENT_CLOSE seen %d times, expected 20 times.\n",
-              event_counts[MXML_SAX_ELEMENT_CLOSE]);
+      '<', 'r', ' ', 'a', '=', '\'', 0xe9, '\'', '>', 'x', 'y', 'z', 0x20ac,
+      0x1d11e, 'x', 'y', 'z', '&', 'l', 't', ';', '<', '/', 'r', '>', '\n'
+    };
+    char		*u8,		/* UTF-8 document */
+			*u8ptr,		/* Pointer into UTF-8 document */
+			*sstring,	/* UTF-8 tree as a string */
+			*ustring;	/* UTF-16 tree as a string */
+    unsigned char	*u16,		/* UTF-16LE document */
+			*u16ptr,	/* Pointer into UTF-16 document */
+			temp;		/* Swapped byte */
+    int			ch,		/* Current character */
+			be;		/* Big-endian? */
+    size_t		j,		/* Looping var */
+			u16len;		/* Length of UTF-16 document */
+
+    u8  = malloc(3000 * sizeof(chars) + 16);
+    u16 = malloc(3000 * sizeof(chars) + 32);
+
+    if (!u8 || !u16)
+    {
+      perror("malloc");
       return (1);
     }
 
-    if (event_counts[MXML_SAX_ELEMENT_OPEN] != 20)
+    strlcpy(u8, "<doc>", 16);
+    memcpy(u16, "\377\376<\0d\0o\0c\0>\0", 12);
+
+    for (i = 0, u8ptr = u8 + 5, u16ptr = u16 + 12; i < 3000; i ++)
     {
-      fprintf(stderr, "MXML_SAX_ELEMENT_OPEN seen %d times, expected 20 times.\n",
-              event_counts[MXML_SAX_ELEMENT_OPEN]);
+      for (j = 0; j < sizeof(chars) / sizeof(chars[0]); j ++)
+      {
+        ch = chars[j];
+
+        if (ch < 0x80)
+        {
+          *u8ptr++ = (char)ch;
+        }
+        else if (ch < 0x800)
+        {
+          *u8ptr++ = (char)(0xc0 | (ch >> 6));
+          *u8ptr++ = (char)(0x80 | (ch & 0x3f));
+        }
+        else if (ch < 0x10000)
+        {
+          *u8ptr++ = (char)(0xe0 | (ch >> 12));
+          *u8ptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+          *u8ptr++ = (char)(0x80 | (ch & 0x3f));
+        }
+        else
+        {
+          *u8ptr++ = (char)(0xf0 | (ch >> 18));
+          *u8ptr++ = (char)(0x80 | ((ch >> 12) & 0x3f));
+          *u8ptr++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+          *u8ptr++ = (char)(0x80 | (ch & 0x3f));
+
+          ch      -= 0x10000;
+          *u16ptr++ = (unsigned char)((0xd800 | (ch >> 10)) & 255);
+          *u16ptr++ = (unsigned char)((0xd800 | (ch >> 10)) >> 8);
+          ch      = 0xdc00 | (ch & 0x3ff);
+        }
+
+        *u16ptr++ = (unsigned char)(ch & 255);
+        *u16ptr++ = (unsigned char)(ch >> 8);
+      }
+    }
+
+    strlcpy(u8ptr, "</doc>", 16);
+    memcpy(u16ptr, "<\0/\0d\0o\0c\0>\0", 12);
+    u16len = (size_t)(u16ptr - u16) + 12;
+
+    tree    = mxmlLoadString(NULL, u8, MXML_OPAQUE_CALLBACK);
+    sstring = tree ? mxmlSaveAllocString(tree, MXML_NO_CALLBACK) : NULL;
+
+    mxmlDelete(tree);
+
+    for (be = 0; be < 2 && sstring; be ++)
+    {
+      if (be)
+      {
+        for (j = 0; j < u16len; j += 2)
+        {
+          temp       = u16[j];
+          u16[j]     = u16[j + 1];
+          u16[j + 1] = temp;
+        }
+      }
+
+      tree    = mxmlLoadBuffer(NULL, u16, u16len, MXML_OPAQUE_CALLBACK);
+      ustring = tree ? mxmlSaveAllocString(tree, MXML_NO_CALLBACK) : NULL;
+
+      mxmlDelete(tree);
+
+      if (!ustring || strcmp(sstring, ustring))
+      {
+        fprintf(stderr, "ERROR: UTF-16%s buffer and UTF-8 trees differ.\n", be ? "BE" : "LE");
+        free(ustring);
+        free(sstring);
+        sstring = NULL;
+        break;
+      }
+
+      free(ustring);
+
+      if ((fp = fopen("temp16.xml", "wb")) == NULL)
+      {
+        perror("temp16.xml");
+        free(sstring);
+        sstring = NULL;
+        break;
+      }
+
+      fwrite(u16, 1, u16len, fp);
+      fclose(fp);
+
+      fp      = fopen("temp16.xml", "rb");
+      tree    = fp ? mxmlLoadFile(NULL, fp, MXML_OPAQUE_CALLBACK) : NULL;
+      ustring = tree ? mxmlSaveAllocString(tree, MXML_NO_CALLBACK) : NULL;
+
+      if (fp)
+        fclose(fp);
+
+      mxmlDelete(tree);
+      remove("temp16.xml");
+
+      if (!ustring || strcmp(sstring, ustring))
+      {
+        fprintf(stderr, "ERROR: UTF-16%s file and UTF-8 trees differ.\n", be ? "BE" : "LE");
+        free(ustring);
+        free(sstring);
+        sstring = NULL;
+        break;
+      }
+
+      free(ustring);
+    }
+
+    free(u8);
+    free(u16);
+
+    if (!sstring)
+      return (1);
+
+    free(sstring);
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test loading <choice> records, keeping the last one...
+    */
+
+    int	records = 0;			/* Number of good records */
+
+    kept_record = NULL;
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      return (1);
+    }
+
+    i = mxmlLoadRecordsFile(fp, "choice", type_cb, record_cb, &records);
+
+    fclose(fp);
+
+    if (i != 3 || records != 3)
+    {
+      fprintf(stderr, "mxmlLoadRecordsFile returned %d with %d good records, expected 3.\n", i, records);
+      mxmlRelease(kept_record);
+      return (1);
+    }
+
+    node = mxmlFindElement(kept_record, kept_record, "keyword", NULL, NULL, MXML_DESCEND);
+
+    if (!node || !mxmlGetOpaque(node) || strcmp(mxmlGetOpaque(node), "Lower"))
+    {
+      fputs("Retained record does not contain <keyword>Lower</keyword>.\n", stderr);
+      mxmlRelease(kept_record);
+      return (1);
+    }
+
+    if (mxmlRelease(kept_record))
+    {
+      fputs("Retained record has more than one reference.\n", stderr);
+      return (1);
+    }
+  }
+
+  if (!strcmp(argv[1], "test.xml"))
+  {
+   /*
+    * Test the pull reader, skipping the <choice> elements and stopping at
+    * <integer>...
+    */
+
+    mxml_reader_t	*reader;	/* Pull reader */
+    mxml_reader_event_t	event;		/* Reader event */
+    const char		*name;		/* Element name */
+    int			choices = 0;	/* Number of <choice> elements */
+
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+    {
+      perror(argv[1]);
+      return (1);
+    }
+
+    if ((reader = mxmlReaderNewFile(fp)) == NULL)
+    {
+      fputs("Unable to create pull reader.\n", stderr);
+      fclose(fp);
+      return (1);
+    }
+
+    while ((event = mxmlReaderNext(reader)) > MXML_READER_EOF)
+    {
+      if (event != MXML_READER_ELEMENT_OPEN)
+        continue;
+
+      name = mxmlReaderGetName(reader);
+
+      if (!strcmp(name, "integer"))
+        break;
+      else if (!strcmp(name, "choice"))
+      {
+        choices ++;
+
+        if (mxmlReaderSkip(reader) != MXML_READER_ELEMENT_CLOSE || strcmp(mxmlReaderGetName(reader), "choice"))
+        {
+          fputs("mxmlReaderSkip did not stop at </choice>.\n", stderr);
+          event = MXML_READER_ERROR;
+          break;
+        }
+      }
+      else if (!strcmp(name, "keyword"))
+      {
+        if (mxmlReaderGetDepth(reader) != 2)
+        {
+          fputs("mxmlReaderSkip did not skip <keyword> in <choice>.\n", stderr);
+          event = MXML_READER_ERROR;
+          break;
+        }
+        else if (!mxmlReaderGetAttr(reader, "type") || strcmp(mxmlReaderGetAttr(reader, "type"), "opaque"))
+        {
+          fputs("Bad type attribute for <keyword> from pull reader.\n", stderr);
+          event = MXML_READER_ERROR;
+          break;
+        }
+      }
+    }
+
+    mxmlReaderDelete(reader);
+    fclose(fp);
+
+    if (event != MXML_READER_ELEMENT_OPEN || choices != 3)
+    {
+      fprintf(stderr, "Pull reader stopped with event %d after %d <choice> elements, expected <integer> after 3.\n", event, choices);
       return (1);
     }
   }
@@ -748,6 +2196,113 @@ main(int  argc,				/* I - Number of command-line args */
 }
 
 
+/*
+ * 'alloc_count()' - Update the number of blocks in use.
+ */
+
+void
+alloc_count(int *inuse,			/* I - Blocks in use */
+            int delta)			/* I - Change in blocks */
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&alloc_lock);
+#endif /* HAVE_PTHREAD_H */
+
+  *inuse += delta;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&alloc_lock);
+#endif /* HAVE_PTHREAD_H */
+}
+
+
+/*
+ * 'alloc_free_cb()' - Free memory and count the blocks in use.
+ */
+
+void
+alloc_free_cb(void *ctx,		/* I - Blocks in use */
+              void *ptr)		/* I - Memory */
+{
+  alloc_count((int *)ctx, -1);
+
+  free(ptr);
+}
+
+
+/*
+ * 'alloc_malloc_cb()' - Allocate memory and count the blocks in use.
+ */
+
+void *					/* O - Memory */
+alloc_malloc_cb(void   *ctx,		/* I - Blocks in use */
+                size_t size)		/* I - Number of bytes */
+{
+  void	*ptr = malloc(size);		/* Memory */
+
+
+  if (ptr)
+    alloc_count((int *)ctx, 1);
+
+  return (ptr);
+}
+
+
+/*
+ * 'alloc_realloc_cb()' - Reallocate memory and count the blocks in use.
+ */
+
+void *					/* O - Memory */
+alloc_realloc_cb(void   *ctx,		/* I - Blocks in use */
+                 void   *ptr,		/* I - Memory or NULL */
+                 size_t size)		/* I - Number of bytes */
+{
+  void	*newptr = realloc(ptr, size);	/* New memory */
+
+
+  if (newptr && !ptr)
+    alloc_count((int *)ctx, 1);
+
+  return (newptr);
+}
+
+
+/*
+ * 'error_cb()' - Save an error message.
+ */
+
+void
+error_cb(const char *message)		/* I - Error message */
+{
+  strlcpy(last_error, message, sizeof(last_error));
+}
+
+
+/*
+ * 'record_cb()' - Check a loaded record and keep the last one.
+ */
+
+void
+record_cb(mxml_node_t *node,		/* I - Record */
+          void        *data)		/* I - Number of good records */
+{
+  int	*records = (int *)data;		/* Number of good records */
+
+
+  if (mxmlGetParent(node) || strcmp(mxmlGetElement(node), "choice") || !mxmlFindElement(node, node, "text", NULL, NULL, MXML_DESCEND))
+    return;
+
+  (*records) ++;
+
+  if (kept_record)
+    mxmlRelease(kept_record);
+
+  kept_record = node;
+
+  mxmlRetain(node);
+}
+
+
 /*
  * 'sax_cb()' - Process nodes via SAX.
  */
@@ -781,6 +2336,44 @@ sax_cb(mxml_node_t      *node,		/* I - Current node */
 }
 
 
+/*
+ * 'sax_view_cb()' - Process borrowed views via SAX.
+ */
+
+void
+sax_view_cb(
+    mxml_sax_event_t   event,		/* I - SAX event */
+    const char         *name,		/* I - Element name or NULL */
+    const char * const *attrs,		/* I - Attribute name/value pairs */
+    const char         *text,		/* I - Data or CDATA text or NULL */
+    size_t             textlen,		/* I - Length of text */
+    void               *data)		/* I - SAX user data */
+{
+  (void)data;
+
+ /*
+  * This SAX callback counts the events and "type" attributes and checks
+  * that the views match the event.
+  */
+
+  if (event == MXML_SAX_DATA || event == MXML_SAX_CDATA)
+  {
+    if (!text || strlen(text) != textlen)
+      fprintf(stderr, "ERROR: SAX view callback for event %d has bad text.\n", event);
+  }
+  else if (!name)
+    fprintf(stderr, "ERROR: SAX view callback for event %d has NULL name.\n", event);
+
+  for (; *attrs; attrs += 2)
+  {
+    if (!strcmp(attrs[0], "type") && attrs[1])
+      view_attrs ++;
+  }
+
+  view_counts[event] ++;
+}
+
+
 /*
  * 'type_cb()' - XML data type callback for mxmlLoadFile()...
  */
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Generate the perfect hash tables used by _mxml_entity_cb() in mxml-entity.c.
+#
+# Usage:
+#
+#   python3 tools/entity-hash.py [mxml-entity.c]
+#
+# The entity names are read from the "entities[]" array and the "disp[128]" and
+# "slots[512]" initializers in the same file are replaced.  Run this after
+# adding or removing entities.
+#
+# https://www.msweet.org/mxml
+#
+# Licensed under Apache License v2.0.  See the file "LICENSE" for more
+# information.
+#
+
+import re
+import sys
+
+NUM_BUCKETS = 128			# Size of "disp" table
+NUM_SLOTS   = 512			# Size of "slots" table
+
+
+def fnv1a(name):
+    """Return the 32-bit FNV-1a hash of a name."""
+
+    h = 2166136261
+
+    for ch in name.encode("utf-8"):
+        h = ((h ^ ch) * 16777619) & 0xffffffff
+
+    return h
+
+
+def build(names):
+    """Return the "disp" and "slots" tables for a list of names.
+
+    Names are grouped into buckets by the low 7 bits of their hash.  Starting
+    with the largest bucket, and then with the bucket of the first name, each
+    bucket gets the smallest displacement that moves all of its names to free
+    slots."""
+
+    hashes  = [fnv1a(name) for name in names]
+    buckets = [[] for _ in range(NUM_BUCKETS)]
+
+    for index, h in enumerate(hashes):
+        buckets[h % NUM_BUCKETS].append(index)
+
+    disp  = [0] * NUM_BUCKETS
+    slots = [0] * NUM_SLOTS
+
+    order = sorted((b for b in range(NUM_BUCKETS) if buckets[b]), key=lambda b: (-len(buckets[b]), buckets[b][0]))
+
+    for bucket in order:
+        for d in range(256):
+            used = [((hashes[index] >> 7) + d) % NUM_SLOTS for index in buckets[bucket]]
+
+            if len(set(used)) == len(used) and not any(slots[slot] for slot in used):
+                break
+        else:
+            sys.exit("entity-hash.py: No displacement for bucket %d." % bucket)
+
+        disp[bucket] = d
+
+        for index, slot in zip(buckets[bucket], used):
+            slots[slot] = index + 1
+
+    return disp, slots
+
+
+def replace_table(source, decl, values):
+    """Replace the initializer of the table declared as "decl"."""
+
+    start = source.index(decl)
+    start = source.index("{", start) + 1
+    end   = source.index("};", start)
+    rows  = [", ".join(str(v) for v in values[i:i + 16]) for i in range(0, len(values), 16)]
+
+    return source[:start] + "\n    " + ",\n    ".join(rows) + "\n  " + source[end:]
+
+
+def main():
+    filename = sys.argv[1] if len(sys.argv) > 1 else "mxml-entity.c"
+
+    with open(filename, encoding="utf-8") as f:
+        source = f.read()
+
+    start = source.index("entities[] =")
+    end   = source.index("};", start)
+    names = re.findall(r'\{\s*"([^"]+)",', source[start:end])
+
+    if len(names) >= 65535:
+        sys.exit("entity-hash.py: Too many entities.")
+
+    disp, slots = build(names)
+
+    source = replace_table(source, "disp[%d] =" % NUM_BUCKETS, disp)
+    source = replace_table(source, "slots[%d] =" % NUM_SLOTS, slots)
+
+    with open(filename, "w", encoding="utf-8") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
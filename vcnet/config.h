@@ -97,6 +97,52 @@
 /* #undef HAVE_STRLCPY */
 
 
+/*
+ * Do we have memory-mapped file support?
+ */
+
+/* #undef HAVE_MMAP */
+
+
+/*
+ * Do we have C11 atomics?
+ */
+
+/* #undef HAVE_STDATOMIC_H */
+
+
+/*
+ * Do we have SSE2/AVX2 intrinsics and run-time CPU detection?
+ */
+
+/* #undef HAVE_X86_SIMD */
+
+
+/*
+ * Keep reference counts and user data in a side table to make nodes smaller?
+ */
+
+/* #undef MXML_COMPACT_NODES */
+
+
+/*
+ * Do we have zlib and/or Zstandard for compressed files?
+ */
+
+/* #undef HAVE_LIBZ */
+/* #undef HAVE_LIBZSTD */
+
+
+/*
+ * Do we have io_uring, POSIX AIO, and/or posix_fadvise for reading batches
+ * of files?
+ */
+
+/* #undef HAVE_LIBURING */
+/* #undef HAVE_AIO_H */
+/* #undef HAVE_POSIX_FADVISE */
+
+
 /*
  * Do we have threading support?
  */
@@ -108,11 +154,6 @@
  * Define prototypes for string functions as needed...
  */
 
-#  ifndef HAVE_STRDUP
-extern char	*_mxml_strdup(const char *);
-#    define strdup _mxml_strdup
-#  endif /* !HAVE_STRDUP */
-
 #  ifndef HAVE_STRLCAT
 extern size_t	_mxml_strlcat(char *, const char *, size_t);
 #    define strlcat _mxml_strlcat
@@ -123,7 +164,11 @@ extern size_t	_mxml_strlcpy(char *, const char *, size_t);
 #    define strlcpy _mxml_strlcpy
 #  endif /* !HAVE_STRLCPY */
 
+extern char	*_mxml_dtoa(double, char *, size_t);
 extern char	*_mxml_strdupf(const char *, ...);
+extern unsigned	_mxml_strhash(const char *);
+extern double	_mxml_strtod(const char *, char **);
+extern long long _mxml_strtoll(const char *, char **);
 extern char	*_mxml_vstrdupf(const char *, va_list);
 
 #  ifndef HAVE_SNPRINTF
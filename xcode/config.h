@@ -59,6 +59,52 @@
 #define HAVE_STRLCPY 1
 
 
+/*
+ * Do we have memory-mapped file support?
+ */
+
+#define HAVE_MMAP 1
+
+
+/*
+ * Do we have C11 atomics?
+ */
+
+#define HAVE_STDATOMIC_H 1
+
+
+/*
+ * Do we have SSE2/AVX2 intrinsics and run-time CPU detection?
+ */
+
+/* #undef HAVE_X86_SIMD */
+
+
+/*
+ * Keep reference counts and user data in a side table to make nodes smaller?
+ */
+
+/* #undef MXML_COMPACT_NODES */
+
+
+/*
+ * Do we have zlib and/or Zstandard for compressed files?
+ */
+
+/* #undef HAVE_LIBZ */
+/* #undef HAVE_LIBZSTD */
+
+
+/*
+ * Do we have io_uring, POSIX AIO, and/or posix_fadvise for reading batches
+ * of files?
+ */
+
+/* #undef HAVE_LIBURING */
+/* #undef HAVE_AIO_H */
+/* #undef HAVE_POSIX_FADVISE */
+
+
 /*
  * Do we have threading support?
  */
@@ -70,5 +116,9 @@
  * Define prototypes for string functions as needed...
  */
 
+extern char	*_mxml_dtoa(double, char *, size_t);
 extern char	*_mxml_strdupf(const char *, ...);
+extern unsigned	_mxml_strhash(const char *);
+extern double	_mxml_strtod(const char *, char **);
+extern long long _mxml_strtoll(const char *, char **);
 extern char	*_mxml_vstrdupf(const char *, va_list);